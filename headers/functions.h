@@ -53,7 +53,31 @@ void print_matrix(double matrix[4][4]);
 void print_transformations(const triobj* sel_ptr);
 void print_camera_data(const Camera* camera);
 void print_scene_mask(const int* scene_mask);
-void print_vector(Vector3* vector);
+void print_vector(const Vector3* vector);
+void print_frame_timing(void);
+
+/***********************************************************************
+ *                                                                     *
+ *                     MEDICIÓN DE TIEMPOS (PROFILING)                 *
+ *                                                                     *
+ ***********************************************************************/
+
+int frame_timing_percentiles(EtapaPipeline etapa, double* p50_ms, double* p95_ms, double* p99_ms);
+int frame_timing_percentiles_frame(double* p50_ms, double* p95_ms, double* p99_ms);
+double frame_timing_media_triangulos(EtapaPipeline etapa);
+double frame_timing_sobrecoste_ms(EtapaPipeline etapa);
+const char* frame_timing_nombre_etapa(EtapaPipeline etapa);
+void frame_timing_reset(void);
+
+/***********************************************************************
+ *                                                                     *
+ *                          TRAZAS ASÍNCRONAS                          *
+ *                                                                     *
+ ***********************************************************************/
+
+int trace_iniciar(FILE* texto, const char* ruta_json);
+void trace_detener(void);
+unsigned long long trace_eventos_perdidos(void);
 
 /***********************************************************************
  *                                                                     *
@@ -74,6 +98,8 @@ void dibujar_ejes();
 void dibujar_malla(float grid_size);
 void dibujar_ejes_objeto(triobj *obj);
 void draw_vector(Triangulo* triangulo, Vector3 normal_vector);
+void encolar_vector_normal(Triangulo* triangulo, Vector3 normal_vector);
+void dibujar_vectores_normales(void);
 
 /***********************************************************************
  *                                                                     *
@@ -85,10 +111,13 @@ void set_view_matrix(Camera* cam);
 void copy_camera(Camera* src, Camera* dest);
 void update_camera(Camera* cam, Vector3 eye_position, Vector3 look_at, Vector3 up_vector);
 void camera_pipeline(Camera* main_camera, unsigned int scene_status_mask, Triangulo* triangulo_procesado, Triangulo* triangulo, double matriz_transformacion[16]);
+void camera_pipeline_mundo(Camera* main_camera, unsigned int scene_status_mask, Triangulo* triangulo_procesado, const Triangulo* triangulo_mundo);
 void swap_camera(unsigned int scene_status_mask, triobj* sel_ptr, Camera* main_camera, Camera* secondary_camera);
 void update_camera_position(Camera *main_camera);
 void update_camera_vectors(Camera* camera, Vector3 look_at);
 void update_camera_vectors_from_view_matrix(Camera* camera);
+void set_perspective_projection_matrix(double pm[4][4], double near, double far, double right, double left, double top, double bottom);
+void set_orthographic_projection_matrix(double pm[4][4], double near, double far, double right, double left, double top, double bottom);
 
 /***********************************************************************
  *                                                                     *
@@ -102,4 +131,267 @@ void traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_stat
 void traslacion_orbita(char eje, int dir, Camera* camera, triobj* sel_ptr);
 void transformar(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr);
 
+/***********************************************************************
+ *                                                                     *
+ *                         RASTERIZADO POR SOFTWARE                    *
+ *                                                                     *
+ ***********************************************************************/
+
+int preparar_gradientes(const Triangulo* t, GradientesTriangulo* g);
+void interpolar_span(const GradientesTriangulo* g, int y, int x_inicio, int x_fin, float* u, float* v, float* z);
+Framebuffer* crear_framebuffer(int ancho, int alto);
+void liberar_framebuffer(Framebuffer* fb);
+void limpiar_framebuffer(Framebuffer* fb, unsigned char r, unsigned char g, unsigned char b);
+void limpiar_rectangulo(Framebuffer* fb, int x0, int y0, int x1, int y1, unsigned char r, unsigned char g,
+                        unsigned char b);
+void framebuffer_recorte(Framebuffer* fb, int x0, int y0, int x1, int y1);
+long rasterizar_triangulo(Framebuffer* fb, const Triangulo* triangulo, const Textura* tex, unsigned int scene_status_mask);
+int guardar_ppm(const char* ruta, const unsigned char* rgb, int ancho, int alto);
+int guardar_framebuffer_ppm(const Framebuffer* fb, const char* ruta);
+
+/***********************************************************************
+ *                                                                     *
+ *                               TEXTURAS                              *
+ *                                                                     *
+ ***********************************************************************/
+
+int crear_textura_rgb(const unsigned char* rgb, int ancho, int alto, Textura* tex);
+int cargar_textura_ppm(const char* ruta, Textura* tex);
+void liberar_textura(Textura* tex);
+int textura_nivel_span(const GradientesTriangulo* g, const Textura* tex, float x, float y);
+void muestrear_span(const Textura* tex, int nivel, const float* u, const float* v, int n, unsigned int* rgba);
+
+/***********************************************************************
+ *                                                                     *
+ *                          NORMALES DE VÉRTICE                        *
+ *                                                                     *
+ ***********************************************************************/
+
+int calcular_normales_vertice(triobj* obj, float angulo_pliegue);
+const Vector3* normales_mundo(triobj* obj);
+const Triangulo* triangulos_mundo(triobj* obj);
+void descartar_triangulos_mundo(triobj* obj);
+
+/***********************************************************************
+ *                                                                     *
+ *                           MALLAS COMPRIMIDAS                        *
+ *                                                                     *
+ ***********************************************************************/
+
+int comprimir_triobj(triobj* obj);
+void matriz_descuantizada(const MallaCompacta* c, const double m[16], double resultado[16]);
+size_t memoria_triobj(const triobj* obj);
+
+/***********************************************************************
+ *                                                                     *
+ *                        OPTIMIZACIÓN DE MALLAS                       *
+ *                                                                     *
+ ***********************************************************************/
+
+float acmr_indices(const int* indices, int num_triangulos, int num_vertices);
+int optimizar_triobj(triobj* obj, EstadisticasOptimizacion* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                           NIVELES DE DETALLE                        *
+ *                                                                     *
+ ***********************************************************************/
+
+int generar_lods(triobj* obj, int niveles);
+void liberar_lods(triobj* obj);
+int seleccionar_lod(triobj* obj, const Camera* camera, unsigned int scene_status_mask);
+
+/***********************************************************************
+ *                                                                     *
+ *                    MALLAS POR TROZOS (FUERA DE MEMORIA)             *
+ *                                                                     *
+ ***********************************************************************/
+
+int escribir_malla_trozos(const char* ruta, const triobj* obj, int triangulos_por_trozo);
+MallaTrozos* abrir_malla_trozos(const char* ruta, size_t presupuesto);
+void cerrar_malla_trozos(MallaTrozos* malla);
+void malla_trozos_presupuesto(MallaTrozos* malla, size_t presupuesto);
+double* malla_trozos_matriz(MallaTrozos* malla);
+int actualizar_trozos(MallaTrozos* malla, const Camera* camera, unsigned int scene_status_mask);
+long procesar_malla_trozos(MallaTrozos* malla, Camera* camera, unsigned int scene_status_mask);
+void malla_trozos_estadisticas(const MallaTrozos* malla, EstadisticasTrozos* stats);
+int cargar_triangulos_trozos(char* ruta, int* num_triangulos, Triangulo** triangulos);
+
+/***********************************************************************
+ *                                                                     *
+ *                     ORDENACIÓN POR PROFUNDIDAD                      *
+ *                                                                     *
+ ***********************************************************************/
+
+OrdenProfundidad* crear_orden_profundidad(int hilos);
+void liberar_orden_profundidad(OrdenProfundidad* orden);
+float profundidad_triangulo(const Triangulo* procesado, unsigned int scene_status_mask);
+const int* ordenar_por_profundidad(OrdenProfundidad* orden, const float* profundidad, int n, int coherente);
+void orden_profundidad_estadisticas(const OrdenProfundidad* orden, EstadisticasOrden* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                        CONTEXTO GL SIN VENTANA                      *
+ *                                                                     *
+ ***********************************************************************/
+
+ContextoOffscreen* crear_contexto_offscreen(int ancho, int alto);
+void destruir_contexto_offscreen(ContextoOffscreen* ctx);
+const char* contexto_offscreen_backend(const ContextoOffscreen* ctx);
+int leer_pixeles_offscreen(ContextoOffscreen* ctx, unsigned char* rgb);
+
+/***********************************************************************
+ *                                                                     *
+ *                          CARGA DE ESCENAS                           *
+ *                                                                     *
+ ***********************************************************************/
+
+triobj* cargar_escena(char** rutas, int num_rutas, CargadorTriangulos cargador, int hilos,
+                      EstadisticasCargaEscena* stats);
+triobj* publicar_escena(_Atomic(triobj*)* escena, triobj* lista);
+
+/***********************************************************************
+ *                                                                     *
+ *                              ILUMINACIÓN                            *
+ *                                                                     *
+ ***********************************************************************/
+
+void luces_iniciar(Luces* luces, Color ambiente);
+int anadir_luz_direccional(Luces* luces, Vector3 direccion, Color color);
+int anadir_luz_posicional(Luces* luces, Vector3 posicion, Color color, float rango);
+int anadir_luz_foco(Luces* luces, Vector3 posicion, Vector3 direccion, Color color, float rango,
+                    float angulo_interior, float angulo_exterior);
+Sombreador* crear_sombreador(void);
+void liberar_sombreador(Sombreador* s);
+int sombrear_objeto(Sombreador* s, const Luces* luces, triobj* obj, ModoSombreado modo, Color* colores);
+
+/***********************************************************************
+ *                                                                     *
+ *                    GRABACIÓN Y REPRODUCCIÓN DE SESIONES             *
+ *                                                                     *
+ ***********************************************************************/
+
+int grabacion_iniciar(const char* ruta, triobj* lista);
+long grabacion_detener(void);
+long cargar_grabacion(const char* ruta, EventoEntrada** eventos);
+int reproducir_sesion(const char* ruta, EscenaReplay* escena, unsigned int scene_status_mask, int ritmo_grabado, EstadisticasReplay* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                             BENCHMARKS                              *
+ *                                                                     *
+ ***********************************************************************/
+
+double bench_now_ns(void);
+unsigned int bench_random_u32(unsigned int* estado);
+float bench_random_float(unsigned int* estado, float min, float max);
+void bench_config_por_defecto(BenchConfig* config);
+int bench_parse_args(BenchConfig* config, int argc, char** argv);
+BenchResultado* bench_ejecutar(BenchConfig* config, const char* nombre, BenchKernel kernel, void* ctx, long elementos);
+int bench_informe(BenchConfig* config);
+int bench_operaciones(BenchConfig* config);
+int bench_escena(BenchConfig* config);
+int bench_replay(BenchConfig* config);
+int bench_raster(BenchConfig* config);
+int bench_luces(BenchConfig* config);
+int bench_trozos(BenchConfig* config);
+int bench_carga(BenchConfig* config);
+int bench_gl(BenchConfig* config);
+int bench_orden(BenchConfig* config);
+int bench_lotes(BenchConfig* config);
+int bench_captura(BenchConfig* config);
+
+/***********************************************************************
+ *                                                                     *
+ *                      GENERACIÓN PROCEDURAL DE MALLAS                *
+ *                                                                     *
+ ***********************************************************************/
+
+triobj* crear_triobj(Triangulo* triangulos, int num_triangulos);
+void liberar_triobj(triobj* obj);
+triobj* generar_cilindro(float radio, float altura, long num_triangulos);
+triobj* generar_esfera(float radio, long num_triangulos);
+triobj* generar_malla_teselada(float ancho, float alto, long num_triangulos);
+triobj* generar_escena_prueba(long num_triangulos);
+void liberar_escena(triobj* lista);
+
+/***********************************************************************
+ *                                                                     *
+ *                          PIPELINE DE ESCENA                         *
+ *                                                                     *
+ ***********************************************************************/
+
+long procesar_objeto(Camera* camera, unsigned int scene_status_mask, triobj* obj, Framebuffer* fb, const Textura* tex);
+long procesar_escena(Camera* camera, unsigned int scene_status_mask, triobj* lista);
+
+/***********************************************************************
+ *                                                                     *
+ *                  OCLUSIÓN CON PIRÁMIDE DE PROFUNDIDAD               *
+ *                                                                     *
+ ***********************************************************************/
+
+void matriz_proyeccion_vista(const Camera* camera, unsigned int scene_status_mask, double pv[4][4]);
+int objeto_en_pantalla(const Framebuffer* fb, const double pv[4][4], unsigned int scene_status_mask, triobj* obj,
+                       ObjetoPantalla* o);
+int construir_piramide_profundidad(Framebuffer* fb);
+int rectangulo_ocluido(const Framebuffer* fb, float x0, float y0, float x1, float y1, float z_min);
+long rasterizar_escena(Framebuffer* fb, Camera* camera, unsigned int scene_status_mask, triobj* lista,
+                       const Textura* tex, EstadisticasOclusion* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                            VARIAS VISTAS                            *
+ *                                                                     *
+ ***********************************************************************/
+
+long rasterizar_vistas(Vista* vistas, int num_vistas, unsigned int scene_status_mask, triobj* lista, const Textura* tex);
+long rasterizar_vistas_preparadas(Vista* vistas, int num_vistas, unsigned int scene_status_mask, triobj* lista,
+                                  const Textura* tex);
+
+/***********************************************************************
+ *                                                                     *
+ *                           RENDER POR LOTES                          *
+ *                                                                     *
+ ***********************************************************************/
+
+int cargar_poses(const char* ruta, const char* prefijo_salida, PoseRender** poses);
+int renderizar_lote(const PoseRender* poses, int num_poses, triobj* lista, const Textura* tex, int ancho, int alto,
+                    int hilos, EstadisticasLote* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                          CAPTURA DE FRAMES                          *
+ *                                                                     *
+ ***********************************************************************/
+
+CapturaFrames* crear_captura(const char* ruta, FormatoCaptura formato, int ancho, int alto, int buffers,
+                             PoliticaCaptura politica);
+int capturar_frame(CapturaFrames* captura, const Framebuffer* fb);
+void captura_estadisticas(CapturaFrames* captura, EstadisticasCaptura* stats);
+int cerrar_captura(CapturaFrames* captura, EstadisticasCaptura* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                          REDIBUJADO PARCIAL                         *
+ *                                                                     *
+ ***********************************************************************/
+
+Redibujado* crear_redibujado(void);
+void liberar_redibujado(Redibujado* r);
+void invalidar_redibujado(Redibujado* r);
+TipoRedibujo redibujar_escena(Redibujado* r, Framebuffer* fb, Camera* camera, unsigned int scene_status_mask,
+                              triobj* lista, const Textura* tex);
+void redibujado_estadisticas(const Redibujado* r, EstadisticasRedibujado* stats);
+
+/***********************************************************************
+ *                                                                     *
+ *                          CONOS DE NORMALES                          *
+ *                                                                     *
+ ***********************************************************************/
+
+const unsigned long long* visibilidad_conos(triobj* obj, const Camera* camera, unsigned int scene_status_mask);
+void liberar_conos(triobj* obj);
+size_t memoria_conos(const triobj* obj);
+void conos_estadisticas(const triobj* lista, EstadisticasConos* stats);
+
 #endif FUNCTIONS_H
\ No newline at end of file
@@ -1,12 +1,17 @@
 #ifndef SHARED_DEFINES_H
 #define SHARED_DEFINES_H
 
+#ifdef __APPLE__
 #include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <math.h>
 #include <string.h>
+#include <stdatomic.h>
 
 /***********************************************************************
  * Este archivo de cabecera, define una serie de estructuras de datos,
@@ -57,6 +62,21 @@
 #define NORMAL_VECTORS          (1 << 16)  // 0b000000010000000000000000
 #define BACK_CULLING            (1 << 17)
 
+// Medición de tiempos por etapa de la pipeline (requiere compilar con -DPROFILING)
+#define FRAME_TIMING            (1 << 18)
+
+// Elegir cada frame el nivel de detalle de cada objeto por su tamaño en pantalla
+#define NIVEL_DETALLE           (1 << 19)
+
+// Descartar en el rasterizado los objetos tapados, con la pirámide de profundidad
+#define OCLUSION_HIZ            (1 << 20)
+
+// Guardar los vértices de cada objeto en espacio mundo y aplicar por frame sólo vista y proyección
+#define VERTICES_MUNDO          (1 << 21)
+
+// Back culling por grupos de triángulos con conos de normales, reaprovechando el del frame anterior
+#define CONOS_NORMALES          (1 << 22)
+
 #define EJE_LIMPIAR_MASK_EJES (EJE_X_POSITIVO | EJE_X_NEGATIVO | EJE_Y_POSITIVO | EJE_Y_NEGATIVO | EJE_Z_POSITIVO | EJE_Z_NEGATIVO)
 #define EJE_LIMPIAR_MASK_TRANSFORMACION (MODO_ESCALADO | MODO_ROTACION | MODO_TRASLACION)
 #define EJE_LIMPIAR_MASK_CAMARA (MODO_CAMARA | MODO_OBJETO | CAMARA_ANALISIS | CAMARA_VUELO)
@@ -83,16 +103,61 @@ typedef struct Triangulo
     Punto p1,p2,p3;
 } Triangulo;
 
+// Un nivel de detalle simplificado de un objeto.
+typedef struct NivelDetalle
+{
+    Triangulo *triptr;
+    int num_triangles;
+    float error;  // Error geométrico aproximado, en unidades de objeto
+} NivelDetalle;
+
 typedef struct triobj
 {
     Triangulo *triptr;
     int num_triangles;
     mlist *mptr;
     struct triobj *hptr;
+
+    // Caja en coordenadas de objeto, calculada al crear el objeto
+    float caja_min[3], caja_max[3];
+
+    // Vértice soldado de cada esquina (3 por triángulo, NULL si no se ha
+    // calculado): las esquinas con la misma posición comparten índice.
+    int *indices;
+    int num_vertices;
+
+    // Normales suavizadas, 3 por triángulo en el orden de triptr (NULL si no se han calculado)
+    struct Vector3 *normales;
+    // Las mismas en espacio mundo, recalculadas sólo cuando cambia la matriz del objeto
+    struct Vector3 *normales_mundo;
+    const mlist *normales_mptr;
+    double normales_m[16];
+
+    // Triángulos en espacio mundo (NULL si no se han pedido), recalculados
+    // sólo cuando cambia la matriz del objeto, como las normales, y la
+    // normal de cada cara en mundo (sin normalizar) para el back culling
+    Triangulo *triangulos_mundo;
+    struct Vector3 *caras_mundo;
+    const mlist *mundo_mptr;
+    double mundo_m[16];
+
+    // Formato comprimido opcional (NULL si no se ha comprimido). Al
+    // comprimir se liberan triptr y normales, que pasan a ser NULL.
+    struct MallaCompacta *compacta;
+
+    // Niveles de detalle simplificados, de más a menos triángulos (NULL si
+    // no se han generado). El nivel 0 es el propio objeto.
+    NivelDetalle *lods;
+    int num_lods;
+    int lod_actual;  // Nivel elegido en el último frame
+
+    // Conos de normales por grupo de triángulos y visibilidad del último
+    // frame, para CONOS_NORMALES (NULL si no se han pedido)
+    struct ConosNormales *conos;
 } triobj;
 
 // Estructura para un vector de tres componentes.
-typedef struct {
+typedef struct Vector3 {
     float x;
     float y;
     float z;
@@ -132,4 +197,664 @@ typedef struct {
 
 #define PI 3.14159265358979323846
 
+extern const ProjectionConst ProjectionData;
+
+/***********************************************************************
+ * Medición de tiempos por etapa (frame timing). Con -DPROFILING las macros
+ * toman marcas de reloj monotónico alrededor de cada etapa, siempre que
+ * el bit FRAME_TIMING esté activo en la máscara de escena. Sin PROFILING
+ * las macros desaparecen y no queda rastro en el código caliente. Las
+ * etapas por triángulo se miden por muestreo, y lo que cuestan las
+ * propias marcas se descuenta y se informa aparte (ver frame_timing.c).
+ * Sólo mide el hilo que abre el frame; en los demás las marcas no hacen
+ * nada.
+ ***********************************************************************/
+
+typedef enum {
+    ETAPA_MODELO = 0,
+    ETAPA_VISTA,
+    ETAPA_PROYECCION,
+    ETAPA_CULLING,
+    ETAPA_CLIPPING,
+    ETAPA_RASTER,
+    ETAPA_SOMBREADO,
+    NUM_ETAPAS
+} EtapaPipeline;
+
+// Número de frames que se guardan para calcular los percentiles.
+#define FRAME_TIMING_HISTORIAL 1024
+// De cada cuántas llamadas se mide una en las etapas por triángulo.
+#define FRAME_TIMING_MUESTREO 64
+
+#ifdef PROFILING
+extern _Thread_local int frame_timing_activo;
+unsigned long long frame_timing_now_ns(void);
+void frame_timing_registrar(EtapaPipeline etapa, unsigned long long ns, unsigned int triangulos, unsigned int peso);
+void frame_timing_inicio_frame(unsigned int scene_status_mask);
+void frame_timing_fin_frame(void);
+
+// Abre una marca de tiempo; 0 si la medición está desactivada en runtime.
+#define TIMING_INICIO(marca) \
+    const unsigned int marca##_peso = 1; \
+    unsigned long long marca = frame_timing_activo ? frame_timing_now_ns() : 0
+// Igual, para las etapas por triángulo: desde cada punto del código sólo
+// se abre una de cada FRAME_TIMING_MUESTREO, que cuenta por todas.
+#define TIMING_INICIO_MUESTREO(marca) \
+    static _Thread_local unsigned int marca##_llamadas; \
+    const unsigned int marca##_peso = FRAME_TIMING_MUESTREO; \
+    unsigned long long marca = \
+        frame_timing_activo && marca##_llamadas++ % FRAME_TIMING_MUESTREO == 0 ? frame_timing_now_ns() : 0
+// Cierra la etapa y reutiliza la marca como inicio de la siguiente.
+#define TIMING_ETAPA(etapa, marca, triangulos) \
+    do { \
+        if (marca) { \
+            unsigned long long _ahora = frame_timing_now_ns(); \
+            frame_timing_registrar((etapa), _ahora - (marca), (triangulos), marca##_peso); \
+            (marca) = _ahora; \
+        } \
+    } while (0)
+#define FRAME_TIMING_INICIO(scene_status_mask) frame_timing_inicio_frame(scene_status_mask)
+#define FRAME_TIMING_FIN() frame_timing_fin_frame()
+#else
+#define TIMING_INICIO(marca)
+#define TIMING_INICIO_MUESTREO(marca)
+#define TIMING_ETAPA(etapa, marca, triangulos)
+#define FRAME_TIMING_INICIO(scene_status_mask)
+#define FRAME_TIMING_FIN()
+#endif
+
+/***********************************************************************
+ * Trazas asíncronas. Los eventos son binarios y de tamaño fijo; el hilo
+ * que los emite sólo los copia en su buffer circular y un hilo de fondo
+ * se encarga de formatearlos. Si el registro no está arrancado, cada
+ * macro cuesta una carga y un salto.
+ ***********************************************************************/
+
+#define TRACE_MAX_VALORES 5
+
+#define TRACE_FASE_INICIO   'B'
+#define TRACE_FASE_FIN      'E'
+#define TRACE_FASE_INSTANTE 'i'
+#define TRACE_FASE_CONTADOR 'C'
+
+typedef struct {
+    unsigned long long ticks;
+    const char* nombre;  // Siempre una cadena estática, no se copia
+    char fase;
+    unsigned char num_valores;
+    double valores[TRACE_MAX_VALORES];
+} TraceEvento;
+
+extern _Atomic int trace_activo_flag;
+void trace_emitir(char fase, const char* nombre, int num_valores, const double* valores);
+
+#define TRACE_ACTIVO() atomic_load_explicit(&trace_activo_flag, memory_order_relaxed)
+
+#define TRACE_INSTANTE(nombre, ...) \
+    do { \
+        if (TRACE_ACTIVO()) { \
+            const double _valores[] = {__VA_ARGS__}; \
+            trace_emitir(TRACE_FASE_INSTANTE, (nombre), sizeof(_valores) / sizeof(double), _valores); \
+        } \
+    } while (0)
+#define TRACE_CONTADOR(nombre, valor) \
+    do { \
+        if (TRACE_ACTIVO()) { \
+            const double _valor = (valor); \
+            trace_emitir(TRACE_FASE_CONTADOR, (nombre), 1, &_valor); \
+        } \
+    } while (0)
+#define TRACE_INICIO(nombre) \
+    do { if (TRACE_ACTIVO()) trace_emitir(TRACE_FASE_INICIO, (nombre), 0, NULL); } while (0)
+#define TRACE_FIN(nombre) \
+    do { if (TRACE_ACTIVO()) trace_emitir(TRACE_FASE_FIN, (nombre), 0, NULL); } while (0)
+
+/***********************************************************************
+ * Rasterizado por software. Framebuffer RGB con profundidad y gradientes
+ * por triángulo para interpolar u/w, v/w y 1/w (corrección de perspectiva).
+ ***********************************************************************/
+
+// Píxeles entre recíprocos exactos al recorrer un span.
+#define SPAN_SUBDIVISION 16
+
+// Niveles de la pirámide de profundidad (de sobra para 65536 píxeles de lado).
+#define PIRAMIDE_NIVELES_MAX 16
+
+typedef struct {
+    int ancho, alto;
+    unsigned char* rgb;      // Filas de arriba a abajo, 3 bytes por píxel
+    float* profundidad;
+    int clip_x0, clip_y0, clip_x1, clip_y1;
+
+    // Arrays de trabajo de un span, del ancho del framebuffer
+    float* span_u;
+    float* span_v;
+    float* span_z;
+    int* span_x;             // Píxeles del span que pasan el test de profundidad
+    unsigned int* span_rgba; // Color muestreado de esos píxeles
+
+    // Pirámide de profundidad (máximo de cada bloque de 2x2 del nivel
+    // anterior; el nivel 0 es la mitad del framebuffer). Se reserva la
+    // primera vez que se construye.
+    float* piramide[PIRAMIDE_NIVELES_MAX];
+    int piramide_ancho[PIRAMIDE_NIVELES_MAX], piramide_alto[PIRAMIDE_NIVELES_MAX];
+    int piramide_niveles;
+} Framebuffer;
+
+/***********************************************************************
+ * Oclusión. Los objetos que ocupan al menos OCLUSION_AREA_OCLUSOR de la
+ * pantalla se dibujan primero (como mucho OCLUSION_MAX_OCLUSORES), se
+ * construye la pirámide con su profundidad y el resto se prueba contra
+ * ella antes de transformar un solo triángulo.
+ ***********************************************************************/
+
+#define OCLUSION_AREA_OCLUSOR  0.05f
+#define OCLUSION_MAX_OCLUSORES 8
+
+typedef struct {
+    int objetos;      // En la lista
+    int fuera;        // Fuera del frustum
+    int oclusores;    // Dibujados primero para construir la pirámide
+    int ocluidos;     // Descartados por la pirámide
+    int visibles;     // Dibujados, oclusores incluidos
+    long triangulos;  // Que han llegado al rasterizado
+} EstadisticasOclusion;
+
+typedef struct {
+    triobj* obj;
+    float x0, y0, x1, y1;  // Rectángulo en píxeles
+    float z_min;           // Profundidad más cercana, como la del framebuffer
+    float area;            // Fracción de la pantalla que cubre el rectángulo
+} ObjetoPantalla;
+
+/***********************************************************************
+ * Varias vistas en el mismo frame (pantalla partida, cámaras fijas de
+ * vigilancia...). Cada vista tiene su cámara y su framebuffer; lo que no
+ * depende de la cámara se calcula una vez para todas.
+ ***********************************************************************/
+
+#define VISTAS_MAX 16
+
+typedef struct {
+    Camera* camera;
+    Framebuffer* fb;
+    long triangulos;  // Salida: triángulos rasterizados en esta vista
+    int objetos;      // Salida: objetos dentro de su frustum
+} Vista;
+
+/***********************************************************************
+ * Render por lotes: muchas poses de cámara de la misma escena, cada una
+ * a su PPM, repartidas entre hilos (batch_render.c).
+ ***********************************************************************/
+
+#define LOTE_RUTA_MAX 256
+
+typedef struct {
+    Vector3 ojo, mira, arriba;   // Como en update_camera()
+    unsigned int proyeccion;     // PROJECTION_PERSPECTIVE o PROJECTION_ORTOGRAPHIC
+    char ruta[LOTE_RUTA_MAX];    // PPM de salida; vacía para no escribir
+} PoseRender;
+
+typedef struct {
+    int imagenes;        // Renderizadas
+    int fallidas;        // Sin poder escribir su PPM
+    int hilos;
+    long triangulos;     // Rasterizados, sumando todas las poses
+    double total_ms;
+    double render_ms;    // Sumado sobre todos los hilos
+    double escritura_ms; // Ídem
+} EstadisticasLote;
+
+/***********************************************************************
+ * Captura de frames: copias del framebuffer en un pool de buffers que un
+ * hilo escribe a disco, como PPM por frame o en un único fichero crudo.
+ ***********************************************************************/
+
+#define CAPTURA_BUFFERS 8
+
+typedef enum {
+    CAPTURA_PPM,   // Un P6 por frame, <ruta>NNNNN.ppm
+    CAPTURA_CRUDA  // Todos los frames RGB seguidos en <ruta>, sin cabecera
+} FormatoCaptura;
+
+typedef enum {
+    CAPTURA_ESPERAR,   // Sin buffers libres, el render espera al disco
+    CAPTURA_DESCARTAR  // Sin buffers libres, el frame se pierde
+} PoliticaCaptura;
+
+typedef struct {
+    long encolados;      // Copiados a un buffer para escribir
+    long escritos;
+    long descartados;    // Sin buffer libre con CAPTURA_DESCARTAR
+    long fallidos;       // Error al escribir
+    int en_cola;         // Pendientes de escribir ahora mismo
+    int max_en_cola;
+    long esperas;        // Veces que el render ha esperado un buffer
+    double espera_ms;    // Tiempo total de esas esperas
+    double escritura_ms; // Tiempo del hilo escritor
+    long long bytes;
+} EstadisticasCaptura;
+
+typedef struct CapturaFrames CapturaFrames;
+
+/***********************************************************************
+ * Redibujado parcial: sin cambios no se redibuja nada y, si sólo se han
+ * movido algunos objetos, sólo los rectángulos de pantalla que ocupaban
+ * y ocupan (dirty_rects.c).
+ ***********************************************************************/
+
+#define REDIBUJO_MAX_RECTANGULOS 8
+#define REDIBUJO_FRACCION_COMPLETO 0.5f  // Más pantalla que esto sucia, se redibuja entera
+
+typedef enum {
+    REDIBUJO_NINGUNO,   // La imagen anterior sigue valiendo
+    REDIBUJO_PARCIAL,
+    REDIBUJO_COMPLETO
+} TipoRedibujo;
+
+typedef struct {
+    long frames;
+    long sin_cambios;
+    long parciales;
+    long completos;
+    int rectangulos;     // Del último redibujado parcial
+    long long pixeles;   // Redibujados en total (limpiados y rasterizados)
+} EstadisticasRedibujado;
+
+typedef struct Redibujado Redibujado;
+
+/***********************************************************************
+ * Conos de normales: el back culling se decide por grupos de triángulos
+ * consecutivos (un bit por triángulo, una palabra por grupo) y sólo se
+ * prueba cara a cara en los grupos de la silueta (normal_cones.c).
+ ***********************************************************************/
+
+#define CONOS_TRIANGULOS_GRUPO 64  // Bits de un unsigned long long
+
+typedef struct {
+    long long grupos;               // Grupos vistos, sumando todos los frames
+    long long atras;                // Descartados enteros
+    long long delante;              // Dibujados enteros sin probar las caras
+    long long mixtos;               // El cono cruza la dirección de la cámara
+    long long reutilizados;         // Mixtos con la prueba del frame anterior
+    long long triangulos_probados;  // Caras probadas una a una
+} EstadisticasConos;
+
+/***********************************************************************
+ * Texturas. Se convierten al cargarlas a RGBA8 en teselas de 4x4 texels
+ * (64 bytes, una línea de caché) y con su pirámide de mipmaps.
+ ***********************************************************************/
+
+#define TEXTURA_TESELA 4
+#define TEXTURA_MAX_NIVELES 16
+
+#define TEXTURA_RGBA(r, g, b, a) \
+    ((unsigned int)(r) | ((unsigned int)(g) << 8) | ((unsigned int)(b) << 16) | ((unsigned int)(a) << 24))
+#define TEXTURA_R(rgba) ((unsigned char)((rgba) & 0xFF))
+#define TEXTURA_G(rgba) ((unsigned char)(((rgba) >> 8) & 0xFF))
+#define TEXTURA_B(rgba) ((unsigned char)(((rgba) >> 16) & 0xFF))
+
+typedef struct {
+    int ancho, alto;
+    int teselas_x, teselas_y;
+    unsigned int* texels;    // Tesela a tesela, y dentro de cada una por filas
+} NivelTextura;
+
+// Como GL_NEAREST / GL_LINEAR y GL_REPEAT / GL_CLAMP_TO_EDGE. Los valores
+// a 0 son los de una textura recién creada.
+typedef enum {
+    TEXTURA_CERCANO = 0,
+    TEXTURA_BILINEAL
+} FiltroTextura;
+
+typedef enum {
+    TEXTURA_REPETIR = 0,
+    TEXTURA_LIMITAR
+} RepeticionTextura;
+
+typedef struct {
+    int niveles;
+    NivelTextura nivel[TEXTURA_MAX_NIVELES];
+    FiltroTextura filtro;
+    RepeticionTextura repeticion;
+} Textura;
+
+/**
+ * Posición del texel (x, y) dentro del array teselado de un nivel.
+ */
+static inline size_t textura_indice_texel(const NivelTextura* nivel, int x, int y) {
+    size_t tesela = (size_t)(y >> 2) * nivel->teselas_x + (size_t)(x >> 2);
+    return (tesela << 4) | (size_t)((y & 3) << 2) | (size_t)(x & 3);
+}
+
+static inline unsigned int textura_texel(const NivelTextura* nivel, int x, int y) {
+    return nivel->texels[textura_indice_texel(nivel, x, y)];
+}
+
+typedef struct {
+    float x0, y0;                      // Origen de los planos (primer vértice)
+    float uw0, vw0, iw0, z0;
+    float uw_dx, uw_dy;
+    float vw_dx, vw_dy;
+    float iw_dx, iw_dy;
+    float z_dx, z_dy;
+} GradientesTriangulo;
+
+/***********************************************************************
+ * Mallas comprimidas. Cada esquina ocupa 12 bytes en lugar de los 24 de
+ * Punto más los 12 de su normal: posición cuantizada a 16 bits dentro de
+ * la caja del objeto, u/v a 16 bits dentro de su rango y la normal en
+ * codificación octaédrica a 8+8 bits. La w no se guarda, sólo tiene
+ * sentido después de proyectar.
+ *
+ * La posición no se decodifica a coordenadas de objeto: la escala y el
+ * origen de la caja se meten en la matriz de modelo (matriz_descuantizada)
+ * y la pipeline transforma directamente los enteros.
+ ***********************************************************************/
+
+#define CUANTIZACION_MAX 65535.0f
+
+typedef struct {
+    unsigned short x, y, z;      // Posición: min + q * escala
+    unsigned short u, v;         // Textura: uv_min + q * uv_escala
+    unsigned char normal[2];     // Normal octaédrica
+} PuntoCompacto;
+
+typedef struct MallaCompacta {
+    PuntoCompacto* vertices;     // 3 por triángulo, en el orden que tenía triptr
+    float min[3], escala[3];
+    float uv_min[2], uv_escala[2];
+} MallaCompacta;
+
+/**
+ * Esquina comprimida como Punto: x, y, z siguen cuantizadas (hay que
+ * transformarlas con la matriz de matriz_descuantizada) y u, v decodificadas.
+ */
+static inline void punto_compacto(const MallaCompacta* c, const PuntoCompacto* p, Punto* salida) {
+    salida->x = (float)p->x;
+    salida->y = (float)p->y;
+    salida->z = (float)p->z;
+    salida->u = c->uv_min[0] + (float)p->u * c->uv_escala[0];
+    salida->v = c->uv_min[1] + (float)p->v * c->uv_escala[1];
+    salida->w = 1.0f;
+}
+
+/**
+ * Decodifica una normal octaédrica: el punto del octaedro |x|+|y|+|z| = 1,
+ * con la mitad z < 0 plegada sobre las esquinas del cuadrado, normalizado.
+ */
+static inline Vector3 normal_octaedrica(const unsigned char codigo[2]) {
+    float x = (float)codigo[0] * (2.0f / 255.0f) - 1.0f;
+    float y = (float)codigo[1] * (2.0f / 255.0f) - 1.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float inv = 1.0f / sqrtf(x * x + y * y + z * z);
+    Vector3 n = {x * inv, y * inv, z * inv};
+    return n;
+}
+
+/***********************************************************************
+ * Mallas por trozos, para modelos que no caben en memoria. El fichero
+ * lleva una tabla de trozos (cada uno con su caja) y los triángulos de
+ * cada trozo alineados a página, de forma que se puedan mapear con mmap
+ * y traer o soltar trozo a trozo según lo que ve la cámara.
+ ***********************************************************************/
+
+#define TROZOS_MAGIA 0x5A52544Du            // "MTRZ"
+#define TROZOS_VERSION 1
+#define TROZOS_ALINEACION 16384             // Múltiplo de la página en Linux y en macOS arm64
+#define TROZOS_TRIANGULOS_POR_DEFECTO 16384 // Algo más de 1 MB por trozo
+
+typedef struct {
+    unsigned int magia;
+    unsigned int version;
+    unsigned int num_trozos;
+    unsigned int reservado;
+} CabeceraFicheroTrozos;
+
+typedef struct {
+    long long desplazamiento;  // Desde el inicio del fichero, múltiplo de TROZOS_ALINEACION
+    int num_triangulos;
+    int reservado;
+    float min[3], max[3];      // Caja en coordenadas de objeto
+} CabeceraTrozo;
+
+typedef struct {
+    long trozos, visibles;
+    long visibles_sin_cargar;         // Visibles que este frame no se han podido dibujar
+    long residentes, pendientes;      // Pendientes: pedidos al hilo de carga y aún sin traer
+    size_t bytes_residentes, presupuesto;
+    long cargas, expulsiones;
+    long sin_sitio;                   // Trozos visibles que no cupieron en el presupuesto
+    double latencia_media_ms, latencia_max_ms;  // Desde que se pide un trozo hasta que está en memoria
+} EstadisticasTrozos;
+
+typedef struct MallaTrozos MallaTrozos;
+
+/***********************************************************************
+ * Carga de escenas en paralelo. El cargador tiene la firma de
+ * cargar_triangulos(): reserva y devuelve los triángulos de un fichero,
+ * con un valor negativo si falla.
+ ***********************************************************************/
+
+typedef int (*CargadorTriangulos)(char* ruta, int* num_triangulos, Triangulo** triangulos);
+
+typedef struct {
+    int ficheros, fallidos, hilos;
+    long triangulos;
+    double total_ms;        // Lo que espera el arranque, de principio a fin
+    double lectura_ms;      // Suma por fichero de lo que tarda el cargador
+    double postproceso_ms;  // Suma por fichero de crear_triobj, optimizar_triobj y generar_lods
+    float acmr_antes;       // Fallos de caché de vértices por triángulo, en el orden del fichero
+    float acmr_despues;     // Lo mismo tras optimizar_triobj
+} EstadisticasCargaEscena;
+
+/***********************************************************************
+ * Orden por profundidad (pintor y transparencias). Radix LSD de 4 pasadas
+ * de 8 bits sobre la profundidad en vista, repartido entre hilos. Si la
+ * cámara apenas se ha movido, se parte del orden del frame anterior y se
+ * arregla por inserción, con un límite de ORDEN_DESPLAZAMIENTOS_MAX
+ * desplazamientos por triángulo antes de rendirse y volver al radix. Si
+ * más de ORDEN_DESORDEN_MAX de las parejas vecinas están desordenadas,
+ * se va directo al radix.
+ ***********************************************************************/
+
+#define ORDEN_CUBETAS 256
+#define ORDEN_MAX_HILOS 64
+#define ORDEN_MIN_POR_HILO 65536
+#define ORDEN_DESPLAZAMIENTOS_MAX 4
+#define ORDEN_DESORDEN_MAX 0.02f
+
+typedef struct {
+    int elementos;
+    int hilos;              // Hilos usados en el radix (0 si se arregló por inserción)
+    int pasadas;            // Pasadas de radix hechas
+    int pasadas_saltadas;   // Pasadas en las que todos tenían el mismo dígito
+    int por_insercion;      // 1 si bastó con arreglar el orden anterior
+    long desplazamientos;   // Movimientos de la inserción (aunque luego se abandonara)
+} EstadisticasOrden;
+
+typedef struct OrdenProfundidad OrdenProfundidad;
+
+/***********************************************************************
+ * Contexto GL sin ventana (OSMesa o EGL sin superficie), para lanzar el
+ * camino de OpenGL en los nodos de render y en CI sin GLUT ni pantalla.
+ ***********************************************************************/
+
+#define OFFSCREEN_ANCHO 800
+#define OFFSCREEN_ALTO  600
+
+typedef struct ContextoOffscreen ContextoOffscreen;
+
+/***********************************************************************
+ * Niveles de detalle. Cada nivel tiene LOD_REDUCCION veces los triángulos
+ * del anterior. Se elige por el radio de la esfera envolvente proyectado
+ * (1 = media pantalla): hasta LOD_TAMANO_COMPLETO se usa el objeto
+ * completo y se baja un nivel cada vez que el tamaño se reduce a la
+ * mitad. Para volver a subir o bajar hay que pasar el umbral por
+ * LOD_HISTERESIS, así un objeto en el límite no cambia cada frame.
+ ***********************************************************************/
+
+#define LOD_NIVELES_MAX     4      // Sin contar el completo
+#define LOD_NIVELES         3
+#define LOD_REDUCCION       0.5f
+#define LOD_TAMANO_COMPLETO 0.25f
+#define LOD_HISTERESIS      0.15f
+#define LOD_PESO_BORDE      100.0  // Peso de los planos que sujetan los bordes abiertos
+
+/***********************************************************************
+ * Optimización de mallas al cargar: orden de triángulos de Forsyth para
+ * una caché de vértices LRU de CACHE_VERTICES entradas y vértices
+ * renumerados por orden de primer uso. El ACMR (fallos de caché por
+ * triángulo, entre 0.5 y 3) se mide con esa misma caché.
+ ***********************************************************************/
+
+#define CACHE_VERTICES            32
+#define FORSYTH_PESO_ULTIMO       0.75f  // Vértices del último triángulo
+#define FORSYTH_POTENCIA_CACHE    1.5f
+#define FORSYTH_PESO_VALENCIA     2.0f
+#define FORSYTH_POTENCIA_VALENCIA 0.5f
+
+typedef struct {
+    int triangulos, vertices;
+    float acmr_antes, acmr_despues;
+} EstadisticasOptimizacion;
+
+// Ángulo (grados) a partir del cual dos caras vecinas no se suavizan
+// al calcular las normales de vértice: la arista se queda viva.
+#define NORMALES_ANGULO_PLIEGUE 60.0f
+
+/***********************************************************************
+ * Iluminación. Las luces se guardan como estructura de arrays para poder
+ * evaluarlas con SIMD sobre lotes de vértices.
+ ***********************************************************************/
+
+#define LUCES_MAX 256
+#define LUCES_LOTE 256 // Puntos de muestreo por lote, caben en L1
+
+typedef enum {
+    LUZ_DIRECCIONAL = 0,  // Sol: sólo dirección
+    LUZ_POSICIONAL,       // Bombilla: posición y alcance
+    LUZ_FOCO              // Foco: posición, dirección, alcance y cono
+} TipoLuz;
+
+typedef enum {
+    SOMBREADO_PLANO = 0,  // Un color por cara, en el centroide
+    SOMBREADO_GOURAUD     // Un color por vértice
+} ModoSombreado;
+
+typedef struct {
+    float r, g, b;
+} Color;
+
+typedef struct {
+    int num;
+    Color ambiente;
+    unsigned char tipo[LUCES_MAX];
+    float pos_x[LUCES_MAX], pos_y[LUCES_MAX], pos_z[LUCES_MAX];
+    float dir_x[LUCES_MAX], dir_y[LUCES_MAX], dir_z[LUCES_MAX];  // Hacia donde apunta la luz, normalizada
+    float r[LUCES_MAX], g[LUCES_MAX], b[LUCES_MAX];
+    float rango[LUCES_MAX], inv_rango[LUCES_MAX];
+    float cos_exterior[LUCES_MAX], inv_cono[LUCES_MAX];         // inv_cono = 1 / (cos_interior - cos_exterior)
+} Luces;
+
+typedef struct {
+    // Luces que alcanzan al objeto actual, ordenadas por tipo:
+    // [0, fin_direccionales) direccionales, luego posicionales, luego focos.
+    Luces activas;
+    int fin_direccionales, fin_posicionales;
+
+    // Lote de puntos en espacio mundo, como estructura de arrays
+    float px[LUCES_LOTE], py[LUCES_LOTE], pz[LUCES_LOTE];
+    float nx[LUCES_LOTE], ny[LUCES_LOTE], nz[LUCES_LOTE];
+    float r[LUCES_LOTE], g[LUCES_LOTE], b[LUCES_LOTE];
+
+    long objetos, luces_evaluadas, luces_descartadas;
+} Sombreador;
+
+/***********************************************************************
+ * Grabación y reproducción de sesiones. Cada llamada de interacción se
+ * guarda como un evento binario de 24 bytes.
+ ***********************************************************************/
+
+#define GRABACION_SIN_OBJETO (-1)  // La llamada se hizo con sel_ptr a NULL
+
+typedef enum {
+    ENTRADA_TRANSFORMAR = 1,
+    ENTRADA_ROTATE,
+    ENTRADA_TRASLACION_LOCAL,
+    ENTRADA_TRASLACION_ORBITA,
+    ENTRADA_SWAP_CAMERA,
+    ENTRADA_UNDO
+} TipoEntrada;
+
+typedef struct {
+    unsigned long long t_ns;         // Desde el inicio de la grabación
+    unsigned int scene_status_mask;
+    int objeto;                      // Índice del objeto en la lista de la escena, o GRABACION_SIN_OBJETO
+    unsigned char tipo;              // TipoEntrada
+    char eje;
+    signed char dir;
+} EventoEntrada;
+
+typedef struct {
+    Camera* main_camera;
+    Camera* secondary_camera;
+    triobj* lista;
+} EscenaReplay;
+
+typedef struct {
+    long eventos;
+    long frames;
+    long triangulos_dibujados;
+    double total_ms;
+    double p50_ms, p95_ms, p99_ms, max_ms;
+} EstadisticasReplay;
+
+extern int grabacion_activa;
+void grabar_entrada(TipoEntrada tipo, char eje, int dir, unsigned int scene_status_mask, const triobj* sel_ptr);
+
+#define GRABAR_ENTRADA(tipo, eje, dir, scene_status_mask, sel_ptr) \
+    do { if (grabacion_activa) grabar_entrada((tipo), (eje), (dir), (scene_status_mask), (sel_ptr)); } while (0)
+
+/***********************************************************************
+ * Benchmarks. Resultado de un kernel (tiempos normalizados por elemento)
+ * y configuración común de las suites.
+ ***********************************************************************/
+
+#define BENCH_MAX_RESULTADOS 64
+
+typedef struct {
+    const char* nombre;
+    long elementos;
+    double min_ns;
+    double mediana_ns;
+    double baseline_ns;  // 0 si no hay baseline
+    int regresion;
+} BenchResultado;
+
+typedef struct {
+    int calentamiento;
+    int repeticiones;
+    double umbral;       // Fracción de empeoramiento tolerada frente a la baseline
+    double escala;       // Multiplicador del tamaño de entrada de cada suite
+    long triangulos;     // Triángulos de la escena (0 = barrido por defecto de la suite)
+    int frames;          // Frames medidos en las suites de escena (0 = por defecto)
+    const char* ruta_sesion;  // Sesión grabada para la suite de reproducción
+    int ritmo_grabado;        // 1 = reproducir respetando los tiempos grabados
+    const char* ruta_textura; // Textura PPM para la suite de rasterizado
+    double presupuesto_mb;    // Memoria para trozos residentes en la suite de trozos (0 = por defecto)
+    const char* ruta_csv;
+    const char* ruta_json;
+    const char* ruta_baseline;
+    const char* ruta_guardar_baseline;
+
+    BenchResultado resultados[BENCH_MAX_RESULTADOS];
+    int num_resultados;
+} BenchConfig;
+
+typedef void (*BenchKernel)(void* ctx);
+
 #endif // SHARED_DEFINES_H
\ No newline at end of file
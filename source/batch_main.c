@@ -0,0 +1,129 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                      EJECUTABLE DE RENDER POR LOTES                 *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Punto de entrada del render por lotes. Sólo se compila con
+ * -DRENDER_LOTES, para no chocar con el main de la aplicación ni con el
+ * de los benchmarks:
+ *
+ *   cc -O2 -DRENDER_LOTES -I. <todos los .c de source> -o render <GL/GLUT> -lm -lpthread
+ *   ./render poses.txt --salida previas/ --ancho 1280 --alto 720 escena/a.trozos escena/b.trozos
+ *
+ * Los ficheros de escena van en el formato por trozos y se cargan con
+ * cargar_escena(); sin ninguno se usa la escena procedural de prueba con
+ * --triangulos (300K por defecto). El formato del fichero de poses está
+ * en batch_render.c.
+ ***********************************************************************/
+
+#ifdef RENDER_LOTES
+
+#define LOTE_ANCHO 640
+#define LOTE_ALTO 480
+#define LOTE_TRIANGULOS 300000
+
+static void mostrar_uso(const char* programa) {
+    printf("Uso: %s <poses> [opciones] [ficheros de escena...]\n\n"
+           "Opciones: --salida prefijo --hilos N --ancho N --alto N\n"
+           "          --textura ruta.ppm --triangulos N\n",
+           programa);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        mostrar_uso(argv[0]);
+        return 1;
+    }
+
+    const char* prefijo = "";
+    const char* ruta_textura = NULL;
+    int hilos = 0, ancho = LOTE_ANCHO, alto = LOTE_ALTO;
+    long triangulos = LOTE_TRIANGULOS;
+    char** ficheros = (char**)malloc(sizeof(char*) * (size_t)argc);
+    int num_ficheros = 0;
+    if (!ficheros)
+        return 1;
+
+    for (int i = 2; i < argc; i++) {
+        const char* valor = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strncmp(argv[i], "--", 2) != 0) {
+            ficheros[num_ficheros++] = argv[i];
+            continue;
+        }
+        if (!valor) {
+            mostrar_uso(argv[0]);
+            free(ficheros);
+            return 1;
+        }
+        if (strcmp(argv[i], "--salida") == 0)
+            prefijo = valor;
+        else if (strcmp(argv[i], "--hilos") == 0)
+            hilos = atoi(valor);
+        else if (strcmp(argv[i], "--ancho") == 0)
+            ancho = atoi(valor);
+        else if (strcmp(argv[i], "--alto") == 0)
+            alto = atoi(valor);
+        else if (strcmp(argv[i], "--textura") == 0)
+            ruta_textura = valor;
+        else if (strcmp(argv[i], "--triangulos") == 0)
+            triangulos = atol(valor);
+        else {
+            mostrar_uso(argv[0]);
+            free(ficheros);
+            return 1;
+        }
+        i++;
+    }
+    if (ancho <= 0 || alto <= 0) {
+        mostrar_uso(argv[0]);
+        free(ficheros);
+        return 1;
+    }
+
+    PoseRender* poses = NULL;
+    int num_poses = cargar_poses(argv[1], prefijo, &poses);
+    if (num_poses < 0) {
+        free(ficheros);
+        return 1;
+    }
+
+    triobj* lista;
+    if (num_ficheros > 0) {
+        EstadisticasCargaEscena carga;
+        lista = cargar_escena(ficheros, num_ficheros, cargar_triangulos_trozos, 0, &carga);
+        printf("Escena: %ld triángulos de %d ficheros (%d fallidos) en %.1f ms\n", carga.triangulos, carga.ficheros,
+               carga.fallidos, carga.total_ms);
+    } else {
+        lista = generar_escena_prueba(triangulos);
+    }
+    free(ficheros);
+    if (!lista) {
+        printf("\nNo se ha podido preparar la escena.\n");
+        free(poses);
+        return 1;
+    }
+
+    Textura tex;
+    int con_textura = ruta_textura && cargar_textura_ppm(ruta_textura, &tex) == 0;
+
+    EstadisticasLote stats = {0};
+    int resultado = renderizar_lote(poses, num_poses, lista, con_textura ? &tex : NULL, ancho, alto, hilos, &stats);
+    printf("%d imágenes de %dx%d en %.1f ms con %d hilos: %.1f imágenes/s  %ld triángulos  "
+           "render %.1f ms  escritura %.1f ms (sumados entre hilos)  %d fallidas\n",
+           stats.imagenes, ancho, alto, stats.total_ms, stats.hilos,
+           stats.total_ms > 0.0 ? stats.imagenes * 1e3 / stats.total_ms : 0.0, stats.triangulos, stats.render_ms,
+           stats.escritura_ms, stats.fallidas);
+
+    if (con_textura)
+        liberar_textura(&tex);
+    liberar_escena(lista);
+    free(poses);
+    return resultado != 0 ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                           RENDER POR LOTES                          *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo saca muchas imágenes de la misma escena desde poses de
+ * cámara distintas (previsualizaciones offline), con el rasterizado por
+ * software. La escena se carga una vez y las poses se reparten entre
+ * hilos: cada hilo tiene su cámara y su framebuffer y va tomando la
+ * siguiente pose pendiente, la rasteriza y escribe su PPM.
+ *
+ * Los hilos sólo leen la escena. Antes de lanzarlos se calculan los
+ * triángulos en espacio mundo de cada objeto (triangulos_mundo), que
+ * luego todas las poses comparten a través de
+ * rasterizar_vistas_preparadas(); ésta nunca rehace la copia, así que
+ * un objeto para el que no ha habido memoria se queda sin ella y va por
+ * procesar_objeto() en todas las poses. Por lo mismo no se usan los
+ * niveles de detalle, que guardan en el objeto el nivel elegido en el
+ * frame anterior.
+ *
+ * El fichero de trabajos tiene una pose por línea; las líneas vacías y
+ * las que empiezan por '#' se ignoran:
+ *
+ *   # ojo          mira     arriba  proyección   [salida]
+ *   0 150 800      0 0 0    0 1 0   perspectiva  frente.ppm
+ *   800 150 0      0 0 0    0 1 0   ortografica
+ *
+ * La proyección es "perspectiva" u "ortografica" (vale la inicial). Sin
+ * salida, la imagen se llama <prefijo>NNNN.ppm con el número de pose.
+ ***********************************************************************/
+
+#define LOTE_LINEA_MAX 1024
+
+typedef struct {
+    const PoseRender* poses;
+    int num_poses;
+    triobj* lista;
+    const Textura* tex;
+    int ancho, alto;
+    _Atomic int siguiente;
+
+    pthread_mutex_t mutex;  // Sólo para acumular las estadísticas
+    EstadisticasLote stats;
+} TrabajoLote;
+
+static double ahora_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * Lee las poses de un fichero de trabajos.
+ * @param ruta Fichero de trabajos.
+ * @param prefijo_salida Prefijo de las imágenes sin salida explícita
+ *        (un directorio acabado en '/', por ejemplo).
+ * @param poses Salida: array de poses, a liberar con free().
+ * @return Número de poses, o -1 si no se puede leer el fichero, hay una
+ *         línea mal formada o no hay memoria.
+ */
+int cargar_poses(const char* ruta, const char* prefijo_salida, PoseRender** poses) {
+    FILE* f = fopen(ruta, "r");
+    if (!f) {
+        printf("\nNo se ha podido abrir el fichero de trabajos %s.\n", ruta);
+        return -1;
+    }
+
+    char linea[LOTE_LINEA_MAX];
+    int num_poses = 0, capacidad = 0, num_linea = 0;
+    *poses = NULL;
+
+    while (fgets(linea, sizeof(linea), f)) {
+        num_linea++;
+        char* inicio = linea;
+        while (*inicio == ' ' || *inicio == '\t')
+            inicio++;
+        if (*inicio == '#' || *inicio == '\n' || *inicio == '\r' || *inicio == '\0')
+            continue;
+
+        if (num_poses == capacidad) {
+            capacidad = capacidad ? capacidad * 2 : 64;
+            PoseRender* nuevas = (PoseRender*)realloc(*poses, sizeof(PoseRender) * (size_t)capacidad);
+            if (!nuevas)
+                goto error;
+            *poses = nuevas;
+        }
+
+        PoseRender* pose = &(*poses)[num_poses];
+        char proyeccion[32];
+        pose->ruta[0] = '\0';
+        int leidos = sscanf(inicio, "%f %f %f %f %f %f %f %f %f %31s %255s", &pose->ojo.x, &pose->ojo.y, &pose->ojo.z,
+                            &pose->mira.x, &pose->mira.y, &pose->mira.z, &pose->arriba.x, &pose->arriba.y,
+                            &pose->arriba.z, proyeccion, pose->ruta);
+        if (leidos < 10 || (proyeccion[0] != 'p' && proyeccion[0] != 'o')) {
+            printf("\n%s:%d: se esperaba \"ojo mira arriba perspectiva|ortografica [salida]\".\n", ruta, num_linea);
+            goto error;
+        }
+        pose->proyeccion = proyeccion[0] == 'p' ? PROJECTION_PERSPECTIVE : PROJECTION_ORTOGRAPHIC;
+        if (leidos < 11)
+            snprintf(pose->ruta, sizeof(pose->ruta), "%s%04d.ppm", prefijo_salida, num_poses);
+        num_poses++;
+    }
+
+    fclose(f);
+    return num_poses;
+
+error:
+    fclose(f);
+    free(*poses);
+    *poses = NULL;
+    return -1;
+}
+
+static void* hilo_lote(void* arg) {
+    TrabajoLote* trabajo = (TrabajoLote*)arg;
+    EstadisticasLote parcial = {0};
+
+    View view;
+    Camera camera;
+    camera.view = &view;
+    Framebuffer* fb = crear_framebuffer(trabajo->ancho, trabajo->alto);
+
+    // Sin framebuffer este hilo no coge poses; las hacen los demás.
+    while (fb) {
+        int i = atomic_fetch_add(&trabajo->siguiente, 1);
+        if (i >= trabajo->num_poses)
+            break;
+
+        const PoseRender* pose = &trabajo->poses[i];
+        double inicio = ahora_ms();
+        update_camera(&camera, pose->ojo, pose->mira, pose->arriba);
+        limpiar_framebuffer(fb, 0, 0, 0);
+        Vista vista = {&camera, fb, 0, 0};
+        rasterizar_vistas_preparadas(&vista, 1, pose->proyeccion | BACK_CULLING, trabajo->lista, trabajo->tex);
+        double renderizado = ahora_ms();
+        parcial.render_ms += renderizado - inicio;
+        parcial.triangulos += vista.triangulos;
+        parcial.imagenes++;
+
+        if (pose->ruta[0]) {
+            if (guardar_framebuffer_ppm(fb, pose->ruta) != 0) {
+                printf("\nNo se ha podido escribir %s.\n", pose->ruta);
+                parcial.fallidas++;
+            }
+            parcial.escritura_ms += ahora_ms() - renderizado;
+        }
+    }
+    liberar_framebuffer(fb);
+
+    pthread_mutex_lock(&trabajo->mutex);
+    trabajo->stats.imagenes += parcial.imagenes;
+    trabajo->stats.fallidas += parcial.fallidas;
+    trabajo->stats.triangulos += parcial.triangulos;
+    trabajo->stats.render_ms += parcial.render_ms;
+    trabajo->stats.escritura_ms += parcial.escritura_ms;
+    pthread_mutex_unlock(&trabajo->mutex);
+    return NULL;
+}
+
+/**
+ * Renderiza un lote de poses sobre la misma escena, repartidas entre hilos.
+ * La escena no debe cambiar mientras dure el lote.
+ * @param poses Poses a renderizar, con la ruta de su PPM.
+ * @param num_poses Número de poses.
+ * @param lista Primer objeto de la escena.
+ * @param tex Textura (NULL para blanco).
+ * @param ancho, alto Tamaño de las imágenes.
+ * @param hilos Hilos de render (<= 0 para uno por núcleo).
+ * @param stats Salida opcional: recuento y tiempos del lote.
+ * @return 0 si se han renderizado y escrito todas las poses, -1 si no.
+ */
+int renderizar_lote(const PoseRender* poses, int num_poses, triobj* lista, const Textura* tex, int ancho, int alto,
+                    int hilos, EstadisticasLote* stats) {
+    double inicio = ahora_ms();
+
+    if (hilos <= 0)
+        hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos > num_poses)
+        hilos = num_poses;
+    if (hilos < 1)
+        hilos = 1;
+
+    pthread_t* ids = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)hilos);
+    if (!ids)
+        return -1;
+
+    // La copia en mundo se hace aquí, antes de que los hilos la lean. Si
+    // falla para algún objeto, triangulos_mundo() lo deja sin ella (NULL)
+    // y los hilos lo mandan a procesar_objeto() en vez de reintentarlo.
+    for (triobj* obj = lista; obj; obj = obj->hptr)
+        triangulos_mundo(obj);
+
+    TrabajoLote trabajo = {.poses = poses, .num_poses = num_poses, .lista = lista, .tex = tex,
+                           .ancho = ancho, .alto = alto, .siguiente = 0};
+    pthread_mutex_init(&trabajo.mutex, NULL);
+
+    // El hilo que llama también renderiza.
+    int lanzados = 0;
+    for (int h = 1; h < hilos; h++) {
+        if (pthread_create(&ids[lanzados], NULL, hilo_lote, &trabajo) == 0)
+            lanzados++;
+    }
+    hilo_lote(&trabajo);
+    for (int h = 0; h < lanzados; h++)
+        pthread_join(ids[h], NULL);
+    pthread_mutex_destroy(&trabajo.mutex);
+    free(ids);
+
+    trabajo.stats.hilos = lanzados + 1;
+    trabajo.stats.total_ms = ahora_ms() - inicio;
+    if (stats)
+        *stats = trabajo.stats;
+    return trabajo.stats.imagenes == num_poses && trabajo.stats.fallidas == 0 ? 0 : -1;
+}
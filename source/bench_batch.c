@@ -0,0 +1,82 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                    BENCHMARK DE RENDER POR LOTES                    *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Renderiza con renderizar_lote() 64 poses alrededor de la escena de
+ * prueba (300K triángulos por defecto, --triangulos N) a 640x480, una de
+ * cada cuatro en ortográfica: con un hilo y con uno por núcleo, sin
+ * escribir las imágenes, y con uno por núcleo escribiendo los PPM en
+ * /tmp. Lo que importa es el número de imágenes por segundo.
+ ***********************************************************************/
+
+#define BENCH_LOTE_POSES 64
+#define BENCH_LOTE_ANCHO 640
+#define BENCH_LOTE_ALTO 480
+
+/**
+ * Ejecuta el benchmark de render por lotes.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_lotes(BenchConfig* config) {
+    static const char* nombres[3] = {"lote_1hilo", "lote_hilos", "lote_hilos_ppm"};
+    static const int hilos[3] = {1, 0, 0};
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(300000 * config->escala);
+
+    triobj* lista = generar_escena_prueba(triangulos);
+    PoseRender* poses = (PoseRender*)malloc(sizeof(PoseRender) * BENCH_LOTE_POSES);
+    if (!lista || !poses) {
+        liberar_escena(lista);
+        free(poses);
+        return -1;
+    }
+
+    for (int i = 0; i < BENCH_LOTE_POSES; i++) {
+        float a = 2.0f * PI * i / BENCH_LOTE_POSES;
+        poses[i].ojo = vector3(800.0f * sinf(a), 150.0f + 100.0f * (i % 3), 800.0f * cosf(a));
+        poses[i].mira = vector3(0.0f, 0.0f, 0.0f);
+        poses[i].arriba = vector3(0.0f, 1.0f, 0.0f);
+        poses[i].proyeccion = i % 4 == 3 ? PROJECTION_ORTOGRAPHIC : PROJECTION_PERSPECTIVE;
+    }
+
+    for (int k = 0; k < 3 && config->num_resultados < BENCH_MAX_RESULTADOS; k++) {
+        for (int i = 0; i < BENCH_LOTE_POSES; i++) {
+            if (k == 2)
+                snprintf(poses[i].ruta, sizeof(poses[i].ruta), "/tmp/bench_lote_%d_%04d.ppm", (int)getpid(), i);
+            else
+                poses[i].ruta[0] = '\0';
+        }
+
+        // Una pasada de calentamiento y la medida.
+        EstadisticasLote stats = {0};
+        renderizar_lote(poses, BENCH_LOTE_POSES, lista, NULL, BENCH_LOTE_ANCHO, BENCH_LOTE_ALTO, hilos[k], &stats);
+        renderizar_lote(poses, BENCH_LOTE_POSES, lista, NULL, BENCH_LOTE_ANCHO, BENCH_LOTE_ALTO, hilos[k], &stats);
+
+        printf("%-24s %8.1f ms  %2d hilos  %6.1f imágenes/s  render %.1f ms  escritura %.1f ms  %d fallidas\n",
+               nombres[k], stats.total_ms, stats.hilos, stats.imagenes * 1e3 / stats.total_ms, stats.render_ms,
+               stats.escritura_ms, stats.fallidas);
+
+        BenchResultado* r = &config->resultados[config->num_resultados++];
+        memset(r, 0, sizeof(BenchResultado));
+        r->nombre = nombres[k];
+        r->elementos = stats.imagenes;
+        r->min_ns = r->mediana_ns = stats.total_ms * 1e6 / (stats.imagenes > 0 ? stats.imagenes : 1);
+
+        if (k == 2) {
+            for (int i = 0; i < BENCH_LOTE_POSES; i++)
+                unlink(poses[i].ruta);
+        }
+    }
+
+    liberar_escena(lista);
+    free(poses);
+    return bench_informe(config);
+}
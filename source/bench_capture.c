@@ -0,0 +1,131 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                     BENCHMARK DE CAPTURA DE FRAMES                  *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Orbita la cámara alrededor de la escena de prueba (100K triángulos por
+ * defecto, --triangulos N) rasterizando a 640x480, y mide el tiempo por
+ * frame del hilo de render:
+ *
+ *   captura_ninguna       sin guardar nada, la referencia.
+ *   captura_sincrona      guardar_framebuffer_ppm() en cada frame.
+ *   captura_ppm           capturar_frame() con PPM por frame.
+ *   captura_cruda         capturar_frame() a un único fichero crudo.
+ *   captura_descartar     PPM con un pool de 2 buffers y CAPTURA_DESCARTAR.
+ *
+ * De las capturas asíncronas se informa también de los contadores
+ * (escritos, descartados, esperas, máximo en cola). Los ficheros van a
+ * /tmp y se borran al acabar.
+ ***********************************************************************/
+
+#define BENCH_CAPTURA_ANCHO 640
+#define BENCH_CAPTURA_ALTO 480
+#define BENCH_CAPTURA_CASOS 5
+#define BENCH_CAPTURA_PREFIJO 64
+// Prefijo, número de frame (un long entero) y extensión
+#define BENCH_CAPTURA_RUTA (BENCH_CAPTURA_PREFIJO + 32)
+
+typedef struct {
+    Framebuffer* fb;
+    Camera* camera;
+    triobj* lista;
+    CapturaFrames* captura;
+    const char* prefijo_sincrono;
+    long frames;
+} DatosCaptura;
+
+static void kernel_captura(void* ctx) {
+    DatosCaptura* d = (DatosCaptura*)ctx;
+
+    traslacion_orbita('y', 1, d->camera, d->lista);
+    limpiar_framebuffer(d->fb, 0, 0, 0);
+    rasterizar_escena(d->fb, d->camera, PROJECTION_PERSPECTIVE | BACK_CULLING | VERTICES_MUNDO, d->lista, NULL, NULL);
+
+    if (d->captura) {
+        capturar_frame(d->captura, d->fb);
+    } else if (d->prefijo_sincrono) {
+        char ruta[BENCH_CAPTURA_RUTA];
+        snprintf(ruta, sizeof(ruta), "%s%05ld.ppm", d->prefijo_sincrono, d->frames);
+        guardar_framebuffer_ppm(d->fb, ruta);
+    }
+    d->frames++;
+}
+
+/**
+ * Ejecuta el benchmark de captura de frames.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_captura(BenchConfig* config) {
+    static const char* nombres[BENCH_CAPTURA_CASOS] = {"captura_ninguna", "captura_sincrona", "captura_ppm",
+                                                      "captura_cruda", "captura_descartar"};
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(100000 * config->escala);
+
+    triobj* lista = generar_escena_prueba(triangulos);
+    Framebuffer* fb = crear_framebuffer(BENCH_CAPTURA_ANCHO, BENCH_CAPTURA_ALTO);
+    if (!lista || !fb) {
+        liberar_escena(lista);
+        liberar_framebuffer(fb);
+        return -1;
+    }
+
+    char prefijo[BENCH_CAPTURA_PREFIJO];
+    snprintf(prefijo, sizeof(prefijo), "/tmp/bench_captura_%d_", (int)getpid());
+
+    int resultado = 0;
+    for (int caso = 0; caso < BENCH_CAPTURA_CASOS && resultado == 0; caso++) {
+        View view;
+        Camera camera;
+        camera.view = &view;
+        update_camera(&camera, vector3(0.0f, 150.0f, 800.0f), vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+
+        char ruta_cruda[BENCH_CAPTURA_RUTA];
+        snprintf(ruta_cruda, sizeof(ruta_cruda), "%scruda.rgb", prefijo);
+        DatosCaptura d = {fb, &camera, lista, NULL, caso == 1 ? prefijo : NULL, 0};
+        if (caso >= 2) {
+            d.captura = crear_captura(caso == 3 ? ruta_cruda : prefijo, caso == 3 ? CAPTURA_CRUDA : CAPTURA_PPM,
+                                      BENCH_CAPTURA_ANCHO, BENCH_CAPTURA_ALTO, caso == 4 ? 2 : 0,
+                                      caso == 4 ? CAPTURA_DESCARTAR : CAPTURA_ESPERAR);
+            if (!d.captura) {
+                resultado = -1;
+                break;
+            }
+        }
+
+        BenchResultado* r = bench_ejecutar(config, nombres[caso], kernel_captura, &d, 1);
+
+        // El cierre espera a que se vacíe la cola: es lo que queda pendiente al acabar la secuencia.
+        double inicio_cierre = bench_now_ns();
+        EstadisticasCaptura stats;
+        if (d.captura)
+            cerrar_captura(d.captura, &stats);
+        double cierre_ms = (bench_now_ns() - inicio_cierre) / 1e6;
+
+        if (r)
+            printf("%-24s %8.3f ms/frame", nombres[caso], r->mediana_ns / 1e6);
+        if (d.captura)
+            printf("  %ld encolados  %ld escritos  %ld descartados  %ld fallidos  %ld esperas (%.1f ms)  "
+                   "máx. en cola %d  escritura %.1f ms  cierre %.1f ms",
+                   stats.encolados, stats.escritos, stats.descartados, stats.fallidos, stats.esperas, stats.espera_ms,
+                   stats.max_en_cola, stats.escritura_ms, cierre_ms);
+        printf("\n");
+
+        unlink(ruta_cruda);
+        for (long f = 0; f < d.frames; f++) {
+            char ruta[BENCH_CAPTURA_RUTA];
+            snprintf(ruta, sizeof(ruta), "%s%05ld.ppm", prefijo, f);
+            unlink(ruta);
+        }
+    }
+
+    liberar_framebuffer(fb);
+    liberar_escena(lista);
+    return resultado != 0 ? -1 : bench_informe(config);
+}
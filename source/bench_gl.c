@@ -0,0 +1,168 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                      BENCHMARK DEL CAMINO DE OPENGL                 *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Mide las capas que se dibujan con OpenGL (ejes, malla del suelo, ejes
+ * de objeto y vectores normales) en un contexto sin ventana de 800x600
+ * (ver offscreen_context.c), así que corre en CI y en los nodos de render
+ * sin pantalla, normalmente sobre llvmpipe.
+ *
+ * Cada kernel pinta --frames frames (4 por defecto), borrando antes cada
+ * uno, y espera con glFinish a que el rasterizado termine: el tiempo es
+ * por frame e incluye el trabajo de GL, no sólo el envío de comandos. Los
+ * vectores normales son los de una esfera de --triangulos triángulos
+ * (20000 por defecto), uno por triángulo, encolados y dibujados de una
+ * vez y, como referencia, uno a uno con draw_vector().
+ *
+ * Tras cada capa se lee el framebuffer y se cuentan los píxeles pintados,
+ * para ver que de verdad se ha dibujado algo; la lectura también se mide.
+ ***********************************************************************/
+
+#define BENCH_GL_FRAMES 4
+#define BENCH_GL_TRIANGULOS 20000
+#define BENCH_GL_MALLA 5.0f  // ~400 líneas
+
+typedef struct {
+    ContextoOffscreen* ctx;
+    triobj* obj;
+    int frames;
+    unsigned char* pixeles;
+} DatosGL;
+
+static void preparar_frame(void) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+static void kernel_gl_ejes(void* ctx) {
+    DatosGL* d = (DatosGL*)ctx;
+    for (int f = 0; f < d->frames; f++) {
+        preparar_frame();
+        dibujar_ejes();
+    }
+    glFinish();
+}
+
+static void kernel_gl_malla(void* ctx) {
+    DatosGL* d = (DatosGL*)ctx;
+    for (int f = 0; f < d->frames; f++) {
+        preparar_frame();
+        dibujar_malla(BENCH_GL_MALLA);
+    }
+    glFinish();
+}
+
+static void kernel_gl_ejes_objeto(void* ctx) {
+    DatosGL* d = (DatosGL*)ctx;
+    for (int f = 0; f < d->frames; f++) {
+        preparar_frame();
+        dibujar_ejes_objeto(d->obj);
+    }
+    glFinish();
+}
+
+static void kernel_gl_vectores_normales(void* ctx) {
+    DatosGL* d = (DatosGL*)ctx;
+    for (int f = 0; f < d->frames; f++) {
+        preparar_frame();
+        for (int t = 0; t < d->obj->num_triangles; t++) {
+            Vector3 normal;
+            obtain_normal_vector(&d->obj->triptr[t], &normal);
+            encolar_vector_normal(&d->obj->triptr[t], normal);
+        }
+        dibujar_vectores_normales();
+    }
+    glFinish();
+}
+
+static void kernel_gl_vectores_inmediato(void* ctx) {
+    DatosGL* d = (DatosGL*)ctx;
+    for (int f = 0; f < d->frames; f++) {
+        preparar_frame();
+        for (int t = 0; t < d->obj->num_triangles; t++) {
+            Vector3 normal;
+            obtain_normal_vector(&d->obj->triptr[t], &normal);
+            draw_vector(&d->obj->triptr[t], normal);
+        }
+    }
+    glFinish();
+}
+
+static void kernel_gl_lectura(void* ctx) {
+    DatosGL* d = (DatosGL*)ctx;
+    leer_pixeles_offscreen(d->ctx, d->pixeles);
+}
+
+static long contar_pintados(const unsigned char* rgb, long num_pixeles) {
+    long pintados = 0;
+    for (long i = 0; i < num_pixeles; i++)
+        pintados += (rgb[3 * i] | rgb[3 * i + 1] | rgb[3 * i + 2]) != 0;
+    return pintados;
+}
+
+/**
+ * Ejecuta el benchmark del camino de OpenGL.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si no hay contexto GL.
+ */
+int bench_gl(BenchConfig* config) {
+    ContextoOffscreen* contexto = crear_contexto_offscreen(OFFSCREEN_ANCHO, OFFSCREEN_ALTO);
+    if (!contexto)
+        return -1;
+    printf("Contexto: %s\n", contexto_offscreen_backend(contexto));
+
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(BENCH_GL_TRIANGULOS * config->escala);
+    long num_pixeles = (long)OFFSCREEN_ANCHO * OFFSCREEN_ALTO;
+    DatosGL d = {contexto, generar_esfera(300.0f, triangulos), config->frames > 0 ? config->frames : BENCH_GL_FRAMES,
+                 (unsigned char*)malloc((size_t)num_pixeles * 3)};
+    if (!d.obj || !d.pixeles) {
+        liberar_triobj(d.obj);
+        free(d.pixeles);
+        destruir_contexto_offscreen(contexto);
+        return -1;
+    }
+
+    // Vista frontal del plano z = 0, con el mismo rango que los ejes.
+    glViewport(0, 0, OFFSCREEN_ANCHO, OFFSCREEN_ALTO);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(-600.0, 600.0, -450.0, 450.0, -1000.0, 1000.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    static const struct {
+        const char* nombre;
+        BenchKernel kernel;
+    } capas[] = {
+        {"gl_ejes", kernel_gl_ejes},
+        {"gl_malla", kernel_gl_malla},
+        {"gl_ejes_objeto", kernel_gl_ejes_objeto},
+        {"gl_vectores_normales", kernel_gl_vectores_normales},
+        {"gl_vectores_inmediato", kernel_gl_vectores_inmediato},
+    };
+
+    for (int i = 0; i < (int)(sizeof(capas) / sizeof(capas[0])); i++) {
+        BenchResultado* r = bench_ejecutar(config, capas[i].nombre, capas[i].kernel, &d, d.frames);
+        if (!r)
+            break;
+        leer_pixeles_offscreen(contexto, d.pixeles);
+        long pintados = contar_pintados(d.pixeles, num_pixeles);
+        printf("%-22s %8.3f ms/frame  %7ld píxeles pintados (%.1f%%)\n", capas[i].nombre, r->mediana_ns / 1e6,
+               pintados, 100.0 * pintados / num_pixeles);
+    }
+
+    BenchResultado* r = bench_ejecutar(config, "gl_lectura_pixeles", kernel_gl_lectura, &d, 1);
+    if (r)
+        printf("%-22s %8.3f ms\n", "gl_lectura_pixeles", r->mediana_ns / 1e6);
+
+    liberar_triobj(d.obj);
+    free(d.pixeles);
+    destruir_contexto_offscreen(contexto);
+    return bench_informe(config);
+}
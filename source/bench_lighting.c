@@ -0,0 +1,176 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                       BENCHMARK DE ILUMINACIÓN                      *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Mide la etapa de sombreado sobre la escena de prueba con 1, 4, 16, 64
+ * y 256 luces, en plano y en Gouraud. La primera luz es siempre un sol;
+ * el resto son bombillas y focos repartidos al azar (semilla fija) por la
+ * escena, con un rango que sólo alcanza a parte de los objetos, para que
+ * el descarte por objeto tenga efecto.
+ *
+ * Los focos apuntan al origen, hacia la escena. Antes de medir se
+ * comprueba que un foco solo, apuntado a la esfera desde delante, la
+ * ilumina.
+ *
+ * Se informa del tiempo por punto sombreado (cara en plano, vértice en
+ * Gouraud), por punto y luz evaluada, y de las luces que llegan de media
+ * a cada objeto. También del coste de las normales de vértice: calcularlas
+ * al cargar y pasarlas a espacio mundo cuando cambia la matriz (si no
+ * cambia, el Gouraud reutiliza las de la caché y no cuesta nada).
+ ***********************************************************************/
+
+#define BENCH_LUCES_SEMILLA 0x9E3779B9u
+#define BENCH_LUCES_TAMANOS 5
+
+typedef struct {
+    Sombreador* sombreador;
+    Luces* luces;
+    triobj* lista;
+    ModoSombreado modo;
+    Color* colores;
+} DatosLuces;
+
+static void kernel_sombreado(void* ctx) {
+    DatosLuces* d = (DatosLuces*)ctx;
+    for (triobj* obj = d->lista; obj; obj = obj->hptr)
+        sombrear_objeto(d->sombreador, d->luces, obj, d->modo, d->colores);
+}
+
+static void kernel_normales_carga(void* ctx) {
+    DatosLuces* d = (DatosLuces*)ctx;
+    for (triobj* obj = d->lista; obj; obj = obj->hptr)
+        calcular_normales_vertice(obj, NORMALES_ANGULO_PLIEGUE);
+}
+
+/**
+ * Transformación de las normales a espacio mundo, forzando que se
+ * recalcule como si la matriz hubiera cambiado.
+ */
+static void kernel_normales_mundo(void* ctx) {
+    DatosLuces* d = (DatosLuces*)ctx;
+    for (triobj* obj = d->lista; obj; obj = obj->hptr) {
+        obj->normales_mptr = NULL;
+        normales_mundo(obj);
+    }
+}
+
+static void generar_luces(Luces* luces, int num) {
+    unsigned int estado = BENCH_LUCES_SEMILLA;
+    Color ambiente = {0.1f, 0.1f, 0.1f};
+    Color sol = {0.6f, 0.6f, 0.55f};
+
+    luces_iniciar(luces, ambiente);
+    anadir_luz_direccional(luces, vector3(-0.3f, -1.0f, -0.5f), sol);
+
+    for (int i = 1; i < num; i++) {
+        Vector3 posicion = vector3(bench_random_float(&estado, -500.0f, 500.0f),
+                                   bench_random_float(&estado, -250.0f, 350.0f),
+                                   bench_random_float(&estado, -450.0f, 250.0f));
+        Color color = {bench_random_float(&estado, 0.0f, 0.4f), bench_random_float(&estado, 0.0f, 0.4f),
+                       bench_random_float(&estado, 0.0f, 0.4f)};
+        float rango = bench_random_float(&estado, 150.0f, 350.0f);
+
+        if (i % 2)
+            anadir_luz_posicional(luces, posicion, color, rango);
+        else
+            anadir_luz_foco(luces, posicion, vector3_substract(vector3(0.0f, 0.0f, 0.0f), posicion), color, rango,
+                            0.3f, 0.6f);
+    }
+}
+
+/**
+ * Sombrea la esfera de la escena de prueba (centro en x = 250, radio 80)
+ * con un foco solo, sin ambiente, apuntado a ella desde delante.
+ * @return Vértices a los que llega algo de luz.
+ */
+static long vertices_iluminados_foco(Sombreador* sombreador, Luces* luces, triobj* esfera, Color* colores) {
+    Color negro = {0.0f, 0.0f, 0.0f};
+    Color blanco = {1.0f, 1.0f, 1.0f};
+    luces_iniciar(luces, negro);
+    anadir_luz_foco(luces, vector3(250.0f, 0.0f, 300.0f), vector3(0.0f, 0.0f, -1.0f), blanco, 600.0f, 0.3f, 0.6f);
+    sombrear_objeto(sombreador, luces, esfera, SOMBREADO_GOURAUD, colores);
+
+    long iluminados = 0;
+    for (int i = 0; i < 3 * esfera->num_triangles; i++)
+        iluminados += colores[i].r > 0.0f;
+    return iluminados;
+}
+
+/**
+ * Ejecuta el benchmark de iluminación.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_luces(BenchConfig* config) {
+    static const int num_luces[BENCH_LUCES_TAMANOS] = {1, 4, 16, 64, 256};
+    static char nombres[2][BENCH_LUCES_TAMANOS][40];
+
+    triobj* lista = generar_escena_prueba(config->triangulos > 0 ? config->triangulos : (long)(30000 * config->escala));
+    Luces* luces = (Luces*)malloc(sizeof(Luces));
+    Sombreador* sombreador = crear_sombreador();
+
+    long triangulos = 0, max_triangulos = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr) {
+        triangulos += obj->num_triangles;
+        if (obj->num_triangles > max_triangulos)
+            max_triangulos = obj->num_triangles;
+    }
+    Color* colores = (Color*)malloc(sizeof(Color) * 3 * (max_triangulos > 0 ? max_triangulos : 1));
+
+    if (!lista || !luces || !sombreador || !colores) {
+        liberar_escena(lista);
+        free(luces);
+        liberar_sombreador(sombreador);
+        free(colores);
+        return -1;
+    }
+
+    long iluminados = vertices_iluminados_foco(sombreador, luces, lista->hptr, colores);
+    printf("%-20s %s (%ld de %d vértices)\n", "foco_apuntado", iluminados > 0 ? "ilumina" : "NO ILUMINA", iluminados,
+           3 * lista->hptr->num_triangles);
+
+    DatosLuces normales = {sombreador, luces, lista, SOMBREADO_GOURAUD, colores};
+    static const char* nombres_normales[2] = {"normales_carga", "normales_mundo"};
+    BenchKernel kernels_normales[2] = {kernel_normales_carga, kernel_normales_mundo};
+    for (int k = 0; k < 2; k++) {
+        BenchResultado* r = bench_ejecutar(config, nombres_normales[k], kernels_normales[k], &normales, triangulos);
+        if (r)
+            printf("%-20s %8.2f ns/triángulo  %.2f ms para %ld triángulos\n", nombres_normales[k], r->mediana_ns,
+                   r->mediana_ns * triangulos / 1e6, triangulos);
+    }
+
+    for (int modo = SOMBREADO_PLANO; modo <= SOMBREADO_GOURAUD; modo++) {
+        long puntos = modo == SOMBREADO_PLANO ? triangulos : 3 * triangulos;
+
+        for (int t = 0; t < BENCH_LUCES_TAMANOS; t++) {
+            generar_luces(luces, num_luces[t]);
+            DatosLuces d = {sombreador, luces, lista, (ModoSombreado)modo, colores};
+
+            // Una pasada suelta para contar cuántas luces llegan a cada objeto.
+            sombreador->objetos = sombreador->luces_evaluadas = sombreador->luces_descartadas = 0;
+            kernel_sombreado(&d);
+            double media_activas = (double)sombreador->luces_evaluadas / sombreador->objetos;
+
+            snprintf(nombres[modo][t], sizeof(nombres[modo][t]), "%s_%d_luces",
+                     modo == SOMBREADO_PLANO ? "plano" : "gouraud", num_luces[t]);
+            BenchResultado* r = bench_ejecutar(config, nombres[modo][t], kernel_sombreado, &d, puntos);
+            if (r) {
+                printf("%-20s %8.2f ns/punto  %8.3f ns/(punto*luz)  %6.1f luces/objeto de %d  %.2f ms/frame\n",
+                       nombres[modo][t], r->mediana_ns, r->mediana_ns / (media_activas > 0.0 ? media_activas : 1.0),
+                       media_activas, num_luces[t], r->mediana_ns * puntos / 1e6);
+            }
+        }
+    }
+
+    liberar_escena(lista);
+    free(luces);
+    liberar_sombreador(sombreador);
+    free(colores);
+    return bench_informe(config);
+}
@@ -0,0 +1,211 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                     BENCHMARK DE CARGA DE ESCENAS                   *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Escribe una escena de 16 ficheros (esferas y cilindros alternos, 1M
+ * triángulos en total por defecto, o --triangulos N) en el formato de
+ * mallas por trozos y mide el arranque con cargar_escena(): con un hilo,
+ * que es la carga secuencial de siempre, y con un hilo por núcleo.
+ *
+ * Cada caso se mide en frío, pidiendo antes al sistema que suelte los
+ * ficheros de su caché (posix_fadvise), y en caliente, justo después de
+ * otra carga. Si /tmp es tmpfs las dos serán parecidas. Se informa del
+ * tiempo total y del reparto entre lectura y postproceso (caja, normales,
+ * índices, orden para la caché de vértices y niveles de detalle), sumado
+ * sobre todos los ficheros, y del ACMR antes y después de optimizar (el
+ * formato por trozos ya guarda los triángulos en orden Morton, así que
+ * aquí se parte de un orden bastante bueno).
+ *
+ * Aparte se mide optimizar_triobj() sobre una esfera barajada, como la
+ * dejaría un exportador cualquiera, y lo que gana con ello el rasterizado
+ * por software (procesar_objeto a 800x600): triángulos vecinos en memoria
+ * pintan píxeles vecinos.
+ ***********************************************************************/
+
+#define BENCH_CARGA_FICHEROS 16
+#define BENCH_CARGA_TRIANGULOS 1000000
+#define BENCH_OPTIMIZAR_TRIANGULOS 250000
+
+typedef struct {
+    triobj* obj;
+    Camera* camera;
+    Framebuffer* fb;
+} DatosRasterObjeto;
+
+/**
+ * Baraja los triángulos de un objeto (Fisher-Yates con un LCG fijo, para
+ * que todas las ejecuciones vean el mismo orden).
+ */
+static void barajar_triangulos(Triangulo* t, int n) {
+    unsigned int semilla = 12345u;
+    for (int i = n - 1; i > 0; i--) {
+        semilla = semilla * 1664525u + 1013904223u;
+        int j = (int)(semilla % (unsigned int)(i + 1));
+        Triangulo aux = t[i];
+        t[i] = t[j];
+        t[j] = aux;
+    }
+}
+
+/**
+ * Esfera con los triángulos barajados y todo lo de crear_triobj() calculado
+ * sobre ese orden, como si viniera de un fichero.
+ */
+static triobj* esfera_barajada(long num_triangulos) {
+    triobj* generada = generar_esfera(80.0f, num_triangulos);
+    if (!generada)
+        return NULL;
+    Triangulo* triangulos = generada->triptr;
+    int n = generada->num_triangles;
+    generada->triptr = NULL;
+    liberar_triobj(generada);
+
+    barajar_triangulos(triangulos, n);
+    triobj* obj = crear_triobj(triangulos, n);
+    if (!obj)
+        free(triangulos);
+    return obj;
+}
+
+static void kernel_raster_objeto(void* ctx) {
+    DatosRasterObjeto* d = (DatosRasterObjeto*)ctx;
+    limpiar_framebuffer(d->fb, 0, 0, 0);
+    procesar_objeto(d->camera, PROJECTION_PERSPECTIVE | BACK_CULLING | MODO_CAMARA | CAMARA_ANALISIS, d->obj, d->fb,
+                    NULL);
+}
+
+/**
+ * Optimización de la caché de vértices: tiempo de optimizar_triobj() y
+ * rasterizado antes y después, sobre una esfera barajada.
+ */
+static void bench_optimizacion(BenchConfig* config) {
+    static const char* nombre_optimizar = "optimizar_malla";
+    long triangulos = (long)(BENCH_OPTIMIZAR_TRIANGULOS * config->escala);
+    triobj* obj = esfera_barajada(triangulos);
+    Framebuffer* fb = crear_framebuffer(800, 600);
+    if (!obj || !fb || config->num_resultados + 3 > BENCH_MAX_RESULTADOS) {
+        liberar_triobj(obj);
+        liberar_framebuffer(fb);
+        return;
+    }
+
+    View view;
+    Camera camera;
+    camera.view = &view;
+    update_camera(&camera, vector3(0.0f, 0.0f, 250.0f), vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+    DatosRasterObjeto d = {obj, &camera, fb};
+
+    BenchResultado* antes = bench_ejecutar(config, "raster_orden_fichero", kernel_raster_objeto, &d, obj->num_triangles);
+
+    EstadisticasOptimizacion stats;
+    double inicio = bench_now_ns();
+    int resultado = optimizar_triobj(obj, &stats);
+    double optimizar_ns = bench_now_ns() - inicio;
+
+    if (resultado == 0) {
+        BenchResultado* r = &config->resultados[config->num_resultados++];
+        memset(r, 0, sizeof(BenchResultado));
+        r->nombre = nombre_optimizar;
+        r->elementos = stats.triangulos;
+        r->min_ns = r->mediana_ns = optimizar_ns / stats.triangulos;
+
+        BenchResultado* despues = bench_ejecutar(config, "raster_optimizado", kernel_raster_objeto, &d, obj->num_triangles);
+        printf("%-24s %8.1f ms  %d triángulos, %d vértices  ACMR %.3f -> %.3f\n", nombre_optimizar, optimizar_ns / 1e6,
+               stats.triangulos, stats.vertices, stats.acmr_antes, stats.acmr_despues);
+        if (antes && despues)
+            printf("%-24s %8.2f ms -> %.2f ms por frame\n", "raster", antes->mediana_ns * obj->num_triangles / 1e6,
+                   despues->mediana_ns * obj->num_triangles / 1e6);
+    }
+
+    liberar_triobj(obj);
+    liberar_framebuffer(fb);
+}
+
+static void soltar_cache(char** rutas, int num_rutas) {
+    for (int i = 0; i < num_rutas; i++) {
+        int fd = open(rutas[i], O_RDONLY);
+        if (fd < 0)
+            continue;
+#ifdef POSIX_FADV_DONTNEED
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+        close(fd);
+    }
+}
+
+/**
+ * Ejecuta el benchmark de carga de escenas.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la preparación.
+ */
+int bench_carga(BenchConfig* config) {
+    static char rutas_fichero[BENCH_CARGA_FICHEROS][32];
+    static char nombres[4][32];
+    char* rutas[BENCH_CARGA_FICHEROS];
+
+    long total = config->triangulos > 0 ? config->triangulos : (long)(BENCH_CARGA_TRIANGULOS * config->escala);
+    long por_fichero = total / BENCH_CARGA_FICHEROS > 0 ? total / BENCH_CARGA_FICHEROS : 1;
+
+    int escritos = 0;
+    for (int i = 0; i < BENCH_CARGA_FICHEROS; i++) {
+        snprintf(rutas_fichero[i], sizeof(rutas_fichero[i]), "/tmp/bench_carga_XXXXXX");
+        int fd = mkstemp(rutas_fichero[i]);
+        if (fd < 0)
+            break;
+        close(fd);
+        rutas[escritos++] = rutas_fichero[i];
+
+        triobj* obj = i % 2 ? generar_cilindro(60.0f, 200.0f, por_fichero) : generar_esfera(80.0f, por_fichero);
+        int ok = obj && escribir_malla_trozos(rutas_fichero[i], obj, 0) >= 0;
+        liberar_triobj(obj);
+        if (!ok)
+            break;
+    }
+
+    int resultado = -1;
+    if (escritos == BENCH_CARGA_FICHEROS) {
+        int hilos[2] = {1, 0};
+
+        for (int h = 0; h < 2; h++) {
+            for (int caliente = 0; caliente < 2 && config->num_resultados < BENCH_MAX_RESULTADOS; caliente++) {
+                // Una carga previa deja los ficheros en caché para el caso caliente.
+                if (caliente)
+                    liberar_escena(cargar_escena(rutas, escritos, cargar_triangulos_trozos, hilos[h], NULL));
+                else
+                    soltar_cache(rutas, escritos);
+
+                EstadisticasCargaEscena stats;
+                triobj* lista = cargar_escena(rutas, escritos, cargar_triangulos_trozos, hilos[h], &stats);
+                liberar_escena(lista);
+
+                snprintf(nombres[h * 2 + caliente], sizeof(nombres[0]), "carga_%s_%s", h ? "paralela" : "secuencial",
+                         caliente ? "caliente" : "fria");
+                printf("%-24s %8.1f ms  %2d hilos  %ld triángulos en %d ficheros (%d fallidos)  "
+                       "lectura %.1f ms  postproceso %.1f ms  ACMR %.2f -> %.2f\n",
+                       nombres[h * 2 + caliente], stats.total_ms, stats.hilos, stats.triangulos, stats.ficheros,
+                       stats.fallidos, stats.lectura_ms, stats.postproceso_ms, stats.acmr_antes, stats.acmr_despues);
+
+                BenchResultado* r = &config->resultados[config->num_resultados++];
+                memset(r, 0, sizeof(BenchResultado));
+                r->nombre = nombres[h * 2 + caliente];
+                r->elementos = 1;
+                r->min_ns = r->mediana_ns = stats.total_ms * 1e6;
+            }
+        }
+        bench_optimizacion(config);
+        resultado = bench_informe(config);
+    }
+
+    for (int i = 0; i < escritos; i++)
+        unlink(rutas[i]);
+    return resultado;
+}
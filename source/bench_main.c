@@ -0,0 +1,78 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                             BENCHMARKS                              *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Punto de entrada del ejecutable de benchmarks. Sólo se compila con
+ * -DBENCHMARK, para no chocar con el main de la aplicación:
+ *
+ *   cc -O2 -DBENCHMARK -I. <todos los .c de source> -o bench <GL/GLUT> -lm -lpthread
+ *
+ * En Linux hace falta también -lEGL (o -DOSMESA y -lOSMesa) para el
+ * contexto sin ventana de la suite gl.
+ *   ./bench operaciones --reps 21 --csv ops.csv --baseline base.csv
+ ***********************************************************************/
+
+#ifdef BENCHMARK
+
+typedef struct {
+    const char* nombre;
+    int (*suite)(BenchConfig* config);
+} SuiteBenchmark;
+
+static const SuiteBenchmark suites[] = {
+    {"operaciones", bench_operaciones},
+    {"escena", bench_escena},
+    {"replay", bench_replay},
+    {"raster", bench_raster},
+    {"luces", bench_luces},
+    {"trozos", bench_trozos},
+    {"carga", bench_carga},
+    {"gl", bench_gl},
+    {"orden", bench_orden},
+    {"lotes", bench_lotes},
+    {"captura", bench_captura},
+};
+
+#define NUM_SUITES (int)(sizeof(suites) / sizeof(suites[0]))
+
+static void mostrar_uso(const char* programa) {
+    printf("Uso: %s <suite> [opciones]\n\nSuites:\n", programa);
+    for (int i = 0; i < NUM_SUITES; i++)
+        printf("  %s\n", suites[i].nombre);
+    printf("\nOpciones: --reps N --warmup N --escala F --csv ruta --json ruta\n"
+           "          --baseline ruta --guardar-baseline ruta --umbral 0.10\n"
+           "          --triangulos N --frames N --sesion ruta --ritmo-grabado 0|1\n"
+           "          --textura ruta.ppm --presupuesto MB\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        mostrar_uso(argv[0]);
+        return 1;
+    }
+
+    BenchConfig config;
+    bench_config_por_defecto(&config);
+    if (bench_parse_args(&config, argc - 2, argv + 2) != 0) {
+        mostrar_uso(argv[0]);
+        return 1;
+    }
+
+    for (int i = 0; i < NUM_SUITES; i++) {
+        if (strcmp(argv[1], suites[i].nombre) == 0) {
+            // Las regresiones se reflejan en el código de salida, útil para CI.
+            return suites[i].suite(&config) != 0 ? 2 : 0;
+        }
+    }
+
+    mostrar_uso(argv[0]);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,210 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                      BENCHMARK DE OPERACIONES                       *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Suite de microbenchmarks para los kernels matemáticos de operations.c
+ * y transformations.c. Los datos se generan una vez con semilla fija,
+ * de forma que las ejecuciones antes y después de una optimización sean
+ * comparables. Los resultados se acumulan en un sumidero volátil para
+ * que el compilador no elimine el trabajo.
+ ***********************************************************************/
+
+#define BENCH_OPERACIONES_ELEMENTOS (1 << 20)
+#define BENCH_OPERACIONES_SEMILLA 0x9E3779B9u
+
+typedef struct {
+    long n;
+    double matriz[16];
+    Punto* puntos;
+    Punto* resultado;
+    Vector3* vectores_a;
+    Vector3* vectores_b;
+    Vector3* vectores_resultado;
+    Triangulo* triangulos;
+    double (*matrices_a)[4][4];
+    double (*matrices_b)[4][4];
+    double (*matrices_resultado)[4][4];
+    float* angulos;
+    triobj objeto;
+} DatosOperaciones;
+
+static volatile float sumidero;
+
+static void kernel_mxp(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    for (long i = 0; i < d->n; i++)
+        mxp(&d->resultado[i], d->matriz, d->puntos[i]);
+    sumidero = d->resultado[d->n - 1].x;
+}
+
+static void kernel_matrix_multiplication(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    long n = d->n / 16;
+    for (long i = 0; i < n; i++)
+        matrix_multiplication(d->matrices_a[i], d->matrices_b[i], d->matrices_resultado[i]);
+    sumidero = (float)d->matrices_resultado[n - 1][3][3];
+}
+
+static void kernel_normalizar_vector(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    for (long i = 0; i < d->n; i++)
+        d->vectores_resultado[i] = normalizar_vector(d->vectores_a[i]);
+    sumidero = d->vectores_resultado[d->n - 1].x;
+}
+
+static void kernel_cross_product(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    for (long i = 0; i < d->n; i++)
+        d->vectores_resultado[i] = vector3_cross_product(d->vectores_a[i], d->vectores_b[i]);
+    sumidero = d->vectores_resultado[d->n - 1].x;
+}
+
+static void kernel_obtain_normal_vector(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    for (long i = 0; i < d->n; i++)
+        obtain_normal_vector(&d->triangulos[i], &d->vectores_resultado[i]);
+    sumidero = d->vectores_resultado[d->n - 1].x;
+}
+
+static void kernel_interpolacion_lineal(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    for (long i = 0; i < d->n; i++) {
+        // El punto de corte lleva la y fijada, como en la rasterización.
+        d->resultado[i].y = (d->triangulos[i].p1.y + d->triangulos[i].p2.y) * 0.5f;
+        interpolacion_lineal(&d->triangulos[i].p1, &d->triangulos[i].p2, &d->resultado[i]);
+    }
+    sumidero = d->resultado[d->n - 1].u;
+}
+
+static void kernel_calcular_centroide(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    Punto centro = calcular_centroide(&d->objeto);
+    sumidero = centro.x;
+}
+
+static void kernel_set_rotation_matrix(void* ctx) {
+    DatosOperaciones* d = (DatosOperaciones*)ctx;
+    static const char ejes[3] = {'x', 'y', 'z'};
+    long n = d->n / 16;
+    for (long i = 0; i < n; i++)
+        set_rotation_matrix(ejes[i % 3], d->angulos[i], d->matrices_resultado[i]);
+    sumidero = (float)d->matrices_resultado[n - 1][0][0];
+}
+
+static Punto punto_aleatorio(unsigned int* semilla) {
+    Punto p;
+    p.x = bench_random_float(semilla, -500.0f, 500.0f);
+    p.y = bench_random_float(semilla, -500.0f, 500.0f);
+    p.z = bench_random_float(semilla, -500.0f, 500.0f);
+    p.u = bench_random_float(semilla, 0.0f, 1.0f);
+    p.v = bench_random_float(semilla, 0.0f, 1.0f);
+    p.w = 1.0f;
+    return p;
+}
+
+static int reservar_datos(DatosOperaciones* d, long n) {
+    memset(d, 0, sizeof(DatosOperaciones));
+    d->n = n;
+    d->puntos = (Punto*)malloc(sizeof(Punto) * n);
+    d->resultado = (Punto*)malloc(sizeof(Punto) * n);
+    d->vectores_a = (Vector3*)malloc(sizeof(Vector3) * n);
+    d->vectores_b = (Vector3*)malloc(sizeof(Vector3) * n);
+    d->vectores_resultado = (Vector3*)malloc(sizeof(Vector3) * n);
+    d->triangulos = (Triangulo*)malloc(sizeof(Triangulo) * n);
+    d->matrices_a = malloc(sizeof(double[4][4]) * (n / 16));
+    d->matrices_b = malloc(sizeof(double[4][4]) * (n / 16));
+    d->matrices_resultado = malloc(sizeof(double[4][4]) * (n / 16));
+    d->angulos = (float*)malloc(sizeof(float) * (n / 16));
+
+    return d->puntos && d->resultado && d->vectores_a && d->vectores_b && d->vectores_resultado &&
+           d->triangulos && d->matrices_a && d->matrices_b && d->matrices_resultado && d->angulos;
+}
+
+static void liberar_datos(DatosOperaciones* d) {
+    free(d->puntos);
+    free(d->resultado);
+    free(d->vectores_a);
+    free(d->vectores_b);
+    free(d->vectores_resultado);
+    free(d->triangulos);
+    free(d->matrices_a);
+    free(d->matrices_b);
+    free(d->matrices_resultado);
+    free(d->angulos);
+}
+
+/**
+ * Ejecuta la suite de operaciones matemáticas.
+ * @param config Configuración común de benchmarks (repeticiones, salidas...).
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_operaciones(BenchConfig* config) {
+    DatosOperaciones d;
+    long n = (long)(BENCH_OPERACIONES_ELEMENTOS * config->escala);
+    if (n < 16)
+        n = 16;
+
+    if (!reservar_datos(&d, n)) {
+        printf("\nNo hay memoria para %ld elementos.\n", n);
+        liberar_datos(&d);
+        return -1;
+    }
+
+    unsigned int semilla = BENCH_OPERACIONES_SEMILLA;
+
+    // Matriz afín cualquiera: rotación en Y más traslación.
+    double rotacion[4][4];
+    set_rotation_matrix('y', 0.3f, rotacion);
+    memcpy(d.matriz, rotacion, sizeof(d.matriz));
+    d.matriz[3] = 10.0;
+    d.matriz[7] = -20.0;
+    d.matriz[11] = 5.0;
+
+    for (long i = 0; i < n; i++) {
+        d.puntos[i] = punto_aleatorio(&semilla);
+        d.resultado[i] = d.puntos[i];
+        d.vectores_a[i] = vector3(bench_random_float(&semilla, -1.0f, 1.0f),
+                                  bench_random_float(&semilla, -1.0f, 1.0f),
+                                  bench_random_float(&semilla, -1.0f, 1.0f));
+        d.vectores_b[i] = vector3(bench_random_float(&semilla, -1.0f, 1.0f),
+                                  bench_random_float(&semilla, -1.0f, 1.0f),
+                                  bench_random_float(&semilla, -1.0f, 1.0f));
+        d.triangulos[i].p1 = punto_aleatorio(&semilla);
+        d.triangulos[i].p2 = punto_aleatorio(&semilla);
+        d.triangulos[i].p3 = punto_aleatorio(&semilla);
+        // Evito divisiones por cero en la interpolación.
+        if (d.triangulos[i].p1.y == d.triangulos[i].p2.y)
+            d.triangulos[i].p2.y += 1.0f;
+    }
+
+    for (long i = 0; i < n / 16; i++) {
+        for (int f = 0; f < 4; f++) {
+            for (int c = 0; c < 4; c++) {
+                d.matrices_a[i][f][c] = bench_random_float(&semilla, -1.0f, 1.0f);
+                d.matrices_b[i][f][c] = bench_random_float(&semilla, -1.0f, 1.0f);
+            }
+        }
+        d.angulos[i] = bench_random_float(&semilla, -PI, PI);
+    }
+
+    d.objeto.triptr = d.triangulos;
+    d.objeto.num_triangles = (int)n;
+
+    bench_ejecutar(config, "mxp", kernel_mxp, &d, n);
+    bench_ejecutar(config, "matrix_multiplication", kernel_matrix_multiplication, &d, n / 16);
+    bench_ejecutar(config, "normalizar_vector", kernel_normalizar_vector, &d, n);
+    bench_ejecutar(config, "vector3_cross_product", kernel_cross_product, &d, n);
+    bench_ejecutar(config, "obtain_normal_vector", kernel_obtain_normal_vector, &d, n);
+    bench_ejecutar(config, "interpolacion_lineal", kernel_interpolacion_lineal, &d, n);
+    bench_ejecutar(config, "calcular_centroide", kernel_calcular_centroide, &d, n);
+    bench_ejecutar(config, "set_rotation_matrix", kernel_set_rotation_matrix, &d, n / 16);
+
+    liberar_datos(&d);
+    return bench_informe(config);
+}
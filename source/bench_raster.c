@@ -0,0 +1,589 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                      BENCHMARK DE RASTERIZADO                       *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Mide el rasterizado por software con textura en los casos que más
+ * castigan a la caché:
+ *
+ * - frontal: una malla de cara a la cámara, casi 1 texel por píxel.
+ * - oblicua: la misma malla tumbada como un suelo que se pierde a lo
+ *   lejos, donde la textura se recorre en vertical y minificada.
+ * - lejana: una rejilla de esferas pequeñas muy lejos de la cámara.
+ *
+ * Los triángulos se proyectan una sola vez con camera_pipeline(); lo que
+ * se mide es limpiar el framebuffer y rasterizar, y en el ns/píxel que se
+ * muestra se descuenta lo que cuesta limpiar por sí solo. Cada caso se mide
+ * con la pirámide de mipmaps y forzando el nivel 0, para ver lo que gana
+ * la selección de nivel, y con mipmaps y filtro bilineal.
+ *
+ * Aparte, se mide el muestreo solo (sin rasterizar) sobre spans girados
+ * 30 grados, a un texel por píxel: el texel más cercano escalar frente al
+ * bilineal SIMD con repetición y con límite al borde.
+ *
+ * También se mide la escena completa (rasterizar_escena) en un caso muy
+ * tapado: una pared de cara a la cámara con una rejilla de esferas detrás
+ * y unas pocas delante, sin oclusión y con OCLUSION_HIZ, en perspectiva y
+ * en ortográfica, con el recuento por frame de objetos ocluidos y
+ * visibles. Con OCLUSION_HIZ se avisa si no ha quedado ninguno ocluido.
+ *
+ * Y la escena de prueba vista desde 1, 2 y 4 cámaras alrededor, cada una
+ * en su framebuffer: llamando a rasterizar_escena() por cámara frente a
+ * rasterizar_vistas(), que comparte entre cámaras el paso a mundo. Se
+ * informa del coste de cada vista adicional y de los píxeles en que
+ * difieren las imágenes de los dos caminos en la primera cámara.
+ *
+ * Por último, el redibujado parcial (redibujar_escena) sobre la escena de
+ * prueba: redibujando entero cada frame, con la escena quieta y moviendo
+ * sólo la esfera, con la fracción de píxeles redibujados por frame.
+ *
+ * La textura es la de --textura (PPM P6) o, si no se indica o no se puede
+ * cargar, un tablero de ajedrez generado.
+ ***********************************************************************/
+
+#define BENCH_RASTER_ANCHO 640
+#define BENCH_RASTER_ALTO 480
+#define BENCH_RASTER_TEXTURA 2048 // 16 MB en RGBA8, no cabe en caché
+#define BENCH_RASTER_ESFERAS 8 // Por lado de la rejilla de esferas lejanas
+#define BENCH_MUESTREO_SPANS 256
+#define BENCH_OCLUSION_ESFERAS 10 // Por lado de la rejilla de detrás de la pared
+#define BENCH_VISTAS_MAX 4
+
+typedef struct {
+    Framebuffer* fb;
+    Textura* tex;
+    Triangulo* proyectados;
+    long num_triangulos;
+    unsigned int scene_status_mask;
+    long pixeles;
+} DatosRaster;
+
+static void kernel_limpiar(void* ctx) {
+    DatosRaster* d = (DatosRaster*)ctx;
+    limpiar_framebuffer(d->fb, 0, 0, 0);
+}
+
+static void kernel_raster(void* ctx) {
+    DatosRaster* d = (DatosRaster*)ctx;
+
+    limpiar_framebuffer(d->fb, 0, 0, 0);
+    long pixeles = 0;
+    for (long i = 0; i < d->num_triangulos; i++)
+        pixeles += rasterizar_triangulo(d->fb, &d->proyectados[i], d->tex, d->scene_status_mask);
+    d->pixeles = pixeles;
+}
+
+typedef struct {
+    Framebuffer* fb;
+    Textura* tex;
+    Camera* camera;
+    triobj* lista;
+    unsigned int scene_status_mask;
+    EstadisticasOclusion stats;
+} DatosOclusion;
+
+static void kernel_escena(void* ctx) {
+    DatosOclusion* d = (DatosOclusion*)ctx;
+    limpiar_framebuffer(d->fb, 0, 0, 0);
+    rasterizar_escena(d->fb, d->camera, d->scene_status_mask, d->lista, d->tex, &d->stats);
+}
+
+typedef struct {
+    Vista* vistas;
+    int num_vistas;
+    Textura* tex;
+    triobj* lista;
+    unsigned int scene_status_mask;
+} DatosVistas;
+
+static void kernel_vistas_separadas(void* ctx) {
+    DatosVistas* d = (DatosVistas*)ctx;
+    for (int v = 0; v < d->num_vistas; v++) {
+        limpiar_framebuffer(d->vistas[v].fb, 0, 0, 0);
+        d->vistas[v].triangulos =
+            rasterizar_escena(d->vistas[v].fb, d->vistas[v].camera, d->scene_status_mask, d->lista, d->tex, NULL);
+    }
+}
+
+static void kernel_vistas_compartidas(void* ctx) {
+    DatosVistas* d = (DatosVistas*)ctx;
+    for (int v = 0; v < d->num_vistas; v++)
+        limpiar_framebuffer(d->vistas[v].fb, 0, 0, 0);
+    rasterizar_vistas(d->vistas, d->num_vistas, d->scene_status_mask, d->lista, d->tex);
+}
+
+typedef struct {
+    Redibujado* redibujado;  // NULL para redibujar entero
+    Framebuffer* fb;
+    Camera* camera;
+    triobj* lista;
+    triobj* movil;           // Objeto que se mueve en cada frame, o NULL
+    unsigned int scene_status_mask;
+    long frames;
+} DatosRedibujo;
+
+static void kernel_redibujo(void* ctx) {
+    DatosRedibujo* d = (DatosRedibujo*)ctx;
+    if (d->movil)
+        d->movil->mptr->m[3] += (d->frames / 20) % 2 ? -2.0 : 2.0; // Va y viene
+    d->frames++;
+
+    if (d->redibujado) {
+        redibujar_escena(d->redibujado, d->fb, d->camera, d->scene_status_mask, d->lista, NULL);
+    } else {
+        limpiar_framebuffer(d->fb, 0, 0, 0);
+        rasterizar_escena(d->fb, d->camera, d->scene_status_mask, d->lista, NULL, NULL);
+    }
+}
+
+typedef struct {
+    Textura* tex;
+    float* u;
+    float* v;
+    unsigned int* rgba;
+} DatosMuestreo;
+
+static volatile unsigned int sumidero;
+
+/**
+ * Muestrea BENCH_MUESTREO_SPANS spans del ancho del framebuffer.
+ */
+static void kernel_muestreo(void* ctx) {
+    DatosMuestreo* d = (DatosMuestreo*)ctx;
+    for (int s = 0; s < BENCH_MUESTREO_SPANS; s++) {
+        size_t inicio = (size_t)s * BENCH_RASTER_ANCHO;
+        muestrear_span(d->tex, 0, &d->u[inicio], &d->v[inicio], BENCH_RASTER_ANCHO, &d->rgba[inicio]);
+    }
+    sumidero = d->rgba[0];
+}
+
+/**
+ * Mide el muestreo solo, con cada combinación de filtro y repetición.
+ */
+static int bench_muestreo(BenchConfig* config, Textura* tex) {
+    static const char* nombres[3] = {"muestreo_cercano", "muestreo_bilineal_repetir", "muestreo_bilineal_limitar"};
+    static const FiltroTextura filtros[3] = {TEXTURA_CERCANO, TEXTURA_BILINEAL, TEXTURA_BILINEAL};
+    static const RepeticionTextura repeticiones[3] = {TEXTURA_REPETIR, TEXTURA_REPETIR, TEXTURA_LIMITAR};
+
+    long pixeles = (long)BENCH_MUESTREO_SPANS * BENCH_RASTER_ANCHO;
+    DatosMuestreo d = {tex, (float*)malloc(sizeof(float) * pixeles), (float*)malloc(sizeof(float) * pixeles),
+                       (unsigned int*)malloc(sizeof(unsigned int) * pixeles)};
+    if (!d.u || !d.v || !d.rgba) {
+        free(d.u);
+        free(d.v);
+        free(d.rgba);
+        return -1;
+    }
+
+    // Spans girados 30 grados sobre la textura, empezando algo fuera de
+    // [0, 1] para que la repetición y el límite tengan trabajo.
+    float c = cosf(PI / 6.0f), s = sinf(PI / 6.0f);
+    for (int y = 0; y < BENCH_MUESTREO_SPANS; y++) {
+        for (int x = 0; x < BENCH_RASTER_ANCHO; x++) {
+            size_t i = (size_t)y * BENCH_RASTER_ANCHO + x;
+            d.u[i] = (x * c - y * s) / tex->nivel[0].ancho - 0.1f;
+            d.v[i] = (x * s + y * c) / tex->nivel[0].alto - 0.1f;
+        }
+    }
+
+    for (int k = 0; k < 3; k++) {
+        tex->filtro = filtros[k];
+        tex->repeticion = repeticiones[k];
+        BenchResultado* r = bench_ejecutar(config, nombres[k], kernel_muestreo, &d, pixeles);
+        if (r)
+            printf("%-26s %8.2f ns/píxel  %8.1f Mpíxel/s\n", nombres[k], r->mediana_ns, 1e3 / r->mediana_ns);
+    }
+    tex->filtro = TEXTURA_CERCANO;
+    tex->repeticion = TEXTURA_REPETIR;
+
+    free(d.u);
+    free(d.v);
+    free(d.rgba);
+    return 0;
+}
+
+/**
+ * Tablero de ajedrez con un degradado, para que los niveles de mipmap no
+ * sean todos del mismo gris.
+ */
+static int textura_procedural(Textura* tex) {
+    int lado = BENCH_RASTER_TEXTURA;
+    unsigned char* rgb = (unsigned char*)malloc((size_t)lado * lado * 3);
+    if (!rgb)
+        return -1;
+
+    for (int y = 0; y < lado; y++) {
+        for (int x = 0; x < lado; x++) {
+            unsigned char* p = &rgb[((size_t)y * lado + x) * 3];
+            int casilla = ((x >> 5) ^ (y >> 5)) & 1;
+            p[0] = casilla ? 230 : (unsigned char)(x / 2);
+            p[1] = casilla ? 230 : (unsigned char)(y / 2);
+            p[2] = casilla ? 230 : 40;
+        }
+    }
+
+    int resultado = crear_textura_rgb(rgb, lado, lado, tex);
+    free(rgb);
+    return resultado;
+}
+
+/**
+ * Proyecta todos los triángulos de la lista, quitando los de espaldas.
+ * @return Número de triángulos proyectados, o -1 si no hay memoria.
+ */
+static long proyectar_lista(Camera* camera, unsigned int scene_status_mask, triobj* lista, Triangulo** proyectados) {
+    long total = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr)
+        total += obj->num_triangles;
+
+    *proyectados = (Triangulo*)malloc(sizeof(Triangulo) * (total > 0 ? total : 1));
+    if (!*proyectados)
+        return -1;
+
+    long n = 0;
+    Vector3 normal;
+    for (triobj* obj = lista; obj; obj = obj->hptr) {
+        for (int i = 0; i < obj->num_triangles; i++) {
+            Triangulo* t = &(*proyectados)[n];
+            camera_pipeline(camera, scene_status_mask, t, &obj->triptr[i], obj->mptr->m);
+            obtain_normal_vector(t, &normal);
+            if (should_draw_polygon(normal, camera->vector_forward))
+                n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * Escena de cada caso: 0 frontal, 1 oblicua, 2 lejana.
+ */
+static triobj* escena_caso(int caso, long triangulos) {
+    if (caso < 2) {
+        // Cubre la pantalla entera a la distancia de la cámara.
+        triobj* malla = generar_malla_teselada(caso == 0 ? 1600.0f : 2000.0f, caso == 0 ? 1600.0f : 2000.0f, triangulos);
+        if (!malla)
+            return NULL;
+        double* m = malla->mptr->m;
+        if (caso == 0) {
+            // Media vuelta en Y para que mire a la cámara.
+            m[0] = m[10] = -1.0;
+        } else {
+            // Girada 80 grados en X (casi horizontal) y bajada: un suelo.
+            double a = 80.0 * PI / 180.0;
+            m[5] = cos(a);
+            m[6] = -sin(a);
+            m[9] = sin(a);
+            m[10] = cos(a);
+            m[7] = -120.0;
+            m[11] = 300.0;
+            // UVs repetidas para que el suelo tenga detalle de sobra, y
+            // sentido de giro invertido para que la cara de arriba sea la visible.
+            for (int i = 0; i < malla->num_triangles; i++) {
+                Triangulo* t = &malla->triptr[i];
+                Punto aux = t->p2;
+                t->p2 = t->p3;
+                t->p3 = aux;
+                Punto* p[3] = {&t->p1, &t->p2, &t->p3};
+                for (int k = 0; k < 3; k++) {
+                    p[k]->u *= 8.0f;
+                    p[k]->v *= 8.0f;
+                }
+            }
+        }
+        return malla;
+    }
+
+    // Esferas con bastante detalle, aunque cada una ocupe unos pocos píxeles.
+    long por_esfera = triangulos / 8;
+    triobj* lista = NULL;
+    for (int i = 0; i < BENCH_RASTER_ESFERAS * BENCH_RASTER_ESFERAS; i++) {
+        triobj* esfera = generar_esfera(200.0f, por_esfera);
+        if (!esfera) {
+            liberar_escena(lista);
+            return NULL;
+        }
+        esfera->mptr->m[3] = (i % BENCH_RASTER_ESFERAS - BENCH_RASTER_ESFERAS / 2 + 0.5) * 600.0;
+        esfera->mptr->m[7] = (i / BENCH_RASTER_ESFERAS - BENCH_RASTER_ESFERAS / 2 + 0.5) * 600.0;
+        esfera->mptr->m[11] = 6000.0;
+        esfera->hptr = lista;
+        lista = esfera;
+    }
+    return lista;
+}
+
+/**
+ * Escena tapada: pared de 1000x1000 en z = 0, rejilla de esferas detrás
+ * (más lejos de la cámara, z positiva como en el caso lejano; algunas
+ * asoman por los lados) y cuatro delante.
+ */
+static triobj* escena_oclusion(long triangulos) {
+    int num_esferas = BENCH_OCLUSION_ESFERAS * BENCH_OCLUSION_ESFERAS + 4;
+    long por_esfera = triangulos / num_esferas > 0 ? triangulos / num_esferas : 1;
+
+    triobj* lista = generar_malla_teselada(1000.0f, 1000.0f, 2 * por_esfera);
+    if (!lista)
+        return NULL;
+    lista->mptr->m[0] = lista->mptr->m[10] = -1.0; // De cara a la cámara
+
+    for (int i = 0; i < num_esferas; i++) {
+        triobj* esfera = generar_esfera(60.0f, por_esfera);
+        if (!esfera) {
+            liberar_escena(lista);
+            return NULL;
+        }
+        double* m = esfera->mptr->m;
+        if (i < BENCH_OCLUSION_ESFERAS * BENCH_OCLUSION_ESFERAS) {
+            m[3] = (i % BENCH_OCLUSION_ESFERAS - BENCH_OCLUSION_ESFERAS / 2 + 0.5) * 140.0;
+            m[7] = (i / BENCH_OCLUSION_ESFERAS - BENCH_OCLUSION_ESFERAS / 2 + 0.5) * 140.0;
+            m[11] = 400.0;
+        } else {
+            m[3] = (i % 2 ? 1 : -1) * 250.0;
+            m[7] = (i % 4 < 2 ? 1 : -1) * 250.0;
+            m[11] = -200.0;
+        }
+        esfera->hptr = lista->hptr;
+        lista->hptr = esfera;
+    }
+    return lista;
+}
+
+/**
+ * Mide la escena tapada sin oclusión y con la pirámide de profundidad, en
+ * perspectiva y en ortográfica.
+ */
+static int bench_oclusion(BenchConfig* config, Framebuffer* fb, Textura* tex, Camera* camera, unsigned int mask) {
+    static const char* nombres[2][2] = {{"escena_sin_oclusion", "escena_hiz"},
+                                        {"escena_orto_sin_oclusion", "escena_orto_hiz"}};
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(200000 * config->escala);
+
+    triobj* lista = escena_oclusion(triangulos);
+    if (!lista)
+        return -1;
+
+    for (int orto = 0; orto < 2; orto++) {
+        unsigned int proyeccion = orto ? (mask & ~PROJECTION_PERSPECTIVE) | PROJECTION_ORTOGRAPHIC : mask;
+        for (int hiz = 0; hiz < 2; hiz++) {
+            DatosOclusion d = {.fb = fb, .tex = tex, .camera = camera, .lista = lista,
+                               .scene_status_mask = proyeccion | (hiz ? OCLUSION_HIZ : 0)};
+            BenchResultado* r = bench_ejecutar(config, nombres[orto][hiz], kernel_escena, &d, 1);
+            if (!r)
+                continue;
+            printf("%-24s %8.3f ms/frame  %d objetos: %d fuera, %d oclusores, %d ocluidos, %d visibles  %ld triángulos\n",
+                   nombres[orto][hiz], r->mediana_ns / 1e6, d.stats.objetos, d.stats.fuera, d.stats.oclusores,
+                   d.stats.ocluidos, d.stats.visibles, d.stats.triangulos);
+            if (hiz && d.stats.ocluidos == 0)
+                printf("%-24s NINGÚN OBJETO OCLUIDO\n", nombres[orto][hiz]);
+        }
+    }
+
+    liberar_escena(lista);
+    return 0;
+}
+
+/**
+ * Mide la escena de prueba desde 1, 2 y 4 cámaras: una pasada por cámara
+ * frente a rasterizar_vistas().
+ */
+static int bench_vistas(BenchConfig* config, Textura* tex, unsigned int mask) {
+    static char nombres[3][2][32];
+    static const int num_vistas[3] = {1, 2, 4};
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(300000 * config->escala);
+
+    triobj* lista = generar_escena_prueba(triangulos);
+    if (!lista)
+        return -1;
+
+    View views[BENCH_VISTAS_MAX];
+    Camera cameras[BENCH_VISTAS_MAX];
+    Vista vistas[BENCH_VISTAS_MAX];
+    Framebuffer* fb_separadas[BENCH_VISTAS_MAX] = {NULL};
+    int ok = 1;
+    for (int v = 0; v < BENCH_VISTAS_MAX; v++) {
+        // Alrededor de la escena, a 90 grados una de otra.
+        float a = v * PI / 2.0f;
+        cameras[v].view = &views[v];
+        update_camera(&cameras[v], vector3(800.0f * sinf(a), 150.0f, 800.0f * cosf(a)), vector3(0.0f, 0.0f, 0.0f),
+                      vector3(0.0f, 1.0f, 0.0f));
+        vistas[v].camera = &cameras[v];
+        vistas[v].fb = crear_framebuffer(BENCH_RASTER_ANCHO, BENCH_RASTER_ALTO);
+        fb_separadas[v] = crear_framebuffer(BENCH_RASTER_ANCHO, BENCH_RASTER_ALTO);
+        ok = ok && vistas[v].fb && fb_separadas[v];
+    }
+
+    // Sin VERTICES_MUNDO en la pasada por cámara: es lo que se compara.
+    double ms[3][2] = {{0}};
+    for (int k = 0; k < 3 && ok; k++) {
+        Vista separadas[BENCH_VISTAS_MAX];
+        for (int v = 0; v < num_vistas[k]; v++)
+            separadas[v] = (Vista){&cameras[v], fb_separadas[v], 0, 0};
+
+        DatosVistas d[2] = {{separadas, num_vistas[k], tex, lista, mask},
+                            {vistas, num_vistas[k], tex, lista, mask | VERTICES_MUNDO}};
+        void (*kernels[2])(void*) = {kernel_vistas_separadas, kernel_vistas_compartidas};
+        for (int c = 0; c < 2; c++) {
+            snprintf(nombres[k][c], sizeof(nombres[k][c]), "vistas_%d_%s", num_vistas[k],
+                     c ? "compartidas" : "por_separado");
+            BenchResultado* r = bench_ejecutar(config, nombres[k][c], kernels[c], &d[c], 1);
+            ms[k][c] = r ? r->mediana_ns / 1e6 : 0.0;
+        }
+
+        long tris[2] = {0, 0};
+        for (int v = 0; v < num_vistas[k]; v++) {
+            tris[0] += separadas[v].triangulos;
+            tris[1] += vistas[v].triangulos;
+        }
+        for (int c = 0; c < 2; c++)
+            printf("%-24s %8.3f ms/frame  %ld triángulos\n", nombres[k][c], ms[k][c], tris[c]);
+    }
+
+    // Sólo la primera vista: en las que miran a z positiva el back culling
+    // de la pasada por cámara se queda con las caras de atrás.
+    long distintos = 0;
+    const unsigned char* a = fb_separadas[0] ? fb_separadas[0]->rgb : NULL;
+    const unsigned char* b = vistas[0].fb ? vistas[0].fb->rgb : NULL;
+    for (long i = 0; ok && i < (long)BENCH_RASTER_ANCHO * BENCH_RASTER_ALTO * 3; i += 3)
+        distintos += a[i] != b[i] || a[i + 1] != b[i + 1] || a[i + 2] != b[i + 2];
+    if (ok) {
+        // Coste de cada vista a partir de la primera.
+        printf("%-24s %8.3f ms por separado  %8.3f ms compartidas\n", "vista_adicional", (ms[2][0] - ms[0][0]) / 3.0,
+               (ms[2][1] - ms[0][1]) / 3.0);
+        printf("%-24s %ld píxeles distintos de %d en la primera vista\n", "", distintos,
+               BENCH_RASTER_ANCHO * BENCH_RASTER_ALTO);
+    }
+
+    for (int v = 0; v < BENCH_VISTAS_MAX; v++) {
+        liberar_framebuffer(vistas[v].fb);
+        liberar_framebuffer(fb_separadas[v]);
+    }
+    liberar_escena(lista);
+    return ok ? 0 : -1;
+}
+
+/**
+ * Mide el redibujado parcial frente a redibujar entero cada frame.
+ */
+static int bench_redibujo(BenchConfig* config, Framebuffer* fb, Camera* camera, unsigned int mask) {
+    static const char* nombres[3] = {"redibujo_completo", "redibujo_quieto", "redibujo_un_objeto"};
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(300000 * config->escala);
+
+    triobj* lista = generar_escena_prueba(triangulos);
+    if (!lista)
+        return -1;
+
+    for (int caso = 0; caso < 3; caso++) {
+        Redibujado* redibujado = caso > 0 ? crear_redibujado() : NULL;
+        if (caso > 0 && !redibujado) {
+            liberar_escena(lista);
+            return -1;
+        }
+        // La esfera es el segundo objeto de la escena de prueba.
+        DatosRedibujo d = {redibujado, fb, camera, lista, caso == 2 ? lista->hptr : NULL, mask, 0};
+        BenchResultado* r = bench_ejecutar(config, nombres[caso], kernel_redibujo, &d, 1);
+
+        if (r) {
+            printf("%-24s %10.4f ms/frame", nombres[caso], r->mediana_ns / 1e6);
+            if (redibujado) {
+                EstadisticasRedibujado stats;
+                redibujado_estadisticas(redibujado, &stats);
+                printf("  %ld frames: %ld sin cambios, %ld parciales, %ld completos  %.1f%% de los píxeles por frame",
+                       stats.frames, stats.sin_cambios, stats.parciales, stats.completos,
+                       100.0 * stats.pixeles / ((double)stats.frames * fb->ancho * fb->alto));
+            }
+            printf("\n");
+        }
+        liberar_redibujado(redibujado);
+    }
+
+    liberar_escena(lista);
+    return 0;
+}
+
+/**
+ * Ejecuta el benchmark de rasterizado.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_raster(BenchConfig* config) {
+    static const char* nombres[3][3] = {
+        {"raster_frontal_mip", "raster_frontal_nivel0", "raster_frontal_bilineal"},
+        {"raster_oblicua_mip", "raster_oblicua_nivel0", "raster_oblicua_bilineal"},
+        {"raster_lejana_mip", "raster_lejana_nivel0", "raster_lejana_bilineal"},
+    };
+
+    Textura tex;
+    if (!config->ruta_textura || cargar_textura_ppm(config->ruta_textura, &tex) != 0) {
+        if (textura_procedural(&tex) != 0)
+            return -1;
+    }
+    printf("Textura %dx%d, %d niveles de mipmap\n", tex.nivel[0].ancho, tex.nivel[0].alto, tex.niveles);
+
+    Framebuffer* fb = crear_framebuffer(BENCH_RASTER_ANCHO, BENCH_RASTER_ALTO);
+    if (!fb) {
+        liberar_textura(&tex);
+        return -1;
+    }
+
+    View view;
+    Camera camera;
+    camera.view = &view;
+    update_camera(&camera, vector3(0.0f, 0.0f, 800.0f), vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+    unsigned int mask = PROJECTION_PERSPECTIVE | BACK_CULLING | MODO_CAMARA | CAMARA_ANALISIS;
+
+    // Pocos triángulos grandes: aquí interesa el coste por píxel, no el de preparar triángulos.
+    DatosRaster vacio = {fb, &tex, NULL, 0, mask, 0};
+    BenchResultado* r_limpiar = bench_ejecutar(config, "raster_limpiar", kernel_limpiar, &vacio, 1);
+    double limpiar_ns = r_limpiar ? r_limpiar->mediana_ns : 0.0;
+    printf("%-24s %8.3f ms/frame\n", "raster_limpiar", limpiar_ns / 1e6);
+
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(2000 * config->escala);
+
+    for (int caso = 0; caso < 3; caso++) {
+        triobj* lista = escena_caso(caso, triangulos);
+        Triangulo* proyectados = NULL;
+        long n = lista ? proyectar_lista(&camera, mask, lista, &proyectados) : -1;
+        liberar_escena(lista);
+        if (n < 0) {
+            liberar_framebuffer(fb);
+            liberar_textura(&tex);
+            return -1;
+        }
+
+        DatosRaster d = {fb, &tex, proyectados, n, mask, 0};
+        int niveles = tex.niveles;
+        for (int variante = 0; variante < 3; variante++) {
+            // La variante sin mipmaps se consigue ocultando los niveles > 0.
+            tex.niveles = variante == 1 ? 1 : niveles;
+            tex.filtro = variante == 2 ? TEXTURA_BILINEAL : TEXTURA_CERCANO;
+            kernel_raster(&d);
+            long pixeles = d.pixeles;
+
+            BenchResultado* r = bench_ejecutar(config, nombres[caso][variante], kernel_raster, &d, pixeles);
+            if (r && pixeles > 0) {
+                double neto = (r->mediana_ns * pixeles - limpiar_ns) / pixeles;
+                printf("%-24s %8.2f ns/píxel  %8.1f Mpíxel/s  %ld píxeles  %ld triángulos\n",
+                       nombres[caso][variante], neto, 1e3 / neto, pixeles, n);
+            }
+        }
+        tex.niveles = niveles;
+        tex.filtro = TEXTURA_CERCANO;
+        free(proyectados);
+    }
+
+    int resultado = bench_oclusion(config, fb, &tex, &camera, mask);
+    if (resultado == 0)
+        resultado = bench_vistas(config, &tex, mask);
+    if (resultado == 0)
+        resultado = bench_redibujo(config, fb, &camera, mask);
+    liberar_framebuffer(fb);
+    if (resultado != 0 || bench_muestreo(config, &tex) != 0) {
+        liberar_textura(&tex);
+        return -1;
+    }
+    liberar_textura(&tex);
+    return bench_informe(config);
+}
@@ -0,0 +1,243 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <sys/resource.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                        BENCHMARK DE ESCENA                          *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Benchmark de extremo a extremo: se monta una escena procedural (cilindro,
+ * esfera y malla teselada) con el número total de triángulos pedido, se
+ * orbita la cámara con traslacion_orbita() un grado por frame y cada frame
+ * pasa todos los triángulos por camera_pipeline() y el back culling.
+ *
+ * Tras unos frames de calentamiento se mide el tiempo por frame en régimen
+ * estable y la memoria (tamaño de las mallas y pico de RSS). Por defecto se
+ * barren 1K, 10K, 100K y 1M triángulos; con --triangulos N se mide sólo N.
+ *
+ * Cada tamaño se mide cinco veces: con los triángulos tal cual, con
+ * niveles de detalle (NIVEL_DETALLE), con los vértices guardados en
+ * espacio mundo (VERTICES_MUNDO: la órbita sólo mueve la cámara, así que
+ * la copia se hace una vez), con el back culling por conos de normales
+ * (CONOS_NORMALES) y con la escena comprimida (comprimir_triobj), para
+ * ver memoria y tiempo de cada variante sobre la misma geometría. En la
+ * de niveles de detalle se informa también de cuánto se tarda en
+ * generarlos y de cuántos triángulos se ahorra la pipeline por frame, y
+ * en la de conos, de cómo han salido los grupos por frame.
+ ***********************************************************************/
+
+#define BENCH_ESCENA_FRAMES 120
+#define BENCH_ESCENA_MAX_TAMANOS 8
+
+typedef struct {
+    Camera* camera;
+    triobj* lista;
+    unsigned int scene_status_mask;
+    long triangulos_dibujados;
+    long triangulos_procesados;  // Suma por frame medido, con el nivel de detalle elegido
+    long frames;
+} DatosEscena;
+
+/**
+ * Un frame: un paso de órbita alrededor del primer objeto y la pipeline
+ * completa (modelo, vista, proyección y back culling) sobre toda la escena.
+ */
+static void kernel_frame(void* ctx) {
+    DatosEscena* d = (DatosEscena*)ctx;
+
+    FRAME_TIMING_INICIO(d->scene_status_mask);
+    traslacion_orbita('y', 1, d->camera, d->lista);
+    d->triangulos_dibujados = procesar_escena(d->camera, d->scene_status_mask, d->lista);
+    FRAME_TIMING_FIN();
+
+    for (const triobj* obj = d->lista; obj; obj = obj->hptr)
+        d->triangulos_procesados += obj->lod_actual > 0 ? obj->lods[obj->lod_actual - 1].num_triangles : obj->num_triangles;
+    d->frames++;
+}
+
+static long memoria_escena(const triobj* lista) {
+    long bytes = 0;
+    for (const triobj* obj = lista; obj; obj = obj->hptr)
+        bytes += (long)memoria_triobj(obj);
+    return bytes;
+}
+
+static long pico_rss_kb(void) {
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+#ifdef __APPLE__
+    return uso.ru_maxrss / 1024; // En macOS viene en bytes
+#else
+    return uso.ru_maxrss;
+#endif
+}
+
+/**
+ * Ejecuta el benchmark de escena.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_escena(BenchConfig* config) {
+    static const char* variantes[5] = {"", "_lod", "_mundo", "_conos", "_comprimida"};
+    static char nombres[BENCH_ESCENA_MAX_TAMANOS][5][48];
+    long tamanos[BENCH_ESCENA_MAX_TAMANOS] = {1000, 10000, 100000, 1000000};
+    int num_tamanos = 4;
+
+    if (config->triangulos > 0) {
+        tamanos[0] = config->triangulos;
+        num_tamanos = 1;
+    }
+
+    // Más frames por defecto que en los microbenchmarks, interesa el régimen estable.
+    BenchConfig config_frames = *config;
+    if (config->frames > 0)
+        config_frames.repeticiones = config->frames;
+    else if (config_frames.repeticiones < BENCH_ESCENA_FRAMES)
+        config_frames.repeticiones = BENCH_ESCENA_FRAMES;
+    if (config_frames.calentamiento < 10)
+        config_frames.calentamiento = 10;
+
+    for (int t = 0; t < num_tamanos; t++) {
+        triobj* lista = generar_escena_prueba(tamanos[t]);
+        if (!lista) {
+            printf("\nNo hay memoria para una escena de %ld triángulos.\n", tamanos[t]);
+            return -1;
+        }
+
+        long triangulos = 0;
+        for (triobj* obj = lista; obj; obj = obj->hptr)
+            triangulos += obj->num_triangles;
+
+        // Los niveles de detalle se generan antes de comprimir, que suelta triptr.
+        double inicio_lods = bench_now_ns();
+        int niveles = 0;
+        for (triobj* obj = lista; obj; obj = obj->hptr)
+            niveles += generar_lods(obj, LOD_NIVELES) > 0 ? obj->num_lods : 0;
+        double lods_ms = (bench_now_ns() - inicio_lods) / 1e6;
+
+        for (int variante = 0; variante < 5; variante++) {
+            if (variante == 4) {
+                for (triobj* obj = lista; obj; obj = obj->hptr) {
+                    liberar_lods(obj);
+                    comprimir_triobj(obj);
+                }
+            }
+
+            View view;
+            Camera camera;
+            camera.view = &view;
+            update_camera(&camera, vector3(0.0f, 150.0f, 800.0f), vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+
+            unsigned int mask = PROJECTION_PERSPECTIVE | BACK_CULLING | MODO_CAMARA | CAMARA_ANALISIS;
+            if (variante == 1)
+                mask |= NIVEL_DETALLE;
+            if (variante == 2)
+                mask |= VERTICES_MUNDO;
+            if (variante == 3)
+                mask |= CONOS_NORMALES;
+#ifdef PROFILING
+            // Compilando con -DPROFILING se quiere el desglose por etapas.
+            mask |= FRAME_TIMING;
+            frame_timing_reset();
+#endif
+            DatosEscena d = {&camera, lista, mask, 0, 0, 0};
+
+            snprintf(nombres[t][variante], sizeof(nombres[t][variante]), "frame_%ld_tris%s", triangulos,
+                     variantes[variante]);
+            BenchResultado* r = bench_ejecutar(&config_frames, nombres[t][variante], kernel_frame, &d, 1);
+
+            if (r) {
+                printf("%-30s %10.3f ms/frame (mediana)  %8.2f ns/tri  dibujados %ld  mallas %.1f MB  pico RSS %.1f MB\n",
+                       nombres[t][variante], r->mediana_ns / 1e6, r->mediana_ns / triangulos, d.triangulos_dibujados,
+                       memoria_escena(lista) / (1024.0 * 1024.0), pico_rss_kb() / 1024.0);
+                if (variante == 1) {
+                    double procesados = d.frames > 0 ? (double)d.triangulos_procesados / d.frames : triangulos;
+                    printf("%-30s %d niveles generados en %.1f ms  procesados %.0f de %ld tris/frame (%.1f%% menos)\n", "",
+                           niveles, lods_ms, procesados, triangulos, 100.0 * (1.0 - procesados / triangulos));
+                }
+                if (variante == 2) {
+                    long copia = 0;
+                    for (const triobj* obj = lista; obj; obj = obj->hptr)
+                        copia += obj->triangulos_mundo ? (long)(sizeof(Triangulo) + sizeof(Vector3)) * obj->num_triangles : 0;
+                    printf("%-30s copia en espacio mundo %.1f MB\n", "", copia / (1024.0 * 1024.0));
+                }
+                if (variante == 3) {
+                    // Incluye los frames de calentamiento y el primero, que construye los conos.
+                    EstadisticasConos conos;
+                    conos_estadisticas(lista, &conos);
+                    double grupos = conos.grupos > 0 ? (double)conos.grupos : 1.0;
+                    printf("%-30s grupos: %.1f%% descartados  %.1f%% dibujados  %.1f%% silueta (%.1f%% reutilizados)  "
+                           "caras probadas %.1f%%\n",
+                           "", 100.0 * conos.atras / grupos, 100.0 * conos.delante / grupos, 100.0 * conos.mixtos / grupos,
+                           100.0 * conos.reutilizados / grupos,
+                           100.0 * conos.triangulos_probados / (grupos * CONOS_TRIANGULOS_GRUPO));
+                }
+            }
+#ifdef PROFILING
+            print_frame_timing();
+#endif
+        }
+
+        liberar_escena(lista);
+    }
+
+    // Los resultados se han ido acumulando en la copia; los devuelvo a la config original.
+    memcpy(config->resultados, config_frames.resultados, sizeof(config->resultados));
+    config->num_resultados = config_frames.num_resultados;
+    return bench_informe(config);
+}
+
+/**
+ * Reproduce una sesión grabada (--sesion) sobre la escena de prueba y
+ * registra los percentiles del tiempo por frame como resultados, para
+ * poder compararlos contra una baseline igual que el resto de suites.
+ * La escena debe tener los mismos objetos que cuando se grabó; aquí se
+ * usa la procedural con --triangulos (100K por defecto).
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la sesión.
+ */
+int bench_replay(BenchConfig* config) {
+    if (!config->ruta_sesion) {
+        printf("\nFalta --sesion con el fichero grabado.\n");
+        return -1;
+    }
+
+    triobj* lista = generar_escena_prueba(config->triangulos > 0 ? config->triangulos : 100000);
+    if (!lista)
+        return -1;
+
+    View view_principal, view_secundaria;
+    Camera main_camera, secondary_camera;
+    main_camera.view = &view_principal;
+    secondary_camera.view = &view_secundaria;
+    update_camera(&main_camera, vector3(0.0f, 150.0f, 800.0f), vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+    copy_camera(&main_camera, &secondary_camera);
+
+    EscenaReplay escena = {&main_camera, &secondary_camera, lista};
+    EstadisticasReplay stats;
+    int resultado = reproducir_sesion(config->ruta_sesion, &escena, PROJECTION_PERSPECTIVE | BACK_CULLING,
+                                      config->ritmo_grabado, &stats);
+    liberar_escena(lista);
+
+    if (resultado != 0)
+        return -1;
+
+    printf("\n%ld eventos en %.1f ms  (p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms/frame)\n",
+           stats.eventos, stats.total_ms, stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms);
+
+    static const char* nombres[4] = {"replay_p50", "replay_p95", "replay_p99", "replay_max"};
+    double valores[4] = {stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms};
+    for (int i = 0; i < 4 && config->num_resultados < BENCH_MAX_RESULTADOS; i++) {
+        BenchResultado* r = &config->resultados[config->num_resultados++];
+        memset(r, 0, sizeof(BenchResultado));
+        r->nombre = nombres[i];
+        r->elementos = 1;
+        r->min_ns = r->mediana_ns = valores[i] * 1e6;
+    }
+
+    return bench_informe(config);
+}
@@ -0,0 +1,221 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                 BENCHMARK DE ORDENACIÓN POR PROFUNDIDAD             *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Compara la ordenación de lejos a cerca de depth_sort.c con un qsort
+ * sobre las mismas profundidades: las de la escena de prueba (1M de
+ * triángulos por defecto, --triangulos N) pasada por camera_pipeline().
+ *
+ *   orden_qsort          qsort de índices comparando profundidades.
+ *   orden_radix_1hilo    radix en un solo hilo, desde cero.
+ *   orden_radix_hilos    radix con un hilo por núcleo, desde cero.
+ *   orden_quieta         coherente con la cámara parada: el orden del
+ *                        frame anterior ya vale y sólo se comprueba.
+ *   orden_coherente      frames alternos desde dos poses a medio grado:
+ *                        cada frame parte del orden del anterior.
+ *
+ * Tras cada kernel se comprueba que el resultado está ordenado. Al final
+ * se ordena la primera pose en perspectiva y en ortográfica y se
+ * comprueba que el primer triángulo devuelto es el de z de vista más
+ * negativa, es decir, el más lejano.
+ ***********************************************************************/
+
+#define BENCH_ORDEN_TRIANGULOS 1000000
+#define BENCH_ORDEN_GIRO 0.5f  // Grados entre las dos poses del kernel coherente
+
+typedef struct {
+    OrdenProfundidad* orden;
+    float* profundidad[2];  // Una por pose
+    int* indices;           // Para qsort
+    const int* resultado;
+    int n;
+    int coherente;
+    int alternar;           // Cambiar de pose en cada frame
+    int pose;
+} DatosOrden;
+
+static const float* profundidad_qsort;
+
+static int comparar_profundidad(const void* a, const void* b) {
+    float pa = profundidad_qsort[*(const int*)a];
+    float pb = profundidad_qsort[*(const int*)b];
+    return (pa < pb) - (pa > pb);
+}
+
+static void kernel_qsort(void* ctx) {
+    DatosOrden* d = (DatosOrden*)ctx;
+    for (int i = 0; i < d->n; i++)
+        d->indices[i] = i;
+    profundidad_qsort = d->profundidad[0];
+    qsort(d->indices, (size_t)d->n, sizeof(int), comparar_profundidad);
+    d->resultado = d->indices;
+}
+
+static void kernel_radix(void* ctx) {
+    DatosOrden* d = (DatosOrden*)ctx;
+    d->pose ^= d->alternar;
+    d->resultado = ordenar_por_profundidad(d->orden, d->profundidad[d->pose], d->n, d->coherente);
+}
+
+/**
+ * Profundidad de cada triángulo de la escena vista desde la cámara.
+ */
+static int proyectar_escena(triobj* lista, Camera* camera, unsigned int mask, float* profundidad) {
+    Triangulo procesado;
+    int n = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr) {
+        for (int i = 0; i < obj->num_triangles; i++) {
+            camera_pipeline(camera, mask, &procesado, &obj->triptr[i], obj->mptr->m);
+            profundidad[n++] = profundidad_triangulo(&procesado, mask);
+        }
+    }
+    return n;
+}
+
+/**
+ * Comprueba que el primero de un orden es el triángulo más lejano: el de
+ * z de vista media más negativa, calculada aquí con la matriz de vista sin
+ * pasar por la proyección ni por profundidad_triangulo().
+ */
+static int primero_mas_lejano(triobj* lista, Camera* camera, const int* resultado) {
+    float mas_lejos = INFINITY, primero = 0.0f;
+    int n = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr) {
+        for (int i = 0; i < obj->num_triangles; i++, n++) {
+            const Punto* p[3] = {&obj->triptr[i].p1, &obj->triptr[i].p2, &obj->triptr[i].p3};
+            const double* fila_z = camera->view->matrix[2];
+            float z = 0.0f;
+            for (int k = 0; k < 3; k++) {
+                Punto mundo;
+                mxp(&mundo, obj->mptr->m, *p[k]);
+                z += (float)(fila_z[0] * mundo.x + fila_z[1] * mundo.y + fila_z[2] * mundo.z + fila_z[3]) / 3.0f;
+            }
+            if (z < mas_lejos)
+                mas_lejos = z;
+            if (n == resultado[0])
+                primero = z;
+        }
+    }
+    // Empates y redondeo: basta con que esté a la misma z que el más lejano.
+    return primero <= mas_lejos + 1e-3f * fabsf(mas_lejos);
+}
+
+static int comprobar_orden(const DatosOrden* d) {
+    const float* profundidad = d->profundidad[d->pose];
+    if (!d->resultado)
+        return 0;
+    for (int i = 1; i < d->n; i++)
+        if (profundidad[d->resultado[i - 1]] < profundidad[d->resultado[i]])
+            return 0;
+    return 1;
+}
+
+/**
+ * Ejecuta el benchmark de ordenación por profundidad.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la reserva.
+ */
+int bench_orden(BenchConfig* config) {
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(BENCH_ORDEN_TRIANGULOS * config->escala);
+    triobj* lista = generar_escena_prueba(triangulos);
+    if (!lista)
+        return -1;
+
+    int n = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr)
+        n += obj->num_triangles;
+
+    DatosOrden d = {NULL, {malloc(sizeof(float) * (size_t)n), malloc(sizeof(float) * (size_t)n)},
+                    malloc(sizeof(int) * (size_t)n), NULL, n, 0, 0, 0};
+    if (!d.profundidad[0] || !d.profundidad[1] || !d.indices) {
+        free(d.profundidad[0]);
+        free(d.profundidad[1]);
+        free(d.indices);
+        liberar_escena(lista);
+        return -1;
+    }
+
+    View view;
+    Camera camera;
+    camera.view = &view;
+    unsigned int mask = PROJECTION_PERSPECTIVE | MODO_CAMARA | CAMARA_ANALISIS;
+    float giro = BENCH_ORDEN_GIRO * (float)M_PI / 180.0f;
+    for (int pose = 0; pose < 2; pose++) {
+        update_camera(&camera, vector3(800.0f * sinf(giro * pose), 150.0f, 800.0f * cosf(giro * pose)),
+                      vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+        proyectar_escena(lista, &camera, mask, d.profundidad[pose]);
+    }
+
+    static const struct {
+        const char* nombre;
+        BenchKernel kernel;
+        int hilos;
+        int coherente;
+        int alternar;
+    } kernels[] = {
+        {"orden_qsort", kernel_qsort, 0, 0, 0},
+        {"orden_radix_1hilo", kernel_radix, 1, 0, 0},
+        {"orden_radix_hilos", kernel_radix, 0, 0, 0},
+        {"orden_quieta", kernel_radix, 0, 1, 0},
+        {"orden_coherente", kernel_radix, 0, 1, 1},
+    };
+
+    for (int k = 0; k < (int)(sizeof(kernels) / sizeof(kernels[0])); k++) {
+        d.orden = crear_orden_profundidad(kernels[k].hilos);
+        if (!d.orden)
+            break;
+        d.coherente = kernels[k].coherente;
+        d.alternar = kernels[k].alternar;
+        d.pose = 0;
+        d.resultado = NULL;
+
+        BenchResultado* r = bench_ejecutar(config, kernels[k].nombre, kernels[k].kernel, &d, n);
+        if (r) {
+            EstadisticasOrden stats;
+            orden_profundidad_estadisticas(d.orden, &stats);
+            printf("%-20s %8.3f ms  %6.2f ns/tri  %s", kernels[k].nombre, r->mediana_ns * n / 1e6, r->mediana_ns,
+                   comprobar_orden(&d) ? "ordenado" : "DESORDENADO");
+            if (kernels[k].kernel == kernel_radix) {
+                if (stats.por_insercion)
+                    printf("  por inserción, %ld desplazamientos", stats.desplazamientos);
+                else
+                    printf("  %d hilos, %d pasadas (%d saltadas)", stats.hilos, stats.pasadas, stats.pasadas_saltadas);
+            }
+            printf("\n");
+        }
+        liberar_orden_profundidad(d.orden);
+    }
+
+    // La primera pose en las dos proyecciones: el primero tiene que ser el más lejano.
+    update_camera(&camera, vector3(0.0f, 150.0f, 800.0f), vector3(0.0f, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+    static const struct {
+        const char* nombre;
+        unsigned int proyeccion;
+    } proyecciones[] = {
+        {"orden_perspectiva", PROJECTION_PERSPECTIVE},
+        {"orden_ortografica", PROJECTION_ORTOGRAPHIC},
+    };
+    for (int p = 0; p < 2; p++) {
+        OrdenProfundidad* orden = crear_orden_profundidad(0);
+        if (!orden)
+            break;
+        proyectar_escena(lista, &camera, proyecciones[p].proyeccion | MODO_CAMARA | CAMARA_ANALISIS, d.profundidad[0]);
+        const int* resultado = ordenar_por_profundidad(orden, d.profundidad[0], n, 0);
+        printf("%-20s %s\n", proyecciones[p].nombre,
+               resultado && primero_mas_lejano(lista, &camera, resultado) ? "el primero es el más lejano"
+                                                                           : "EL PRIMERO NO ES EL MÁS LEJANO");
+        liberar_orden_profundidad(orden);
+    }
+
+    free(d.profundidad[0]);
+    free(d.profundidad[1]);
+    free(d.indices);
+    liberar_escena(lista);
+    return bench_informe(config);
+}
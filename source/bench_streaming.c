@@ -0,0 +1,178 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                    BENCHMARK DE MALLAS POR TROZOS                   *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Escribe un terreno teselado enorme (1M triángulos por defecto, o
+ * --triangulos N) como malla troceada en un fichero temporal, lo suelta
+ * de memoria y lo recorre con la cámara en vuelo rasante: cada frame la
+ * cámara avanza, se actualiza la residencia y se procesan los trozos que
+ * ya están en memoria.
+ *
+ * Los frames van a ritmo de 60 Hz, como en la aplicación: el hilo de
+ * carga tiene el resto del frame para traer lo pedido. Se mide sólo el
+ * trabajo de cada frame y se cuentan los frames en los que algún trozo
+ * visible aún no estaba cargado (huecos en pantalla).
+ *
+ * Se mide con el presupuesto de --presupuesto MB (16 por defecto), menor
+ * que el fichero, y sin límite, y se informa de los trozos residentes, de
+ * las cargas y expulsiones y de la latencia de carga. Antes de cada
+ * pasada se pide al sistema que suelte el fichero de su caché
+ * (posix_fadvise), para que las primeras cargas vayan a disco; si /tmp
+ * es tmpfs las latencias serán las de memoria.
+ ***********************************************************************/
+
+#define BENCH_TROZOS_TRIANGULOS 1000000
+#define BENCH_TROZOS_LADO 8000.0f
+#define BENCH_TROZOS_PASO 40.0f   // Avance de la cámara por frame
+#define BENCH_TROZOS_FRAMES 200
+#define BENCH_TROZOS_PRESUPUESTO_MB 16.0
+#define BENCH_TROZOS_PERIODO_NS (1e9 / 60.0)
+
+typedef struct {
+    MallaTrozos* malla;
+    Camera* camera;
+    unsigned int scene_status_mask;
+    float x;
+    long triangulos_dibujados, trozos_visibles;
+} DatosTrozos;
+
+/**
+ * Un frame: la cámara avanza en X (volviendo al principio al llegar al
+ * borde), se actualiza la residencia y se procesa lo que hay en memoria.
+ */
+static void kernel_frame_trozos(void* ctx) {
+    DatosTrozos* d = (DatosTrozos*)ctx;
+
+    d->x += BENCH_TROZOS_PASO;
+    if (d->x > BENCH_TROZOS_LADO / 2)
+        d->x = -BENCH_TROZOS_LADO / 2;
+    update_camera(d->camera, vector3(d->x, 0.0f, 800.0f), vector3(d->x, 0.0f, 0.0f), vector3(0.0f, 1.0f, 0.0f));
+
+    d->trozos_visibles += actualizar_trozos(d->malla, d->camera, d->scene_status_mask);
+    d->triangulos_dibujados += procesar_malla_trozos(d->malla, d->camera, d->scene_status_mask);
+}
+
+static int comparar_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void esperar_hasta(double instante_ns) {
+    double espera = instante_ns - bench_now_ns();
+    if (espera <= 0.0)
+        return;
+    struct timespec ts = {(time_t)(espera / 1e9), (long)((long long)espera % 1000000000LL)};
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * Ejecuta el benchmark de mallas por trozos.
+ * @param config Configuración común de benchmarks.
+ * @return Número de regresiones frente a la baseline, -1 si falla la preparación.
+ */
+int bench_trozos(BenchConfig* config) {
+    long triangulos = config->triangulos > 0 ? config->triangulos : (long)(BENCH_TROZOS_TRIANGULOS * config->escala);
+    double presupuesto_mb = config->presupuesto_mb > 0.0 ? config->presupuesto_mb : BENCH_TROZOS_PRESUPUESTO_MB;
+
+    char ruta[] = "/tmp/bench_trozos_XXXXXX";
+    int fd = mkstemp(ruta);
+    if (fd < 0)
+        return -1;
+    close(fd);
+
+    triobj* terreno = generar_malla_teselada(BENCH_TROZOS_LADO, BENCH_TROZOS_LADO, triangulos);
+    int num_trozos = terreno ? escribir_malla_trozos(ruta, terreno, TROZOS_TRIANGULOS_POR_DEFECTO) : -1;
+    if (terreno)
+        triangulos = terreno->num_triangles;
+    liberar_triobj(terreno);
+    if (num_trozos < 0) {
+        unlink(ruta);
+        return -1;
+    }
+
+    FILE* f = fopen(ruta, "rb");
+    double fichero_mb = 0.0;
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        fichero_mb = ftell(f) / (1024.0 * 1024.0);
+        fclose(f);
+    }
+    printf("%ld triángulos en %d trozos, fichero de %.1f MB\n", triangulos, num_trozos, fichero_mb);
+
+    int frames = config->frames > 0 ? config->frames : BENCH_TROZOS_FRAMES;
+    double* tiempos = (double*)malloc(sizeof(double) * (size_t)frames);
+    if (!tiempos) {
+        unlink(ruta);
+        return -1;
+    }
+
+    static const char* nombres[2] = {"trozos_presupuesto", "trozos_sin_limite"};
+    double presupuestos[2] = {presupuesto_mb * 1024.0 * 1024.0, fichero_mb * 1024.0 * 1024.0 * 2.0};
+
+    for (int p = 0; p < 2 && config->num_resultados < BENCH_MAX_RESULTADOS; p++) {
+        fd = open(ruta, O_RDONLY);
+        if (fd >= 0) {
+#ifdef POSIX_FADV_DONTNEED
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+            close(fd);
+        }
+
+        MallaTrozos* malla = abrir_malla_trozos(ruta, (size_t)presupuestos[p]);
+        if (!malla)
+            break;
+
+        View view;
+        Camera camera;
+        camera.view = &view;
+        // Sin back culling: sólo interesa qué trozos llegan a procesarse.
+        DatosTrozos d = {malla, &camera, PROJECTION_PERSPECTIVE, -BENCH_TROZOS_LADO / 2, 0, 0};
+        EstadisticasTrozos stats;
+        long frames_con_huecos = 0;
+
+        double siguiente = bench_now_ns();
+        for (int f = 0; f < frames; f++) {
+            double inicio = bench_now_ns();
+            kernel_frame_trozos(&d);
+            tiempos[f] = bench_now_ns() - inicio;
+
+            malla_trozos_estadisticas(malla, &stats);
+            if (stats.visibles_sin_cargar > 0)
+                frames_con_huecos++;
+
+            siguiente += BENCH_TROZOS_PERIODO_NS;
+            esperar_hasta(siguiente);
+        }
+        cerrar_malla_trozos(malla);
+
+        qsort(tiempos, (size_t)frames, sizeof(double), comparar_double);
+        BenchResultado* r = &config->resultados[config->num_resultados++];
+        memset(r, 0, sizeof(BenchResultado));
+        r->nombre = nombres[p];
+        r->elementos = 1;
+        r->min_ns = tiempos[0];
+        r->mediana_ns = tiempos[frames / 2];
+
+        printf("%-20s %8.3f ms/frame  %7.0f tris/frame  %4.1f trozos visibles  huecos en %ld de %d frames\n"
+               "%-20s residentes %ld (%.1f de %.1f MB)  cargas %ld  expulsiones %ld  sin sitio %ld\n"
+               "%-20s latencia de carga media %.3f ms  max %.3f ms\n",
+               nombres[p], r->mediana_ns / 1e6, (double)d.triangulos_dibujados / frames,
+               (double)d.trozos_visibles / frames, frames_con_huecos, frames, "", stats.residentes,
+               stats.bytes_residentes / (1024.0 * 1024.0), stats.presupuesto / (1024.0 * 1024.0), stats.cargas,
+               stats.expulsiones, stats.sin_sitio, "", stats.latencia_media_ms, stats.latencia_max_ms);
+    }
+
+    free(tiempos);
+    unlink(ruta);
+    return bench_informe(config);
+}
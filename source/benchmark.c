@@ -0,0 +1,291 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <time.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                             BENCHMARKS                              *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo contiene la infraestructura común de los benchmarks:
+ * medición con calentamiento y repeticiones, cálculo de mínimo y mediana,
+ * volcado a CSV/JSON y comparación contra una baseline guardada, para
+ * marcar como regresión lo que empeore más allá de un umbral.
+ *
+ * Las suites concretas (operaciones, escena...) sólo registran sus
+ * kernels con bench_ejecutar y llaman a bench_informe al final.
+ ***********************************************************************/
+
+/**
+ * Devuelve el instante actual del reloj monotónico en nanosegundos.
+ * @return Nanosegundos desde un origen arbitrario.
+ */
+double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * Generador xorshift32. Determinista a propósito, para que dos ejecuciones
+ * de la misma suite trabajen exactamente con los mismos datos.
+ * @param estado Estado del generador (distinto de 0).
+ * @return Siguiente número pseudoaleatorio.
+ */
+unsigned int bench_random_u32(unsigned int* estado) {
+    unsigned int x = *estado;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *estado = x;
+    return x;
+}
+
+/**
+ * Número pseudoaleatorio en coma flotante dentro de un rango.
+ * @param estado Estado del generador.
+ * @param min, max Rango del valor devuelto.
+ * @return Valor en [min, max].
+ */
+float bench_random_float(unsigned int* estado, float min, float max) {
+    return min + (max - min) * (bench_random_u32(estado) / 4294967295.0f);
+}
+
+/**
+ * Configuración por defecto: 3 iteraciones de calentamiento, 15 medidas y
+ * un 10% de margen frente a la baseline.
+ * @param config Configuración a inicializar.
+ */
+void bench_config_por_defecto(BenchConfig* config) {
+    memset(config, 0, sizeof(BenchConfig));
+    config->calentamiento = 3;
+    config->repeticiones = 15;
+    config->umbral = 0.10;
+    config->escala = 1.0;
+}
+
+/**
+ * Interpreta las opciones comunes a todas las suites:
+ *   --reps N, --warmup N, --csv ruta, --json ruta, --baseline ruta,
+ *   --guardar-baseline ruta, --umbral 0.10, --escala F (tamaño de entrada),
+ *   --triangulos N y --frames N (suites de escena), --sesion ruta y
+ *   --ritmo-grabado 0|1 (reproducción de sesiones), --textura ruta
+ *   (rasterizado) y --presupuesto MB (mallas por trozos).
+ * @param config Configuración a rellenar.
+ * @param argc, argv Argumentos de línea de comandos.
+ * @return 0 si se han entendido todas las opciones, -1 en caso contrario.
+ */
+int bench_parse_args(BenchConfig* config, int argc, char** argv) {
+    for (int i = 0; i < argc; i++) {
+        const char* opcion = argv[i];
+        const char* valor = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!valor) {
+            printf("Falta el valor de %s\n", opcion);
+            return -1;
+        }
+
+        if (strcmp(opcion, "--reps") == 0)
+            config->repeticiones = atoi(valor);
+        else if (strcmp(opcion, "--warmup") == 0)
+            config->calentamiento = atoi(valor);
+        else if (strcmp(opcion, "--csv") == 0)
+            config->ruta_csv = valor;
+        else if (strcmp(opcion, "--json") == 0)
+            config->ruta_json = valor;
+        else if (strcmp(opcion, "--baseline") == 0)
+            config->ruta_baseline = valor;
+        else if (strcmp(opcion, "--guardar-baseline") == 0)
+            config->ruta_guardar_baseline = valor;
+        else if (strcmp(opcion, "--umbral") == 0)
+            config->umbral = atof(valor);
+        else if (strcmp(opcion, "--escala") == 0)
+            config->escala = atof(valor);
+        else if (strcmp(opcion, "--triangulos") == 0)
+            config->triangulos = atol(valor);
+        else if (strcmp(opcion, "--frames") == 0)
+            config->frames = atoi(valor);
+        else if (strcmp(opcion, "--sesion") == 0)
+            config->ruta_sesion = valor;
+        else if (strcmp(opcion, "--ritmo-grabado") == 0)
+            config->ritmo_grabado = atoi(valor);
+        else if (strcmp(opcion, "--textura") == 0)
+            config->ruta_textura = valor;
+        else if (strcmp(opcion, "--presupuesto") == 0)
+            config->presupuesto_mb = atof(valor);
+        else {
+            printf("Opción desconocida: %s\n", opcion);
+            return -1;
+        }
+        i++;
+    }
+
+    if (config->repeticiones < 1)
+        config->repeticiones = 1;
+    if (config->escala <= 0.0)
+        config->escala = 1.0;
+    return 0;
+}
+
+static int comparar_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Mide un kernel: lo ejecuta config->calentamiento veces sin medir y luego
+ * config->repeticiones veces, guardando mínimo y mediana por elemento.
+ * @param config Configuración de la suite, donde se acumulan los resultados.
+ * @param nombre Nombre del kernel (cadena estática).
+ * @param kernel Función a medir; procesa todos los elementos en cada llamada.
+ * @param ctx Datos del kernel.
+ * @param elementos Elementos procesados por llamada, para normalizar.
+ * @return Puntero al resultado registrado, o NULL si no caben más.
+ */
+BenchResultado* bench_ejecutar(BenchConfig* config, const char* nombre, BenchKernel kernel, void* ctx, long elementos) {
+    if (config->num_resultados >= BENCH_MAX_RESULTADOS)
+        return NULL;
+
+    for (int i = 0; i < config->calentamiento; i++)
+        kernel(ctx);
+
+    double* tiempos = (double*)malloc(sizeof(double) * config->repeticiones);
+    if (!tiempos)
+        return NULL;
+
+    for (int i = 0; i < config->repeticiones; i++) {
+        double inicio = bench_now_ns();
+        kernel(ctx);
+        tiempos[i] = (bench_now_ns() - inicio) / (double)(elementos > 0 ? elementos : 1);
+    }
+
+    qsort(tiempos, config->repeticiones, sizeof(double), comparar_double);
+
+    BenchResultado* resultado = &config->resultados[config->num_resultados++];
+    resultado->nombre = nombre;
+    resultado->elementos = elementos;
+    resultado->min_ns = tiempos[0];
+    resultado->mediana_ns = tiempos[config->repeticiones / 2];
+    resultado->baseline_ns = 0.0;
+    resultado->regresion = 0;
+
+    free(tiempos);
+    return resultado;
+}
+
+/**
+ * Carga la baseline (CSV nombre,min_ns,mediana_ns) y marca como regresión
+ * los kernels cuya mediana empeore más del umbral.
+ * @return Número de regresiones, o -1 si no se ha podido leer la baseline.
+ */
+static int comparar_con_baseline(BenchConfig* config) {
+    FILE* f = fopen(config->ruta_baseline, "r");
+    if (!f) {
+        printf("\nNo se ha podido abrir la baseline %s\n", config->ruta_baseline);
+        return -1;
+    }
+
+    char linea[256];
+    int regresiones = 0;
+    while (fgets(linea, sizeof(linea), f)) {
+        char nombre[128];
+        double min_ns, mediana_ns;
+        if (sscanf(linea, "%127[^,],%lf,%lf", nombre, &min_ns, &mediana_ns) != 3)
+            continue; // Cabecera u otras líneas
+
+        for (int i = 0; i < config->num_resultados; i++) {
+            BenchResultado* r = &config->resultados[i];
+            if (strcmp(r->nombre, nombre) != 0)
+                continue;
+
+            r->baseline_ns = mediana_ns;
+            if (mediana_ns > 0.0 && (r->mediana_ns - mediana_ns) / mediana_ns > config->umbral) {
+                r->regresion = 1;
+                regresiones++;
+            }
+        }
+    }
+
+    fclose(f);
+    return regresiones;
+}
+
+static int escribir_csv(const BenchConfig* config, const char* ruta) {
+    FILE* f = fopen(ruta, "w");
+    if (!f) {
+        printf("\nNo se ha podido escribir %s\n", ruta);
+        return -1;
+    }
+
+    fprintf(f, "nombre,min_ns,mediana_ns,elementos,baseline_ns,regresion\n");
+    for (int i = 0; i < config->num_resultados; i++) {
+        const BenchResultado* r = &config->resultados[i];
+        fprintf(f, "%s,%.4f,%.4f,%ld,%.4f,%d\n", r->nombre, r->min_ns, r->mediana_ns,
+                r->elementos, r->baseline_ns, r->regresion);
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static int escribir_json(const BenchConfig* config, const char* ruta) {
+    FILE* f = fopen(ruta, "w");
+    if (!f) {
+        printf("\nNo se ha podido escribir %s\n", ruta);
+        return -1;
+    }
+
+    fprintf(f, "{\n  \"repeticiones\": %d,\n  \"calentamiento\": %d,\n  \"resultados\": [\n",
+            config->repeticiones, config->calentamiento);
+    for (int i = 0; i < config->num_resultados; i++) {
+        const BenchResultado* r = &config->resultados[i];
+        fprintf(f, "    {\"nombre\": \"%s\", \"min_ns\": %.4f, \"mediana_ns\": %.4f, \"elementos\": %ld, "
+                   "\"baseline_ns\": %.4f, \"regresion\": %s}%s\n",
+                r->nombre, r->min_ns, r->mediana_ns, r->elementos, r->baseline_ns,
+                r->regresion ? "true" : "false", i + 1 < config->num_resultados ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    fclose(f);
+    return 0;
+}
+
+/**
+ * Imprime la tabla de resultados, los vuelca a CSV/JSON si se ha pedido,
+ * compara con la baseline y, opcionalmente, guarda la ejecución actual
+ * como nueva baseline.
+ * @param config Configuración con los resultados de la suite.
+ * @return Número de regresiones detectadas (0 si no hay baseline).
+ */
+int bench_informe(BenchConfig* config) {
+    int regresiones = 0;
+
+    if (config->ruta_baseline) {
+        regresiones = comparar_con_baseline(config);
+        if (regresiones < 0)
+            regresiones = 0;
+    }
+
+    printf("\n%-32s %14s %14s %14s\n", "Kernel", "min (ns/elem)", "mediana", "baseline");
+    for (int i = 0; i < config->num_resultados; i++) {
+        const BenchResultado* r = &config->resultados[i];
+        printf("%-32s %14.3f %14.3f %14.3f%s\n", r->nombre, r->min_ns, r->mediana_ns, r->baseline_ns,
+               r->regresion ? "  <-- REGRESION" : "");
+    }
+
+    if (config->ruta_csv)
+        escribir_csv(config, config->ruta_csv);
+    if (config->ruta_json)
+        escribir_json(config, config->ruta_json);
+    if (config->ruta_guardar_baseline)
+        escribir_csv(config, config->ruta_guardar_baseline);
+
+    if (regresiones > 0)
+        printf("\n%d regresiones por encima del %.0f%%\n", regresiones, config->umbral * 100.0);
+
+    return regresiones;
+}
@@ -190,16 +190,36 @@ void camera_pipeline(Camera* main_camera, unsigned int scene_mask, Triangulo* tr
      */
 
     // Ale, goazen.
+    // Con -DPROFILING y FRAME_TIMING activo, se mide cada etapa encadenando marcas.
+    TIMING_INICIO_MUESTREO(marca);
 
     // 1) Transformación del modelo
     mxp(&triangulo_procesado->p1, matriz_transformacion, triangulo->p1);
     mxp(&triangulo_procesado->p2, matriz_transformacion, triangulo->p2);
     mxp(&triangulo_procesado->p3, matriz_transformacion, triangulo->p3);
+    TIMING_ETAPA(ETAPA_MODELO, marca, 1);
+
+    // 2) y 3) Vista y proyección, lo mismo que para los vértices ya en mundo
+    camera_pipeline_mundo(main_camera, scene_mask, triangulo_procesado, triangulo_procesado);
+}
+
+/**
+ * Segunda mitad de camera_pipeline(): transformación de vista y proyección
+ * de un triángulo que ya está en espacio mundo (ver triangulos_mundo()),
+ * para los objetos cuya matriz no ha cambiado desde el frame anterior.
+ * @param main_camera Puntero a la cámara principal.
+ * @param scene_mask Máscara de configuración de la escena.
+ * @param triangulo_procesado Puntero al triángulo resultante (puede ser el mismo que el de entrada).
+ * @param triangulo_mundo Triángulo en espacio mundo.
+ */
+void camera_pipeline_mundo(Camera* main_camera, unsigned int scene_mask, Triangulo* triangulo_procesado, const Triangulo* triangulo_mundo){
+    TIMING_INICIO_MUESTREO(marca);
 
     // 2) Transformación de vista
-    mxp(&triangulo_procesado->p1, &main_camera->view->matrix[0][0], triangulo_procesado->p1);
-    mxp(&triangulo_procesado->p2, &main_camera->view->matrix[0][0], triangulo_procesado->p2);
-    mxp(&triangulo_procesado->p3, &main_camera->view->matrix[0][0], triangulo_procesado->p3);
+    mxp(&triangulo_procesado->p1, &main_camera->view->matrix[0][0], triangulo_mundo->p1);
+    mxp(&triangulo_procesado->p2, &main_camera->view->matrix[0][0], triangulo_mundo->p2);
+    mxp(&triangulo_procesado->p3, &main_camera->view->matrix[0][0], triangulo_mundo->p3);
+    TIMING_ETAPA(ETAPA_VISTA, marca, 1);
 
     // 3) Proyección
     double projection_matrix[4][4];
@@ -225,6 +245,7 @@ void camera_pipeline(Camera* main_camera, unsigned int scene_mask, Triangulo* tr
 
         apply_perspective_depth(triangulo_procesado, &punto1, &punto2, &punto3);
     }
+    TIMING_ETAPA(ETAPA_PROYECCION, marca, 1);
 }
 
 /**
@@ -236,6 +257,7 @@ void camera_pipeline(Camera* main_camera, unsigned int scene_mask, Triangulo* tr
  * @param secondary_camera Puntero a la cámara secundaria.
  */
 void swap_camera(unsigned int scene_status_mask, triobj* sel_ptr, Camera* main_camera, Camera* secondary_camera){
+     GRABAR_ENTRADA(ENTRADA_SWAP_CAMERA, 0, 0, scene_status_mask, sel_ptr);
 
      if(scene_status_mask & MODO_OBJETO){
          /**
@@ -1,4 +1,5 @@
 #include "headers/shared_defines.h"
+#include "headers/functions.h"
 
 /***********************************************************************
  *                                                                     *
@@ -9,9 +10,13 @@
 /***********************************************************************
  * Este archivo contiene funciones para el debugging y el registro,
  * incluyendo el mostrar datos de matrices, transformaciones, cámara,
- * banderas/flags de escena activas y vectores. Estas funciones son de
+ * banderas/flags de escena activas, vectores y tiempos por etapa. Estas funciones son de
  * bastante utilidad para el seguimiento y análisis de datos en tiempo
  * de ejecución.
+ *
+ * Si el registro de trazas asíncrono está arrancado (trace_iniciar), las
+ * funciones que se usan dentro del bucle de render emiten eventos en
+ * lugar de escribir en stdout.
  ***********************************************************************/
 
 
@@ -21,6 +26,13 @@
  * @param matrix Matriz 4x4 que se imprimirá.
  */
 void print_matrix(double matrix[4][4]) {
+    // Con el registro de trazas arrancado, una fila por evento y sin tocar stdout.
+    if (TRACE_ACTIVO()) {
+        for (int i = 0; i < 4; i++)
+            TRACE_INSTANTE("matrix", matrix[i][0], matrix[i][1], matrix[i][2], matrix[i][3]);
+        return;
+    }
+
     printf("Matrix:\n");
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
@@ -87,6 +99,16 @@ void print_transformations(const triobj* sel_ptr) {
  * @param camera Puntero a la estructura de la cámara que contiene los datos a imprimir.
  */
 void print_camera_data(const Camera* camera) {
+    if (TRACE_ACTIVO()) {
+        TRACE_INSTANTE("camera eye", camera->eye_position.x, camera->eye_position.y, camera->eye_position.z);
+        TRACE_INSTANTE("camera look_at", camera->look_at.x, camera->look_at.y, camera->look_at.z);
+        TRACE_INSTANTE("camera up", camera->vector_up.x, camera->vector_up.y, camera->vector_up.z);
+        TRACE_INSTANTE("camera forward", camera->vector_forward.x, camera->vector_forward.y, camera->vector_forward.z);
+        TRACE_INSTANTE("camera right", camera->vector_right.x, camera->vector_right.y, camera->vector_right.z);
+        print_matrix(camera->view->matrix);
+        return;
+    }
+
     printf("\n\n CAMERA DATA \n\n");
     printf("Eye Position: (%f, %f, %f)\n", camera->eye_position.x, camera->eye_position.y, camera->eye_position.z);
     printf("Look At: (%f, %f, %f)\n", camera->look_at.x, camera->look_at.y, camera->look_at.z);
@@ -153,6 +175,9 @@ void print_scene_mask(const int* scene_mask) {
     if (*scene_mask & CAMARA_VUELO) {
         printf("CAMARA_VUELO\n");
     }
+    if (*scene_mask & FRAME_TIMING) {
+        printf("FRAME_TIMING\n");
+    }
     printf("################## \n");
 }
 
@@ -162,5 +187,38 @@ void print_scene_mask(const int* scene_mask) {
  * @param vector Puntero al vector 3D a imprimir.
  */
 void print_vector(const Vector3* vector) {
+    if (TRACE_ACTIVO()) {
+        TRACE_INSTANTE("vector", vector->x, vector->y, vector->z);
+        return;
+    }
     printf("Vector: (x: %.2f, y: %.2f, z: %.2f)\n", vector->x, vector->y, vector->z);
-}
\ No newline at end of file
+}
+
+/**
+ * Imprime los percentiles p50/p95/p99 del tiempo por frame de cada etapa
+ * de la pipeline, junto con la media de triángulos que pasan por ella y
+ * lo que se han llevado las propias marcas de tiempo (descontado de los
+ * percentiles, ver frame_timing.c). Sólo hay datos compilando con
+ * -DPROFILING y con FRAME_TIMING activo.
+ */
+void print_frame_timing(void) {
+    double p50, p95, p99;
+    int frames = frame_timing_percentiles_frame(&p50, &p95, &p99);
+
+    if (frames == 0) {
+        printf("\nNo hay tiempos registrados (¿-DPROFILING y FRAME_TIMING?).\n");
+        return;
+    }
+
+    printf("\n\n FRAME TIMING (%d frames) \n\n", frames);
+    printf("%-12s %10s %10s %10s %14s %14s\n", "Etapa", "p50 (ms)", "p95 (ms)", "p99 (ms)", "Triangulos",
+           "Marcas (ms)");
+    for (int e = 0; e < NUM_ETAPAS; e++) {
+        double e50, e95, e99;
+        frame_timing_percentiles((EtapaPipeline)e, &e50, &e95, &e99);
+        printf("%-12s %10.3f %10.3f %10.3f %14.0f %14.3f\n", frame_timing_nombre_etapa((EtapaPipeline)e),
+               e50, e95, e99, frame_timing_media_triangulos((EtapaPipeline)e),
+               frame_timing_sobrecoste_ms((EtapaPipeline)e));
+    }
+    printf("%-12s %10.3f %10.3f %10.3f\n", "frame", p50, p95, p99);
+}
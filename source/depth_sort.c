@@ -0,0 +1,353 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                     ORDENACIÓN POR PROFUNDIDAD                      *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo ordena los triángulos de un frame de lejos a cerca, para
+ * el algoritmo del pintor y las transparencias: el camino de GL en modo
+ * inmediato no tiene z-buffer y dibuja en el orden del fichero. Con un
+ * qsort de millones de triángulos por frame no se llega.
+ *
+ * La clave es la profundidad en vista tras camera_pipeline() (la w que
+ * deja en cada vértice, que es -z de vista), convertida a un entero de
+ * 32 bits que se ordena igual que el float. Se ordenan los índices con un
+ * radix LSD de 4 pasadas de 8 bits: cada hilo cuenta los dígitos de su
+ * trozo, se calculan los desplazamientos de todos y cada hilo reparte el
+ * suyo, lo que deja el orden estable. Las pasadas en las que todos los
+ * triángulos tienen el mismo dígito (los bits altos, cuando la escena
+ * ocupa poco rango de profundidad) se saltan.
+ *
+ * Los buffers se guardan entre frames y sólo crecen. Con coherente, se
+ * parte del orden del frame anterior con las profundidades nuevas y se
+ * arregla por inserción; si hay que mover demasiado (la cámara se ha
+ * movido de verdad) se abandona y se hace el radix.
+ ***********************************************************************/
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int total, esperando, generacion;
+} Barrera;
+
+struct OrdenProfundidad {
+    int hilos;
+    int capacidad;
+    unsigned int* claves[2];
+    int* indices[2];
+    int actual;               // Buffer con el último orden
+    int origen;               // Buffer del que parte el radix
+    int elementos_anteriores; // Triángulos del último orden, 0 si no hay
+
+    unsigned int histogramas[ORDEN_MAX_HILOS][ORDEN_CUBETAS];
+    int saltar;               // La pasada actual no cambia nada
+
+    EstadisticasOrden stats;
+};
+
+typedef struct {
+    OrdenProfundidad* orden;
+    const float* profundidad; // NULL si las claves ya están en el buffer de origen
+    int n, hilos, id;
+    Barrera* barrera;
+} TareaOrden;
+
+static void barrera_esperar(Barrera* b) {
+    if (b->total <= 1)
+        return;
+    pthread_mutex_lock(&b->mutex);
+    int generacion = b->generacion;
+    if (++b->esperando == b->total) {
+        b->esperando = 0;
+        b->generacion++;
+        pthread_cond_broadcast(&b->cond);
+    } else {
+        while (generacion == b->generacion)
+            pthread_cond_wait(&b->cond, &b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+}
+
+/**
+ * Pasa la profundidad a una clave entera que, ordenada de menor a mayor,
+ * deja primero lo más lejano: se invierten los negativos para que el
+ * orden de los bits sea el del float y luego se niega todo.
+ */
+static inline unsigned int clave_profundidad(float profundidad) {
+    unsigned int bits;
+    memcpy(&bits, &profundidad, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return ~bits;
+}
+
+/**
+ * Trabajo de un hilo: claves de su trozo (si no vienen ya hechas del
+ * intento por inserción) y las 4 pasadas, sincronizando
+ * con los demás entre contar, calcular desplazamientos y repartir.
+ */
+static void* hilo_radix(void* arg) {
+    TareaOrden* t = (TareaOrden*)arg;
+    OrdenProfundidad* orden = t->orden;
+
+    pthread_mutex_lock(&t->barrera->mutex);
+    while (t->barrera->total == 0)
+        pthread_cond_wait(&t->barrera->cond, &t->barrera->mutex);
+    pthread_mutex_unlock(&t->barrera->mutex);
+
+    int inicio = (int)((long)t->n * t->id / t->hilos);
+    int fin = (int)((long)t->n * (t->id + 1) / t->hilos);
+
+    int origen = orden->origen;
+    if (t->profundidad) {
+        for (int i = inicio; i < fin; i++) {
+            orden->claves[origen][i] = clave_profundidad(t->profundidad[i]);
+            orden->indices[origen][i] = i;
+        }
+    }
+
+    for (int pasada = 0; pasada < 4; pasada++) {
+        int desplazamiento = pasada * 8;
+        unsigned int* histograma = orden->histogramas[t->id];
+        const unsigned int* claves = orden->claves[origen];
+
+        memset(histograma, 0, sizeof(orden->histogramas[0]));
+        for (int i = inicio; i < fin; i++)
+            histograma[(claves[i] >> desplazamiento) & 0xFF]++;
+        barrera_esperar(t->barrera);
+
+        // Un solo hilo pasa los recuentos a posiciones de inicio: por
+        // dígito y, dentro de cada dígito, en el orden de los hilos.
+        if (t->id == 0) {
+            orden->saltar = 0;
+            unsigned int posicion = 0;
+            for (int d = 0; d < ORDEN_CUBETAS; d++) {
+                unsigned int inicio_digito = posicion;
+                for (int h = 0; h < t->hilos; h++) {
+                    unsigned int cuenta = orden->histogramas[h][d];
+                    orden->histogramas[h][d] = posicion;
+                    posicion += cuenta;
+                }
+                if (posicion - inicio_digito == (unsigned int)t->n)
+                    orden->saltar = 1;
+            }
+            if (orden->saltar)
+                orden->stats.pasadas_saltadas++;
+            else
+                orden->stats.pasadas++;
+        }
+        barrera_esperar(t->barrera);
+
+        if (!orden->saltar) {
+            unsigned int* claves_destino = orden->claves[origen ^ 1];
+            int* indices_destino = orden->indices[origen ^ 1];
+            const int* indices = orden->indices[origen];
+            for (int i = inicio; i < fin; i++) {
+                unsigned int p = histograma[(claves[i] >> desplazamiento) & 0xFF]++;
+                claves_destino[p] = claves[i];
+                indices_destino[p] = indices[i];
+            }
+            origen ^= 1;
+        }
+        // Nadie empieza a contar la siguiente pasada hasta que todos han repartido.
+        barrera_esperar(t->barrera);
+    }
+
+    if (t->id == 0)
+        orden->actual = origen;
+    return NULL;
+}
+
+/**
+ * Arregla por inserción un orden casi bueno.
+ * @return 0 si ha quedado ordenado, -1 si se ha pasado del límite de desplazamientos.
+ */
+static int arreglar_por_insercion(unsigned int* claves, int* indices, int n, long maximo, long* desplazamientos) {
+    long movidos = 0;
+    for (int i = 1; i < n; i++) {
+        unsigned int clave = claves[i];
+        int indice = indices[i];
+        int j = i - 1;
+        while (j >= 0 && claves[j] > clave) {
+            claves[j + 1] = claves[j];
+            indices[j + 1] = indices[j];
+            j--;
+            if (++movidos > maximo) {
+                *desplazamientos = movidos;
+                // Se cierra el hueco: queda una permutación válida de la que
+                // puede partir el radix, que no depende del orden de entrada.
+                claves[j + 1] = clave;
+                indices[j + 1] = indice;
+                return -1;
+            }
+        }
+        claves[j + 1] = clave;
+        indices[j + 1] = indice;
+    }
+    *desplazamientos = movidos;
+    return 0;
+}
+
+static int reservar(OrdenProfundidad* orden, int n) {
+    if (n <= orden->capacidad)
+        return 0;
+    for (int b = 0; b < 2; b++) {
+        unsigned int* claves = (unsigned int*)realloc(orden->claves[b], sizeof(unsigned int) * (size_t)n);
+        if (claves)
+            orden->claves[b] = claves;
+        int* indices = (int*)realloc(orden->indices[b], sizeof(int) * (size_t)n);
+        if (indices)
+            orden->indices[b] = indices;
+        if (!claves || !indices)
+            return -1;
+    }
+    orden->capacidad = n;
+    return 0;
+}
+
+/**
+ * Crea un ordenador por profundidad. Los buffers se reservan en el primer
+ * frame y se reutilizan en los siguientes.
+ * @param hilos Hilos del radix (<= 0 para uno por núcleo).
+ * @return El ordenador, o NULL si no hay memoria.
+ */
+OrdenProfundidad* crear_orden_profundidad(int hilos) {
+    OrdenProfundidad* orden = (OrdenProfundidad*)calloc(1, sizeof(OrdenProfundidad));
+    if (!orden)
+        return NULL;
+    if (hilos <= 0)
+        hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1)
+        hilos = 1;
+    if (hilos > ORDEN_MAX_HILOS)
+        hilos = ORDEN_MAX_HILOS;
+    orden->hilos = hilos;
+    return orden;
+}
+
+/**
+ * Libera un ordenador y sus buffers.
+ * @param orden Ordenador, puede ser NULL.
+ */
+void liberar_orden_profundidad(OrdenProfundidad* orden) {
+    if (!orden)
+        return;
+    for (int b = 0; b < 2; b++) {
+        free(orden->claves[b]);
+        free(orden->indices[b]);
+    }
+    free(orden);
+}
+
+/**
+ * Profundidad en vista de un triángulo ya procesado por camera_pipeline():
+ * la media de la w de sus vértices en perspectiva (-z de vista) y de su
+ * -z en ortográfica, donde el triángulo se queda en espacio de vista y la
+ * z es más negativa cuanto más lejos (como en rasterizar_triangulo()).
+ * @param procesado Triángulo tal como sale de camera_pipeline().
+ * @param scene_status_mask Máscara de estado (tipo de proyección).
+ * @return Profundidad, mayor cuanto más lejos.
+ */
+float profundidad_triangulo(const Triangulo* procesado, unsigned int scene_status_mask) {
+    if (scene_status_mask & PROJECTION_PERSPECTIVE)
+        return (procesado->p1.w + procesado->p2.w + procesado->p3.w) * (1.0f / 3.0f);
+    return -(procesado->p1.z + procesado->p2.z + procesado->p3.z) * (1.0f / 3.0f);
+}
+
+/**
+ * Ordena n triángulos de lejos a cerca.
+ * @param orden Ordenador (guarda el orden para el frame siguiente).
+ * @param profundidad Profundidad de cada triángulo (profundidad_triangulo).
+ * @param n Número de triángulos.
+ * @param coherente Si es 1 y el frame anterior tenía los mismos triángulos,
+ *        se intenta arreglar su orden antes de ordenar desde cero.
+ * @return Índices de los triángulos de lejos a cerca (válidos hasta la
+ *         siguiente llamada), o NULL si no hay memoria.
+ */
+const int* ordenar_por_profundidad(OrdenProfundidad* orden, const float* profundidad, int n, int coherente) {
+    memset(&orden->stats, 0, sizeof(orden->stats));
+    orden->stats.elementos = n;
+    if (n <= 0 || reservar(orden, n) != 0) {
+        orden->elementos_anteriores = 0;
+        return n <= 0 ? orden->indices[orden->actual] : NULL;
+    }
+
+    orden->origen = 0;
+    if (coherente && orden->elementos_anteriores == n) {
+        const int* anterior = orden->indices[orden->actual];
+        int destino = orden->actual ^ 1;
+        unsigned int* claves = orden->claves[destino];
+        long desordenados = 0;
+        for (int i = 0; i < n; i++) {
+            orden->indices[destino][i] = anterior[i];
+            claves[i] = clave_profundidad(profundidad[anterior[i]]);
+            desordenados += i > 0 && claves[i - 1] > claves[i];
+        }
+        // Cada pareja vecina desordenada cuesta al menos un desplazamiento y
+        // casi siempre varios: si hay muchas, ni se intenta.
+        if (desordenados <= (long)(n * ORDEN_DESORDEN_MAX) &&
+            arreglar_por_insercion(claves, orden->indices[destino], n, (long)n * ORDEN_DESPLAZAMIENTOS_MAX,
+                                   &orden->stats.desplazamientos) == 0) {
+            orden->actual = destino;
+            orden->stats.por_insercion = 1;
+            return orden->indices[destino];
+        }
+        // Las claves ya están calculadas en destino: el radix parte de ahí.
+        orden->origen = destino;
+        profundidad = NULL;
+    }
+
+    // Con pocos triángulos no compensa repartir: cada hilo, al menos ORDEN_MIN_POR_HILO.
+    int hilos = n / ORDEN_MIN_POR_HILO;
+    if (hilos > orden->hilos)
+        hilos = orden->hilos;
+    if (hilos < 1)
+        hilos = 1;
+
+    // La barrera empieza cerrada (total 0): los hilos esperan a saber
+    // cuántos se han podido lanzar antes de repartirse el trabajo.
+    Barrera barrera = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0};
+    TareaOrden tareas[ORDEN_MAX_HILOS];
+    pthread_t ids[ORDEN_MAX_HILOS];
+    for (int h = 0; h < hilos; h++)
+        tareas[h] = (TareaOrden){orden, profundidad, n, hilos, h, &barrera};
+
+    int lanzados = 0;
+    for (int h = 1; h < hilos; h++) {
+        if (pthread_create(&ids[h], NULL, hilo_radix, &tareas[h]) != 0)
+            break;
+        lanzados++;
+    }
+    hilos = lanzados + 1;
+    pthread_mutex_lock(&barrera.mutex);
+    for (int h = 0; h < hilos; h++)
+        tareas[h].hilos = hilos;
+    barrera.total = hilos;
+    pthread_cond_broadcast(&barrera.cond);
+    pthread_mutex_unlock(&barrera.mutex);
+
+    hilo_radix(&tareas[0]);
+    for (int h = 1; h <= lanzados; h++)
+        pthread_join(ids[h], NULL);
+    pthread_mutex_destroy(&barrera.mutex);
+    pthread_cond_destroy(&barrera.cond);
+
+    orden->stats.hilos = hilos;
+    orden->elementos_anteriores = n;
+    return orden->indices[orden->actual];
+}
+
+/**
+ * Estadísticas de la última ordenación.
+ * @param orden Ordenador.
+ * @param stats Salida.
+ */
+void orden_profundidad_estadisticas(const OrdenProfundidad* orden, EstadisticasOrden* stats) {
+    *stats = orden->stats;
+}
@@ -0,0 +1,273 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                          REDIBUJADO PARCIAL                         *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo evita redibujar lo que no ha cambiado, para las pantallas
+ * que están siempre encendidas mostrando una escena casi quieta. La
+ * escena sólo cambia cuando se llama a una función de transformación o
+ * de cámara, y lo único que éstas tocan es la matriz de vista de la
+ * cámara y la matriz (o la cabeza del historial, mptr) de un objeto.
+ *
+ * Así que en cada frame se comparan con las del frame anterior:
+ *   - Si no ha cambiado nada, no se redibuja: el framebuffer conserva la
+ *     imagen anterior.
+ *   - Si ha cambiado la cámara, la proyección, el framebuffer o la lista
+ *     de objetos, se redibuja entero.
+ *   - Si sólo se han movido objetos, se ensucia la unión del rectángulo
+ *     que ocupaba cada uno en el frame anterior con el que ocupa ahora.
+ *     Los rectángulos que se solapan se juntan; en cada uno se limpia el
+ *     framebuffer, se recorta con framebuffer_recorte() y se rasterizan
+ *     todos los objetos que lo tocan, en el orden de la lista. El
+ *     resultado es el mismo que redibujando entero.
+ *
+ * Lo que no pasa por una matriz (cambiar los triángulos de un objeto,
+ * luces, texturas) no se detecta: después hay que llamar a
+ * invalidar_redibujado(). El fondo es negro, como en el resto del
+ * rasterizado por software.
+ ***********************************************************************/
+
+typedef struct {
+    const triobj* obj;
+    const mlist* mptr;
+    double m[16];
+    int visible;          // Si no, el objeto no ocupaba nada en pantalla
+    int x0, y0, x1, y1;   // Rectángulo [x0, x1) x [y0, y1) en píxeles
+} EstadoObjeto;
+
+typedef struct {
+    int x0, y0, x1, y1;
+} Rectangulo;
+
+struct Redibujado {
+    int valido;           // Hay una imagen anterior con la que comparar
+    const Framebuffer* fb;
+    int ancho, alto;
+    const Textura* tex;
+    unsigned int mascara;
+    double vista[4][4];
+
+    EstadoObjeto* objetos;
+    int num_objetos, capacidad;
+    EstadisticasRedibujado stats;
+};
+
+// Bits de la máscara que cambian la imagen aunque no se mueva nada.
+#define REDIBUJO_BITS_IMAGEN \
+    (PROJECTION_PERSPECTIVE | PROJECTION_ORTOGRAPHIC | BACK_CULLING | NIVEL_DETALLE | CONOS_NORMALES)
+
+/**
+ * Crea el estado del redibujado parcial. El primer frame se dibuja entero.
+ * @return Estado nuevo, o NULL si no hay memoria.
+ */
+Redibujado* crear_redibujado(void) {
+    return (Redibujado*)calloc(1, sizeof(Redibujado));
+}
+
+/**
+ * Libera el estado del redibujado parcial.
+ * @param r Estado.
+ */
+void liberar_redibujado(Redibujado* r) {
+    if (!r)
+        return;
+    free(r->objetos);
+    free(r);
+}
+
+/**
+ * Fuerza que el siguiente frame se dibuje entero, para los cambios que no
+ * se ven en las matrices (geometría, luces, texturas...).
+ * @param r Estado.
+ */
+void invalidar_redibujado(Redibujado* r) {
+    r->valido = 0;
+}
+
+/**
+ * Rectángulo del objeto en píxeles enteros, con un píxel de margen para
+ * que el redondeo del rasterizado no deje restos en el borde.
+ */
+static void rectangulo_objeto(const Framebuffer* fb, const double pv[4][4], unsigned int scene_status_mask,
+                              triobj* obj, EstadoObjeto* e) {
+    ObjetoPantalla o;
+    e->visible = objeto_en_pantalla(fb, pv, scene_status_mask, obj, &o);
+    if (!e->visible)
+        return;
+    e->x0 = (int)floorf(o.x0) - 1;
+    e->y0 = (int)floorf(o.y0) - 1;
+    e->x1 = (int)ceilf(o.x1) + 1;
+    e->y1 = (int)ceilf(o.y1) + 1;
+    if (e->x0 < 0) e->x0 = 0;
+    if (e->y0 < 0) e->y0 = 0;
+    if (e->x1 > fb->ancho) e->x1 = fb->ancho;
+    if (e->y1 > fb->alto) e->y1 = fb->alto;
+}
+
+static int se_solapan(const Rectangulo* a, int x0, int y0, int x1, int y1) {
+    return a->x0 < x1 && x0 < a->x1 && a->y0 < y1 && y0 < a->y1;
+}
+
+static void unir(Rectangulo* a, const Rectangulo* b) {
+    if (b->x0 < a->x0) a->x0 = b->x0;
+    if (b->y0 < a->y0) a->y0 = b->y0;
+    if (b->x1 > a->x1) a->x1 = b->x1;
+    if (b->y1 > a->y1) a->y1 = b->y1;
+}
+
+/**
+ * Añade un rectángulo sucio y junta los que se solapen. Si no caben, se
+ * queda uno solo con la unión de todos.
+ */
+static void ensuciar(Rectangulo* sucios, int* num_sucios, Rectangulo nuevo) {
+    if (nuevo.x0 >= nuevo.x1 || nuevo.y0 >= nuevo.y1)
+        return;
+
+    // Al crecer, el nuevo puede solapar otros que antes no tocaba.
+    for (int i = 0; i < *num_sucios;) {
+        if (se_solapan(&sucios[i], nuevo.x0, nuevo.y0, nuevo.x1, nuevo.y1)) {
+            unir(&nuevo, &sucios[i]);
+            sucios[i] = sucios[--*num_sucios];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (*num_sucios == REDIBUJO_MAX_RECTANGULOS) {
+        for (int i = 1; i < *num_sucios; i++)
+            unir(&sucios[0], &sucios[i]);
+        unir(&sucios[0], &nuevo);
+        *num_sucios = 1;
+        return;
+    }
+    sucios[(*num_sucios)++] = nuevo;
+}
+
+static TipoRedibujo redibujar_completo(Redibujado* r, Framebuffer* fb, Camera* camera, unsigned int scene_status_mask,
+                                       triobj* lista, const Textura* tex) {
+    framebuffer_recorte(fb, 0, 0, fb->ancho, fb->alto);
+    limpiar_framebuffer(fb, 0, 0, 0);
+    rasterizar_escena(fb, camera, scene_status_mask, lista, tex, NULL);
+    r->stats.completos++;
+    r->stats.pixeles += (long long)fb->ancho * fb->alto;
+    return REDIBUJO_COMPLETO;
+}
+
+/**
+ * Dibuja un frame redibujando sólo lo que ha cambiado desde el anterior.
+ * El framebuffer debe ser el mismo que en el frame anterior y nadie más
+ * debe haberlo tocado entre medias.
+ * @param r Estado del redibujado.
+ * @param fb Framebuffer, con la imagen del frame anterior.
+ * @param camera Cámara del frame.
+ * @param scene_status_mask Máscara de estado (proyección, BACK_CULLING...).
+ * @param lista Primer objeto de la escena.
+ * @param tex Textura (NULL para blanco).
+ * @return REDIBUJO_NINGUNO si la imagen anterior sigue valiendo (no hace
+ *         falta ni presentarla de nuevo), REDIBUJO_PARCIAL o REDIBUJO_COMPLETO.
+ */
+TipoRedibujo redibujar_escena(Redibujado* r, Framebuffer* fb, Camera* camera, unsigned int scene_status_mask,
+                              triobj* lista, const Textura* tex) {
+    r->stats.frames++;
+
+    int num_objetos = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr)
+        num_objetos++;
+
+    int completo = !r->valido || r->fb != fb || r->ancho != fb->ancho || r->alto != fb->alto || r->tex != tex ||
+                   (r->mascara & REDIBUJO_BITS_IMAGEN) != (scene_status_mask & REDIBUJO_BITS_IMAGEN) ||
+                   r->num_objetos != num_objetos ||
+                   memcmp(r->vista, camera->view->matrix, sizeof(r->vista)) != 0;
+
+    if (num_objetos > r->capacidad) {
+        EstadoObjeto* objetos = (EstadoObjeto*)realloc(r->objetos, sizeof(EstadoObjeto) * (size_t)num_objetos);
+        if (!objetos) {
+            // Sin memoria para seguir la pista, se dibuja entero y el siguiente también.
+            r->valido = 0;
+            return redibujar_completo(r, fb, camera, scene_status_mask, lista, tex);
+        }
+        r->objetos = objetos;
+        r->capacidad = num_objetos;
+    }
+
+    double pv[4][4];
+    matriz_proyeccion_vista(camera, scene_status_mask, pv);
+    framebuffer_recorte(fb, 0, 0, fb->ancho, fb->alto);
+
+    Rectangulo sucios[REDIBUJO_MAX_RECTANGULOS];
+    int num_sucios = 0;
+    int i = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr, i++) {
+        EstadoObjeto* e = &r->objetos[i];
+        if (!completo && e->obj != obj)
+            completo = 1;
+        if (!completo && e->mptr == obj->mptr && memcmp(e->m, obj->mptr->m, sizeof(e->m)) == 0)
+            continue;
+
+        // Dónde estaba y dónde está ahora.
+        if (!completo && e->visible)
+            ensuciar(sucios, &num_sucios, (Rectangulo){e->x0, e->y0, e->x1, e->y1});
+        e->obj = obj;
+        e->mptr = obj->mptr;
+        memcpy(e->m, obj->mptr->m, sizeof(e->m));
+        rectangulo_objeto(fb, (const double(*)[4])pv, scene_status_mask, obj, e);
+        if (!completo && e->visible)
+            ensuciar(sucios, &num_sucios, (Rectangulo){e->x0, e->y0, e->x1, e->y1});
+    }
+
+    r->valido = 1;
+    r->fb = fb;
+    r->ancho = fb->ancho;
+    r->alto = fb->alto;
+    r->tex = tex;
+    r->mascara = scene_status_mask;
+    r->num_objetos = num_objetos;
+    memcpy(r->vista, camera->view->matrix, sizeof(r->vista));
+
+    if (!completo && num_sucios == 0) {
+        r->stats.sin_cambios++;
+        return REDIBUJO_NINGUNO;
+    }
+
+    long long pixeles = 0;
+    for (int k = 0; k < num_sucios; k++)
+        pixeles += (long long)(sucios[k].x1 - sucios[k].x0) * (sucios[k].y1 - sucios[k].y0);
+    // Con media pantalla sucia sale más a cuenta una sola pasada por los objetos.
+    if (completo || pixeles > REDIBUJO_FRACCION_COMPLETO * fb->ancho * fb->alto)
+        return redibujar_completo(r, fb, camera, scene_status_mask, lista, tex);
+
+    // La pirámide de oclusión es de toda la pantalla; aquí no se usa.
+    unsigned int mascara = scene_status_mask & ~OCLUSION_HIZ;
+    for (int k = 0; k < num_sucios; k++) {
+        const Rectangulo* s = &sucios[k];
+        limpiar_rectangulo(fb, s->x0, s->y0, s->x1, s->y1, 0, 0, 0);
+        framebuffer_recorte(fb, s->x0, s->y0, s->x1, s->y1);
+        i = 0;
+        for (triobj* obj = lista; obj; obj = obj->hptr, i++) {
+            const EstadoObjeto* e = &r->objetos[i];
+            if (e->visible && se_solapan(s, e->x0, e->y0, e->x1, e->y1))
+                procesar_objeto(camera, mascara, obj, fb, tex);
+        }
+    }
+    framebuffer_recorte(fb, 0, 0, fb->ancho, fb->alto);
+
+    r->stats.parciales++;
+    r->stats.rectangulos = num_sucios;
+    r->stats.pixeles += pixeles;
+    return REDIBUJO_PARCIAL;
+}
+
+/**
+ * Copia los contadores del redibujado parcial.
+ * @param r Estado.
+ * @param stats Salida.
+ */
+void redibujado_estadisticas(const Redibujado* r, EstadisticasRedibujado* stats) {
+    *stats = r->stats;
+}
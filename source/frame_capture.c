@@ -0,0 +1,280 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <pthread.h>
+#include <time.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                          CAPTURA DE FRAMES                          *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo guarda secuencias de frames (para compararlas o montar un
+ * vídeo) sin que el hilo de render espere al disco. Escribir cada frame
+ * con guardar_framebuffer_ppm() en el propio frame cuesta tanto como
+ * renderizarlo.
+ *
+ * capturar_frame() sólo copia el framebuffer a un buffer libre de un
+ * pool fijo y lo encola; un hilo escritor va sacando los buffers de la
+ * cola, los escribe y los devuelve al pool. Como formatos, un PPM P6 por
+ * frame (el de guardar_ppm(), que lee cargar_textura_ppm()) o todos los
+ * frames seguidos en crudo en un solo fichero, que es lo más rápido de
+ * escribir y lo que piden los codificadores de vídeo (rgb24).
+ *
+ * Si el disco no da abasto, el pool se vacía y hay que elegir: con
+ * CAPTURA_ESPERAR el render se bloquea hasta que se libere un buffer
+ * (no se pierde nada, el frame rate baja al del disco); con
+ * CAPTURA_DESCARTAR el frame se salta y se cuenta. Los frames se
+ * numeran por llamada, así que en PPM los descartados dejan un hueco en
+ * la numeración.
+ *
+ * La cola y el pool van con un mutex: se toca dos veces por frame, y lo
+ * caro (copiar y escribir) se hace fuera de él.
+ ***********************************************************************/
+
+#define CAPTURA_RUTA_MAX 256
+
+struct CapturaFrames {
+    char ruta[CAPTURA_RUTA_MAX];
+    FormatoCaptura formato;
+    PoliticaCaptura politica;
+    int ancho, alto;
+    size_t bytes_frame;
+    FILE* cruda;
+
+    int num_buffers;
+    unsigned char** buffers;
+    long* numero;      // Frame que tiene cada buffer
+    int* libres;       // Pila de buffers libres
+    int num_libres;
+    int* cola;         // Buffers pendientes, en orden de captura
+    int cola_inicio, cola_num;
+    long siguiente_frame;
+
+    pthread_t escritor;
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_pendientes;
+    pthread_cond_t hay_libres;
+    int cerrando;
+    EstadisticasCaptura stats;
+};
+
+static double ahora_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int escribir_buffer(CapturaFrames* captura, int b) {
+    if (captura->formato == CAPTURA_CRUDA)
+        return fwrite(captura->buffers[b], 1, captura->bytes_frame, captura->cruda) == captura->bytes_frame ? 0 : -1;
+
+    char ruta[CAPTURA_RUTA_MAX + 16];
+    snprintf(ruta, sizeof(ruta), "%s%05ld.ppm", captura->ruta, captura->numero[b]);
+    return guardar_ppm(ruta, captura->buffers[b], captura->ancho, captura->alto);
+}
+
+static void* hilo_escritor(void* arg) {
+    CapturaFrames* captura = (CapturaFrames*)arg;
+
+    pthread_mutex_lock(&captura->mutex);
+    for (;;) {
+        while (captura->cola_num == 0 && !captura->cerrando)
+            pthread_cond_wait(&captura->hay_pendientes, &captura->mutex);
+        // Al cerrar se vacía la cola antes de salir.
+        if (captura->cola_num == 0)
+            break;
+
+        int b = captura->cola[captura->cola_inicio];
+        captura->cola_inicio = (captura->cola_inicio + 1) % captura->num_buffers;
+        captura->cola_num--;
+        pthread_mutex_unlock(&captura->mutex);
+
+        double inicio = ahora_ms();
+        int resultado = escribir_buffer(captura, b);
+        double escritura_ms = ahora_ms() - inicio;
+
+        pthread_mutex_lock(&captura->mutex);
+        captura->stats.escritura_ms += escritura_ms;
+        captura->stats.en_cola--;
+        if (resultado == 0) {
+            captura->stats.escritos++;
+            captura->stats.bytes += (long long)captura->bytes_frame;
+        } else {
+            captura->stats.fallidos++;
+        }
+        captura->libres[captura->num_libres++] = b;
+        pthread_cond_signal(&captura->hay_libres);
+    }
+    pthread_mutex_unlock(&captura->mutex);
+    return NULL;
+}
+
+static void liberar_buffers(CapturaFrames* captura) {
+    for (int i = 0; captura->buffers && i < captura->num_buffers; i++)
+        free(captura->buffers[i]);
+    free(captura->buffers);
+    free(captura->numero);
+    free(captura->libres);
+    free(captura->cola);
+    if (captura->cruda)
+        fclose(captura->cruda);
+    free(captura);
+}
+
+/**
+ * Prepara una captura y arranca su hilo escritor.
+ * @param ruta En CAPTURA_PPM, prefijo de los ficheros (se añade el número
+ *        de frame y .ppm); en CAPTURA_CRUDA, el fichero único.
+ * @param formato CAPTURA_PPM o CAPTURA_CRUDA.
+ * @param ancho, alto Tamaño de los framebuffers que se van a capturar.
+ * @param buffers Tamaño del pool (<= 0 para CAPTURA_BUFFERS): frames que
+ *        pueden estar esperando al disco antes de aplicar la política.
+ * @param politica Qué hacer cuando no quedan buffers libres.
+ * @return Captura en marcha, o NULL si no hay memoria, no se puede abrir
+ *         el fichero o no se puede crear el hilo.
+ */
+CapturaFrames* crear_captura(const char* ruta, FormatoCaptura formato, int ancho, int alto, int buffers,
+                             PoliticaCaptura politica) {
+    if (ancho <= 0 || alto <= 0 || strlen(ruta) >= CAPTURA_RUTA_MAX)
+        return NULL;
+
+    CapturaFrames* captura = (CapturaFrames*)calloc(1, sizeof(CapturaFrames));
+    if (!captura)
+        return NULL;
+
+    strcpy(captura->ruta, ruta);
+    captura->formato = formato;
+    captura->politica = politica;
+    captura->ancho = ancho;
+    captura->alto = alto;
+    captura->bytes_frame = (size_t)ancho * alto * 3;
+    captura->num_buffers = buffers > 0 ? buffers : CAPTURA_BUFFERS;
+
+    int n = captura->num_buffers;
+    captura->buffers = (unsigned char**)calloc((size_t)n, sizeof(unsigned char*));
+    captura->numero = (long*)malloc(sizeof(long) * (size_t)n);
+    captura->libres = (int*)malloc(sizeof(int) * (size_t)n);
+    captura->cola = (int*)malloc(sizeof(int) * (size_t)n);
+    int ok = captura->buffers && captura->numero && captura->libres && captura->cola;
+    for (int i = 0; ok && i < n; i++) {
+        captura->buffers[i] = (unsigned char*)malloc(captura->bytes_frame);
+        ok = captura->buffers[i] != NULL;
+        captura->libres[i] = n - 1 - i;
+    }
+    captura->num_libres = n;
+
+    if (ok && formato == CAPTURA_CRUDA) {
+        captura->cruda = fopen(ruta, "wb");
+        if (!captura->cruda) {
+            printf("\nNo se ha podido abrir %s para la captura.\n", ruta);
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        liberar_buffers(captura);
+        return NULL;
+    }
+
+    pthread_mutex_init(&captura->mutex, NULL);
+    pthread_cond_init(&captura->hay_pendientes, NULL);
+    pthread_cond_init(&captura->hay_libres, NULL);
+    if (pthread_create(&captura->escritor, NULL, hilo_escritor, captura) != 0) {
+        pthread_mutex_destroy(&captura->mutex);
+        pthread_cond_destroy(&captura->hay_pendientes);
+        pthread_cond_destroy(&captura->hay_libres);
+        liberar_buffers(captura);
+        return NULL;
+    }
+    return captura;
+}
+
+/**
+ * Encola una copia del framebuffer para escribirla. Se llama desde el
+ * hilo de render, después de rasterizar el frame.
+ * @param captura Captura en marcha.
+ * @param fb Framebuffer del tamaño de la captura.
+ * @return 0 si se ha encolado, 1 si se ha descartado por falta de
+ *         buffers (CAPTURA_DESCARTAR), -1 si el tamaño no coincide.
+ */
+int capturar_frame(CapturaFrames* captura, const Framebuffer* fb) {
+    if (fb->ancho != captura->ancho || fb->alto != captura->alto)
+        return -1;
+
+    pthread_mutex_lock(&captura->mutex);
+    long frame = captura->siguiente_frame++;
+    if (captura->num_libres == 0) {
+        if (captura->politica == CAPTURA_DESCARTAR) {
+            captura->stats.descartados++;
+            pthread_mutex_unlock(&captura->mutex);
+            return 1;
+        }
+        double inicio = ahora_ms();
+        while (captura->num_libres == 0)
+            pthread_cond_wait(&captura->hay_libres, &captura->mutex);
+        captura->stats.esperas++;
+        captura->stats.espera_ms += ahora_ms() - inicio;
+    }
+    int b = captura->libres[--captura->num_libres];
+    pthread_mutex_unlock(&captura->mutex);
+
+    // El buffer es sólo de este hilo hasta que se encola.
+    memcpy(captura->buffers[b], fb->rgb, captura->bytes_frame);
+    captura->numero[b] = frame;
+
+    pthread_mutex_lock(&captura->mutex);
+    captura->cola[(captura->cola_inicio + captura->cola_num) % captura->num_buffers] = b;
+    captura->cola_num++;
+    captura->stats.encolados++;
+    if (++captura->stats.en_cola > captura->stats.max_en_cola)
+        captura->stats.max_en_cola = captura->stats.en_cola;
+    pthread_cond_signal(&captura->hay_pendientes);
+    pthread_mutex_unlock(&captura->mutex);
+    return 0;
+}
+
+/**
+ * Copia los contadores actuales de la captura (se pueden consultar con
+ * la captura en marcha, por ejemplo para mostrarlos en pantalla).
+ * @param captura Captura en marcha.
+ * @param stats Salida.
+ */
+void captura_estadisticas(CapturaFrames* captura, EstadisticasCaptura* stats) {
+    pthread_mutex_lock(&captura->mutex);
+    *stats = captura->stats;
+    pthread_mutex_unlock(&captura->mutex);
+}
+
+/**
+ * Escribe lo que quede en la cola, detiene el hilo escritor y libera
+ * la captura.
+ * @param captura Captura en marcha.
+ * @param stats Salida opcional: contadores finales.
+ * @return 0 si se han escrito todos los frames encolados, -1 si alguno ha fallado.
+ */
+int cerrar_captura(CapturaFrames* captura, EstadisticasCaptura* stats) {
+    pthread_mutex_lock(&captura->mutex);
+    captura->cerrando = 1;
+    pthread_cond_signal(&captura->hay_pendientes);
+    pthread_mutex_unlock(&captura->mutex);
+    pthread_join(captura->escritor, NULL);
+
+    // Lo que quede en el buffer de stdio del fichero crudo también cuenta.
+    if (captura->cruda) {
+        if (fclose(captura->cruda) != 0)
+            captura->stats.fallidos++;
+        captura->cruda = NULL;
+    }
+
+    pthread_mutex_destroy(&captura->mutex);
+    pthread_cond_destroy(&captura->hay_pendientes);
+    pthread_cond_destroy(&captura->hay_libres);
+
+    int resultado = captura->stats.fallidos == 0 ? 0 : -1;
+    if (stats)
+        *stats = captura->stats;
+    liberar_buffers(captura);
+    return resultado;
+}
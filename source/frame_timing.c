@@ -0,0 +1,257 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <time.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                     MEDICIÓN DE TIEMPOS (PROFILING)                 *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo implementa los temporizadores por etapa de la pipeline
+ * (modelo, vista, proyección, culling, clipping y raster). Durante el
+ * frame se acumulan los nanosegundos y triángulos de cada etapa, y al
+ * cerrarlo se guardan en un historial circular a partir del cual se
+ * calculan los percentiles p50/p95/p99.
+ *
+ * Modelo, vista, proyección, culling, clipping y raster van intercaladas
+ * triángulo a triángulo, así que se miden por triángulo. Cada marca es
+ * una llamada a clock_gettime() de unas decenas de nanosegundos, del
+ * orden de lo que se mide (tres mxp), y se la lleva la etapa que cierra.
+ * Para que no pese, desde cada punto del código sólo se mide una de cada
+ * FRAME_TIMING_MUESTREO llamadas (TIMING_INICIO_MUESTREO), y esa cuenta,
+ * en tiempo y en triángulos, por las FRAME_TIMING_MUESTREO; el contador
+ * de cada punto sigue de un frame a otro, así que el error es de una
+ * muestra por frame. Al cerrar el frame, a cada etapa se le resta lo
+ * que cuestan sus marcas (medido una vez, en el primer frame) con el
+ * mismo peso. Lo que sí se han llevado las marcas se informa aparte.
+ *
+ * Los acumuladores son globales, pero sólo los toca el hilo que abre el
+ * frame: frame_timing_activo es por hilo y se apaga al cerrarlo, así que
+ * los hilos de trabajo nunca miden.
+ *
+ * Todo lo que toca el camino caliente sólo existe compilando con
+ * -DPROFILING; sin él, las consultas devuelven 0 (sin datos).
+ ***********************************************************************/
+
+static const char* nombres_etapas[NUM_ETAPAS] = {
+    "modelo", "vista", "proyeccion", "culling", "clipping", "raster", "sombreado"
+};
+
+#ifdef PROFILING
+
+typedef struct {
+    // Acumuladores del frame en curso
+    unsigned long long acumulado_ns[NUM_ETAPAS];
+    unsigned long long triangulos[NUM_ETAPAS];
+    unsigned long long marcas[NUM_ETAPAS];            // Las que se han tomado
+    unsigned long long marcas_ponderadas[NUM_ETAPAS]; // Por su peso de muestreo
+    unsigned long long inicio_frame_ns;
+
+    // Historial circular, un valor por frame
+    unsigned long long historial_ns[NUM_ETAPAS][FRAME_TIMING_HISTORIAL];
+    unsigned long long historial_triangulos[NUM_ETAPAS][FRAME_TIMING_HISTORIAL];
+    unsigned long long historial_marcas[NUM_ETAPAS][FRAME_TIMING_HISTORIAL];
+    unsigned long long historial_frame_ns[FRAME_TIMING_HISTORIAL];
+    int indice;
+    int num_frames;
+
+    double coste_marca_ns;  // Lo que tarda frame_timing_now_ns(), medido en el primer frame
+} FrameTiming;
+
+static FrameTiming timing;
+_Thread_local int frame_timing_activo = 0;
+
+/**
+ * Devuelve el instante actual del reloj monotónico en nanosegundos.
+ * @return Nanosegundos desde un origen arbitrario.
+ */
+unsigned long long frame_timing_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * Suma a la etapa indicada el tiempo y los triángulos procesados.
+ * @param etapa Etapa de la pipeline.
+ * @param ns Nanosegundos invertidos.
+ * @param triangulos Triángulos que han pasado por la etapa.
+ * @param peso Llamadas por las que cuenta esta (1, o FRAME_TIMING_MUESTREO).
+ */
+void frame_timing_registrar(EtapaPipeline etapa, unsigned long long ns, unsigned int triangulos, unsigned int peso) {
+    timing.acumulado_ns[etapa] += ns * peso;
+    timing.triangulos[etapa] += (unsigned long long)triangulos * peso;
+    timing.marcas[etapa]++;
+    timing.marcas_ponderadas[etapa] += peso;
+}
+
+/**
+ * Mide lo que cuesta tomar una marca, como media de unas cuantas seguidas.
+ */
+static double medir_coste_marca(void) {
+    enum { MUESTRAS = 1000 };
+    unsigned long long inicio = frame_timing_now_ns();
+    unsigned long long ultima = inicio;
+    for (int i = 0; i < MUESTRAS; i++)
+        ultima = frame_timing_now_ns();
+    return (double)(ultima - inicio) / MUESTRAS;
+}
+
+/**
+ * Abre un frame. La medición queda activa sólo si el bit FRAME_TIMING
+ * está en la máscara de escena.
+ * @param scene_status_mask Máscara de estado de la escena.
+ */
+void frame_timing_inicio_frame(unsigned int scene_status_mask) {
+    frame_timing_activo = (scene_status_mask & FRAME_TIMING) != 0;
+    if (!frame_timing_activo)
+        return;
+
+    if (timing.coste_marca_ns == 0.0)
+        timing.coste_marca_ns = medir_coste_marca();
+
+    memset(timing.acumulado_ns, 0, sizeof(timing.acumulado_ns));
+    memset(timing.triangulos, 0, sizeof(timing.triangulos));
+    memset(timing.marcas, 0, sizeof(timing.marcas));
+    memset(timing.marcas_ponderadas, 0, sizeof(timing.marcas_ponderadas));
+    timing.inicio_frame_ns = frame_timing_now_ns();
+}
+
+/**
+ * Cierra el frame y vuelca los acumuladores en el historial, con cada
+ * etapa sin el coste de sus marcas.
+ */
+void frame_timing_fin_frame(void) {
+    if (!frame_timing_activo)
+        return;
+    frame_timing_activo = 0;
+
+    for (int e = 0; e < NUM_ETAPAS; e++) {
+        double neto = timing.acumulado_ns[e] - timing.marcas_ponderadas[e] * timing.coste_marca_ns;
+        timing.historial_ns[e][timing.indice] = neto > 0.0 ? (unsigned long long)neto : 0;
+        timing.historial_triangulos[e][timing.indice] = timing.triangulos[e];
+        timing.historial_marcas[e][timing.indice] = timing.marcas[e];
+    }
+    timing.historial_frame_ns[timing.indice] = frame_timing_now_ns() - timing.inicio_frame_ns;
+
+    timing.indice = (timing.indice + 1) % FRAME_TIMING_HISTORIAL;
+    if (timing.num_frames < FRAME_TIMING_HISTORIAL)
+        timing.num_frames++;
+}
+
+static int comparar_ull(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Ordena una copia de las muestras y extrae los percentiles, en milisegundos.
+ */
+static int calcular_percentiles(const unsigned long long* muestras, double* p50_ms, double* p95_ms, double* p99_ms) {
+    int n = timing.num_frames;
+    if (n == 0)
+        return 0;
+
+    unsigned long long ordenadas[FRAME_TIMING_HISTORIAL];
+    memcpy(ordenadas, muestras, sizeof(unsigned long long) * n);
+    qsort(ordenadas, n, sizeof(unsigned long long), comparar_ull);
+
+    *p50_ms = ordenadas[(n - 1) * 50 / 100] / 1e6;
+    *p95_ms = ordenadas[(n - 1) * 95 / 100] / 1e6;
+    *p99_ms = ordenadas[(n - 1) * 99 / 100] / 1e6;
+    return n;
+}
+
+#endif
+
+/**
+ * Calcula los percentiles del tiempo por frame invertido en una etapa.
+ * @param etapa Etapa de la pipeline.
+ * @param p50_ms, p95_ms, p99_ms Percentiles resultantes, en milisegundos.
+ * @return Número de frames del historial (0 si no hay datos).
+ */
+int frame_timing_percentiles(EtapaPipeline etapa, double* p50_ms, double* p95_ms, double* p99_ms) {
+#ifdef PROFILING
+    return calcular_percentiles(timing.historial_ns[etapa], p50_ms, p95_ms, p99_ms);
+#else
+    (void)etapa; (void)p50_ms; (void)p95_ms; (void)p99_ms;
+    return 0;
+#endif
+}
+
+/**
+ * Igual que frame_timing_percentiles, pero para el frame completo.
+ * @param p50_ms, p95_ms, p99_ms Percentiles resultantes, en milisegundos.
+ * @return Número de frames del historial (0 si no hay datos).
+ */
+int frame_timing_percentiles_frame(double* p50_ms, double* p95_ms, double* p99_ms) {
+#ifdef PROFILING
+    return calcular_percentiles(timing.historial_frame_ns, p50_ms, p95_ms, p99_ms);
+#else
+    (void)p50_ms; (void)p95_ms; (void)p99_ms;
+    return 0;
+#endif
+}
+
+/**
+ * Media de triángulos por frame que han pasado por una etapa.
+ * @param etapa Etapa de la pipeline.
+ * @return Media de triángulos por frame, 0 si no hay datos.
+ */
+double frame_timing_media_triangulos(EtapaPipeline etapa) {
+#ifdef PROFILING
+    if (timing.num_frames == 0)
+        return 0.0;
+
+    unsigned long long total = 0;
+    for (int i = 0; i < timing.num_frames; i++)
+        total += timing.historial_triangulos[etapa][i];
+    return (double)total / timing.num_frames;
+#else
+    (void)etapa;
+    return 0.0;
+#endif
+}
+
+/**
+ * Lo que se han llevado por frame las marcas de tiempo que cierra una
+ * etapa: el frame lo ha pagado, pero sus percentiles ya lo descuentan.
+ * @param etapa Etapa de la pipeline.
+ * @return Milisegundos por frame, 0 si no hay datos.
+ */
+double frame_timing_sobrecoste_ms(EtapaPipeline etapa) {
+#ifdef PROFILING
+    if (timing.num_frames == 0)
+        return 0.0;
+
+    unsigned long long total = 0;
+    for (int i = 0; i < timing.num_frames; i++)
+        total += timing.historial_marcas[etapa][i];
+    return (double)total / timing.num_frames * timing.coste_marca_ns / 1e6;
+#else
+    (void)etapa;
+    return 0.0;
+#endif
+}
+
+/**
+ * Nombre legible de una etapa, para los informes.
+ * @param etapa Etapa de la pipeline.
+ * @return Cadena constante con el nombre.
+ */
+const char* frame_timing_nombre_etapa(EtapaPipeline etapa) {
+    return (etapa >= 0 && etapa < NUM_ETAPAS) ? nombres_etapas[etapa] : "?";
+}
+
+/**
+ * Vacía el historial de tiempos.
+ */
+void frame_timing_reset(void) {
+#ifdef PROFILING
+    memset(&timing, 0, sizeof(timing));
+#endif
+}
@@ -0,0 +1,309 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <time.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                    GRABACIÓN Y REPRODUCCIÓN DE SESIONES             *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo graba las llamadas de interacción (transformar, rotate,
+ * traslacion_local, traslacion_orbita, swap_camera y undo) con sus
+ * parámetros y una marca de tiempo, en un fichero binario compacto de
+ * eventos de 24 bytes. Después, el reproductor las vuelve a ejecutar sin
+ * ventana, lo más rápido posible o al ritmo grabado, procesando un frame
+ * tras cada evento y recogiendo estadísticas de tiempo por frame.
+ *
+ * Así una sesión real de un usuario se convierte en una prueba de
+ * rendimiento repetible. El fichero usa el orden de bytes de la máquina.
+ *
+ * Formato: cabecera {"GCIR", versión} seguida de EventoEntrada en crudo.
+ * El objeto seleccionado se guarda como su posición en la lista de la
+ * escena; si se llama con un objeto que no está en la lista, la
+ * grabación se corta ahí con un error en vez de guardar otro objeto, y
+ * al reproducir se rechaza la sesión si nombra objetos que la escena no
+ * tiene.
+ ***********************************************************************/
+
+#define GRABACION_MAGIC "GCIR"
+#define GRABACION_VERSION 1u
+#define GRABACION_BUFFER 4096
+
+typedef struct {
+    char magic[4];
+    unsigned int version;
+} CabeceraGrabacion;
+
+int grabacion_activa = 0;
+
+static FILE* fichero_grabacion = NULL;
+static triobj* lista_grabacion = NULL;
+static EventoEntrada buffer_grabacion[GRABACION_BUFFER];
+static int eventos_en_buffer = 0;
+static long eventos_grabados = 0;
+static int grabacion_fallida = 0;
+static unsigned long long inicio_grabacion_ns = 0;
+
+static unsigned long long reloj_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static void volcar_buffer(void) {
+    if (fichero_grabacion && eventos_en_buffer > 0)
+        fwrite(buffer_grabacion, sizeof(EventoEntrada), eventos_en_buffer, fichero_grabacion);
+    eventos_en_buffer = 0;
+}
+
+/**
+ * Posición de un objeto dentro de la lista de la escena, que es lo que se
+ * guarda en el fichero en lugar del puntero.
+ * @return Índice, o -1 si el objeto no está en la lista.
+ */
+static int indice_objeto(const triobj* sel_ptr) {
+    int indice = 0;
+    for (triobj* obj = lista_grabacion; obj; obj = obj->hptr, indice++) {
+        if (obj == sel_ptr)
+            return indice;
+    }
+    return -1;
+}
+
+static triobj* objeto_por_indice(triobj* lista, int indice) {
+    triobj* obj = lista;
+    for (int i = 0; i < indice && obj; i++)
+        obj = obj->hptr;
+    return indice == GRABACION_SIN_OBJETO ? NULL : obj;
+}
+
+/**
+ * Empieza a grabar la sesión en un fichero.
+ * @param ruta Fichero de salida.
+ * @param lista Primer objeto de la escena, para traducir sel_ptr a índices.
+ * @return 0 si todo fue bien, -1 si no se ha podido abrir el fichero.
+ */
+int grabacion_iniciar(const char* ruta, triobj* lista) {
+    if (grabacion_activa)
+        grabacion_detener();
+
+    fichero_grabacion = fopen(ruta, "wb");
+    if (!fichero_grabacion) {
+        printf("\nNo se ha podido abrir %s para grabar la sesión.\n", ruta);
+        return -1;
+    }
+
+    CabeceraGrabacion cabecera = {{'G', 'C', 'I', 'R'}, GRABACION_VERSION};
+    fwrite(&cabecera, sizeof(cabecera), 1, fichero_grabacion);
+
+    lista_grabacion = lista;
+    eventos_en_buffer = 0;
+    eventos_grabados = 0;
+    grabacion_fallida = 0;
+    inicio_grabacion_ns = reloj_ns();
+    grabacion_activa = 1;
+    return 0;
+}
+
+/**
+ * Termina la grabación y cierra el fichero.
+ * @return Número de eventos grabados, o -1 si la grabación se cortó
+ *         antes por un objeto que no estaba en la escena.
+ */
+long grabacion_detener(void) {
+    if (grabacion_fallida) {
+        grabacion_fallida = 0;
+        return -1;
+    }
+    if (!grabacion_activa)
+        return 0;
+
+    volcar_buffer();
+    fclose(fichero_grabacion);
+    fichero_grabacion = NULL;
+    grabacion_activa = 0;
+    return eventos_grabados;
+}
+
+/**
+ * Guarda un evento de interacción. Se llama a través de GRABAR_ENTRADA al
+ * principio de cada función pública de interacción.
+ * @param tipo Función llamada.
+ * @param eje, dir Parámetros de la llamada (0 si no aplican).
+ * @param scene_status_mask Máscara de escena con la que se llamó.
+ * @param sel_ptr Objeto seleccionado.
+ */
+void grabar_entrada(TipoEntrada tipo, char eje, int dir, unsigned int scene_status_mask, const triobj* sel_ptr) {
+    int objeto = sel_ptr ? indice_objeto(sel_ptr) : GRABACION_SIN_OBJETO;
+    if (sel_ptr && objeto < 0) {
+        // Guardar otro objeto en su lugar haría que la sesión reprodujera algo distinto sin avisar.
+        printf("\nEl objeto seleccionado no está en la escena que se graba; se corta la grabación "
+               "tras %ld eventos.\n", eventos_grabados);
+        grabacion_detener();
+        grabacion_fallida = 1;
+        return;
+    }
+
+    EventoEntrada* evento = &buffer_grabacion[eventos_en_buffer++];
+    evento->t_ns = reloj_ns() - inicio_grabacion_ns;
+    evento->scene_status_mask = scene_status_mask;
+    evento->objeto = objeto;
+    evento->tipo = (unsigned char)tipo;
+    evento->eje = eje;
+    evento->dir = (signed char)dir;
+    eventos_grabados++;
+
+    if (eventos_en_buffer == GRABACION_BUFFER)
+        volcar_buffer();
+}
+
+/**
+ * Lee un fichero de sesión completo a memoria.
+ * @param ruta Fichero grabado con grabacion_iniciar.
+ * @param eventos Array de eventos resultante (lo libera quien llama).
+ * @return Número de eventos leídos, o -1 si el fichero no es válido.
+ */
+long cargar_grabacion(const char* ruta, EventoEntrada** eventos) {
+    FILE* f = fopen(ruta, "rb");
+    if (!f) {
+        printf("\nNo se ha podido abrir la sesión %s\n", ruta);
+        return -1;
+    }
+
+    CabeceraGrabacion cabecera;
+    if (fread(&cabecera, sizeof(cabecera), 1, f) != 1 ||
+        memcmp(cabecera.magic, GRABACION_MAGIC, 4) != 0 || cabecera.version != GRABACION_VERSION) {
+        printf("\n%s no es una sesión grabada válida.\n", ruta);
+        fclose(f);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long num_eventos = (ftell(f) - (long)sizeof(cabecera)) / (long)sizeof(EventoEntrada);
+    fseek(f, sizeof(cabecera), SEEK_SET);
+
+    *eventos = (EventoEntrada*)malloc(sizeof(EventoEntrada) * (num_eventos > 0 ? num_eventos : 1));
+    if (!*eventos) {
+        fclose(f);
+        return -1;
+    }
+
+    num_eventos = (long)fread(*eventos, sizeof(EventoEntrada), num_eventos, f);
+    fclose(f);
+    return num_eventos;
+}
+
+/**
+ * Vuelve a ejecutar un evento sobre la escena.
+ */
+static void ejecutar_evento(const EventoEntrada* evento, EscenaReplay* escena) {
+    triobj* sel_ptr = objeto_por_indice(escena->lista, evento->objeto);
+
+    switch ((TipoEntrada)evento->tipo) {
+        case ENTRADA_TRANSFORMAR:
+            transformar(evento->eje, evento->dir, escena->main_camera, evento->scene_status_mask, sel_ptr);
+            break;
+        case ENTRADA_ROTATE:
+            rotate(evento->eje, evento->dir, escena->main_camera, evento->scene_status_mask, sel_ptr);
+            break;
+        case ENTRADA_TRASLACION_LOCAL:
+            traslacion_local(evento->eje, evento->dir, escena->main_camera, evento->scene_status_mask, sel_ptr);
+            break;
+        case ENTRADA_TRASLACION_ORBITA:
+            traslacion_orbita(evento->eje, evento->dir, escena->main_camera, sel_ptr);
+            break;
+        case ENTRADA_SWAP_CAMERA:
+            swap_camera(evento->scene_status_mask, sel_ptr, escena->main_camera, escena->secondary_camera);
+            break;
+        case ENTRADA_UNDO:
+            undo(sel_ptr);
+            break;
+        default:
+            break;
+    }
+}
+
+static int comparar_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Reproduce una sesión grabada sin ventana. Tras cada evento se procesa
+ * un frame de la escena con procesar_escena() y se mide su duración.
+ * @param ruta Fichero de sesión.
+ * @param escena Cámaras y objetos sobre los que reproducir.
+ * @param scene_status_mask Máscara de render (proyección, BACK_CULLING...).
+ * @param ritmo_grabado 1 para respetar los tiempos grabados, 0 para ir lo más rápido posible.
+ * @param stats Estadísticas resultantes.
+ * @return 0 si todo fue bien, -1 si no se ha podido cargar la sesión o
+ *         nombra objetos que la escena no tiene.
+ */
+int reproducir_sesion(const char* ruta, EscenaReplay* escena, unsigned int scene_status_mask, int ritmo_grabado, EstadisticasReplay* stats) {
+    EventoEntrada* eventos = NULL;
+    long num_eventos = cargar_grabacion(ruta, &eventos);
+    if (num_eventos < 0)
+        return -1;
+
+    int num_objetos = 0;
+    for (triobj* obj = escena->lista; obj; obj = obj->hptr)
+        num_objetos++;
+    for (long i = 0; i < num_eventos; i++) {
+        if (eventos[i].objeto != GRABACION_SIN_OBJETO && (eventos[i].objeto < 0 || eventos[i].objeto >= num_objetos)) {
+            printf("\n%s usa el objeto %d y la escena sólo tiene %d.\n", ruta, eventos[i].objeto, num_objetos);
+            free(eventos);
+            return -1;
+        }
+    }
+
+    memset(stats, 0, sizeof(EstadisticasReplay));
+    double* tiempos_frame = (double*)malloc(sizeof(double) * (num_eventos > 0 ? num_eventos : 1));
+    if (!tiempos_frame) {
+        free(eventos);
+        return -1;
+    }
+
+    // No quiero que la reproducción se grabe a sí misma.
+    int grabacion_previa = grabacion_activa;
+    grabacion_activa = 0;
+
+    unsigned long long inicio = reloj_ns();
+    for (long i = 0; i < num_eventos; i++) {
+        if (ritmo_grabado) {
+            unsigned long long ahora = reloj_ns() - inicio;
+            if (eventos[i].t_ns > ahora) {
+                unsigned long long espera_ns = eventos[i].t_ns - ahora;
+                struct timespec espera = {(time_t)(espera_ns / 1000000000ULL), (long)(espera_ns % 1000000000ULL)};
+                nanosleep(&espera, NULL);
+            }
+        }
+
+        unsigned long long inicio_frame = reloj_ns();
+        FRAME_TIMING_INICIO(scene_status_mask);
+        ejecutar_evento(&eventos[i], escena);
+        stats->triangulos_dibujados += procesar_escena(escena->main_camera, scene_status_mask, escena->lista);
+        FRAME_TIMING_FIN();
+        tiempos_frame[i] = (reloj_ns() - inicio_frame) / 1e6;
+    }
+    stats->total_ms = (reloj_ns() - inicio) / 1e6;
+
+    grabacion_activa = grabacion_previa;
+
+    stats->eventos = num_eventos;
+    stats->frames = num_eventos;
+    if (num_eventos > 0) {
+        qsort(tiempos_frame, num_eventos, sizeof(double), comparar_double);
+        stats->p50_ms = tiempos_frame[(num_eventos - 1) * 50 / 100];
+        stats->p95_ms = tiempos_frame[(num_eventos - 1) * 95 / 100];
+        stats->p99_ms = tiempos_frame[(num_eventos - 1) * 99 / 100];
+        stats->max_ms = tiempos_frame[num_eventos - 1];
+    }
+
+    free(tiempos_frame);
+    free(eventos);
+    return 0;
+}
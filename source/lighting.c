@@ -0,0 +1,448 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SOMBREADO_SSE
+#endif
+
+/***********************************************************************
+ *                                                                     *
+ *                              ILUMINACIÓN                            *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo implementa la etapa de sombreado: luces direccionales,
+ * posicionales y focos, con sombreado plano (un color por cara, evaluado
+ * en el centroide con la normal de la cara) o Gouraud (un color por
+ * vértice).
+ *
+ * Es una etapa suelta: ni procesar_objeto() ni rasterizar_triangulo()
+ * usan todavía los colores, y de momento sólo la llama el benchmark de
+ * iluminación.
+ *
+ * El modelo es difuso de Lambert más un término ambiente. Las luces con
+ * posición se atenúan con (1 - d / rango)^2, que llega a cero justo en el
+ * rango; así descartar por rango no cambia el resultado.
+ *
+ * Para que escale a cientos de luces:
+ * - Por objeto, se descartan las luces cuyo rango no llega a la esfera
+ *   que envuelve al objeto, y las que quedan se copian compactadas y
+ *   ordenadas por tipo (un bucle sin ramas por tipo).
+ * - Los puntos se pasan a espacio mundo en lotes de LUCES_LOTE como
+ *   estructura de arrays, y cada luz se evalúa con SSE sobre 4 puntos a la
+ *   vez, con los acumuladores de color en registros.
+ *
+ * En plano la normal sale del propio triángulo en espacio mundo, igual
+ * que en obtain_normal_vector(). En Gouraud se usan las normales de
+ * vértice del objeto (ver vertex_normals.c), ya en espacio mundo, y sólo
+ * si el objeto no las tiene se usa la de la cara.
+ ***********************************************************************/
+
+/**
+ * Inicializa un conjunto de luces vacío.
+ * @param luces Conjunto de luces.
+ * @param ambiente Luz ambiente.
+ */
+void luces_iniciar(Luces* luces, Color ambiente) {
+    memset(luces, 0, sizeof(Luces));
+    luces->ambiente = ambiente;
+}
+
+static int anadir_luz(Luces* luces, TipoLuz tipo, Vector3 posicion, Vector3 direccion, Color color, float rango) {
+    if (luces->num >= LUCES_MAX)
+        return -1;
+
+    int i = luces->num++;
+    Vector3 dir = normalizar_vector(direccion);
+    luces->tipo[i] = (unsigned char)tipo;
+    luces->pos_x[i] = posicion.x;
+    luces->pos_y[i] = posicion.y;
+    luces->pos_z[i] = posicion.z;
+    luces->dir_x[i] = dir.x;
+    luces->dir_y[i] = dir.y;
+    luces->dir_z[i] = dir.z;
+    luces->r[i] = color.r;
+    luces->g[i] = color.g;
+    luces->b[i] = color.b;
+    luces->rango[i] = rango;
+    luces->inv_rango[i] = rango > 0.0f ? 1.0f / rango : 0.0f;
+    luces->cos_exterior[i] = -1.0f;
+    luces->inv_cono[i] = 0.0f;
+    return i;
+}
+
+/**
+ * Añade una luz direccional (el sol).
+ * @param luces Conjunto de luces.
+ * @param direccion Dirección hacia la que viaja la luz.
+ * @param color Color e intensidad.
+ * @return Índice de la luz, o -1 si ya hay LUCES_MAX.
+ */
+int anadir_luz_direccional(Luces* luces, Vector3 direccion, Color color) {
+    return anadir_luz(luces, LUZ_DIRECCIONAL, vector3(0.0f, 0.0f, 0.0f), direccion, color, 0.0f);
+}
+
+/**
+ * Añade una luz posicional (una bombilla).
+ * @param luces Conjunto de luces.
+ * @param posicion Posición en espacio mundo.
+ * @param color Color e intensidad.
+ * @param rango Distancia a la que la luz se apaga del todo.
+ * @return Índice de la luz, o -1 si ya hay LUCES_MAX.
+ */
+int anadir_luz_posicional(Luces* luces, Vector3 posicion, Color color, float rango) {
+    return anadir_luz(luces, LUZ_POSICIONAL, posicion, vector3(0.0f, 0.0f, -1.0f), color, rango);
+}
+
+/**
+ * Añade un foco.
+ * @param luces Conjunto de luces.
+ * @param posicion Posición en espacio mundo.
+ * @param direccion Hacia dónde apunta el foco.
+ * @param color Color e intensidad.
+ * @param rango Distancia a la que la luz se apaga del todo.
+ * @param angulo_interior Semiángulo (radianes) con intensidad completa.
+ * @param angulo_exterior Semiángulo (radianes) a partir del que no ilumina.
+ * @return Índice de la luz, o -1 si ya hay LUCES_MAX.
+ */
+int anadir_luz_foco(Luces* luces, Vector3 posicion, Vector3 direccion, Color color, float rango,
+                    float angulo_interior, float angulo_exterior) {
+    int i = anadir_luz(luces, LUZ_FOCO, posicion, direccion, color, rango);
+    if (i < 0)
+        return i;
+
+    float cos_interior = cosf(angulo_interior);
+    luces->cos_exterior[i] = cosf(angulo_exterior);
+    luces->inv_cono[i] = cos_interior > luces->cos_exterior[i] ? 1.0f / (cos_interior - luces->cos_exterior[i]) : 1e6f;
+    return i;
+}
+
+/**
+ * Crea el contexto de sombreado, con las luces activas y el lote de
+ * trabajo. Hay que usar uno por hilo.
+ * @return Sombreador creado, o NULL si no hay memoria.
+ */
+Sombreador* crear_sombreador(void) {
+    return (Sombreador*)calloc(1, sizeof(Sombreador));
+}
+
+void liberar_sombreador(Sombreador* s) {
+    free(s);
+}
+
+/**
+ * Esfera que envuelve al objeto en espacio mundo: la caja del objeto en
+ * espacio local (la que guarda crear_triobj), transformada, con el radio
+ * escalado por la mayor escala de la matriz.
+ */
+static void esfera_objeto(const triobj* obj, const double* m, Vector3* centro, float* radio) {
+    float min_x = obj->caja_min[0], min_y = obj->caja_min[1], min_z = obj->caja_min[2];
+    float max_x = obj->caja_max[0], max_y = obj->caja_max[1], max_z = obj->caja_max[2];
+
+    float cx = 0.5f * (min_x + max_x), cy = 0.5f * (min_y + max_y), cz = 0.5f * (min_z + max_z);
+    centro->x = (float)(m[0] * cx + m[1] * cy + m[2] * cz + m[3]);
+    centro->y = (float)(m[4] * cx + m[5] * cy + m[6] * cz + m[7]);
+    centro->z = (float)(m[8] * cx + m[9] * cy + m[10] * cz + m[11]);
+
+    float escala2 = 0.0f;
+    for (int c = 0; c < 3; c++) {
+        float e2 = (float)(m[c] * m[c] + m[4 + c] * m[4 + c] + m[8 + c] * m[8 + c]);
+        if (e2 > escala2)
+            escala2 = e2;
+    }
+    float ex = max_x - cx, ey = max_y - cy, ez = max_z - cz;
+    *radio = sqrtf((ex * ex + ey * ey + ez * ez) * escala2);
+}
+
+static void copiar_luz(Luces* destino, const Luces* origen, int i) {
+    int j = destino->num++;
+    destino->tipo[j] = origen->tipo[i];
+    destino->pos_x[j] = origen->pos_x[i];
+    destino->pos_y[j] = origen->pos_y[i];
+    destino->pos_z[j] = origen->pos_z[i];
+    destino->dir_x[j] = origen->dir_x[i];
+    destino->dir_y[j] = origen->dir_y[i];
+    destino->dir_z[j] = origen->dir_z[i];
+    destino->r[j] = origen->r[i];
+    destino->g[j] = origen->g[i];
+    destino->b[j] = origen->b[i];
+    destino->rango[j] = origen->rango[i];
+    destino->inv_rango[j] = origen->inv_rango[i];
+    destino->cos_exterior[j] = origen->cos_exterior[i];
+    destino->inv_cono[j] = origen->inv_cono[i];
+}
+
+/**
+ * Deja en s->activas las luces que alcanzan la esfera, ordenadas por tipo.
+ */
+static void seleccionar_luces(Sombreador* s, const Luces* luces, Vector3 centro, float radio) {
+    s->activas.num = 0;
+    s->activas.ambiente = luces->ambiente;
+
+    for (int tipo = LUZ_DIRECCIONAL; tipo <= LUZ_FOCO; tipo++) {
+        for (int i = 0; i < luces->num; i++) {
+            if (luces->tipo[i] != tipo)
+                continue;
+            if (tipo != LUZ_DIRECCIONAL) {
+                float dx = luces->pos_x[i] - centro.x, dy = luces->pos_y[i] - centro.y, dz = luces->pos_z[i] - centro.z;
+                float alcance = luces->rango[i] + radio;
+                if (dx * dx + dy * dy + dz * dz >= alcance * alcance) {
+                    s->luces_descartadas++;
+                    continue;
+                }
+            }
+            copiar_luz(&s->activas, luces, i);
+        }
+        if (tipo == LUZ_DIRECCIONAL)
+            s->fin_direccionales = s->activas.num;
+        else if (tipo == LUZ_POSICIONAL)
+            s->fin_posicionales = s->activas.num;
+    }
+    s->luces_evaluadas += s->activas.num;
+}
+
+/**
+ * Versión escalar de la evaluación, para los puntos que no llenan un
+ * registro y para otras arquitecturas.
+ */
+static void evaluar_escalar(Sombreador* s, int inicio, int n) {
+    const Luces* l = &s->activas;
+
+    for (int i = inicio; i < n; i++) {
+        float r = l->ambiente.r, g = l->ambiente.g, b = l->ambiente.b;
+
+        for (int j = 0; j < l->num; j++) {
+            float f;
+            if (j < s->fin_direccionales) {
+                f = -(s->nx[i] * l->dir_x[j] + s->ny[i] * l->dir_y[j] + s->nz[i] * l->dir_z[j]);
+                if (f < 0.0f) f = 0.0f;
+            } else {
+                float lx = l->pos_x[j] - s->px[i], ly = l->pos_y[j] - s->py[i], lz = l->pos_z[j] - s->pz[i];
+                float d2 = lx * lx + ly * ly + lz * lz;
+                float inv_d = 1.0f / sqrtf(d2 > 1e-12f ? d2 : 1e-12f);
+                float a = 1.0f - d2 * inv_d * l->inv_rango[j];
+                if (a < 0.0f) a = 0.0f;
+                float ndl = (s->nx[i] * lx + s->ny[i] * ly + s->nz[i] * lz) * inv_d;
+                if (ndl < 0.0f) ndl = 0.0f;
+                f = a * a * ndl;
+
+                if (j >= s->fin_posicionales) {
+                    float coseno = -(lx * l->dir_x[j] + ly * l->dir_y[j] + lz * l->dir_z[j]) * inv_d;
+                    float cono = (coseno - l->cos_exterior[j]) * l->inv_cono[j];
+                    f *= cono < 0.0f ? 0.0f : (cono > 1.0f ? 1.0f : cono);
+                }
+            }
+            r += f * l->r[j];
+            g += f * l->g[j];
+            b += f * l->b[j];
+        }
+
+        s->r[i] = r > 1.0f ? 1.0f : r;
+        s->g[i] = g > 1.0f ? 1.0f : g;
+        s->b[i] = b > 1.0f ? 1.0f : b;
+    }
+}
+
+#ifdef SOMBREADO_SSE
+
+/**
+ * 1/sqrt(x) aproximada con un paso de Newton (error relativo ~1e-7, de
+ * sobra para un color de 8 bits).
+ */
+static inline __m128 inv_raiz_sse(__m128 x) {
+    __m128 y = _mm_rsqrt_ps(x);
+    __m128 mitad_x = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(mitad_x, _mm_mul_ps(y, y))));
+}
+
+/**
+ * Evalúa todas las luces activas sobre los puntos [0, n) de 4 en 4.
+ * @return Primer punto sin evaluar.
+ */
+static int evaluar_sse(Sombreador* s, int n) {
+    const Luces* l = &s->activas;
+    const __m128 cero = _mm_setzero_ps(), uno = _mm_set1_ps(1.0f), epsilon = _mm_set1_ps(1e-12f);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_loadu_ps(&s->px[i]), py = _mm_loadu_ps(&s->py[i]), pz = _mm_loadu_ps(&s->pz[i]);
+        __m128 nx = _mm_loadu_ps(&s->nx[i]), ny = _mm_loadu_ps(&s->ny[i]), nz = _mm_loadu_ps(&s->nz[i]);
+        __m128 r = _mm_set1_ps(l->ambiente.r), g = _mm_set1_ps(l->ambiente.g), b = _mm_set1_ps(l->ambiente.b);
+
+        int j = 0;
+        for (; j < s->fin_direccionales; j++) {
+            __m128 f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(-l->dir_x[j])),
+                                             _mm_mul_ps(ny, _mm_set1_ps(-l->dir_y[j]))),
+                                  _mm_mul_ps(nz, _mm_set1_ps(-l->dir_z[j])));
+            f = _mm_max_ps(f, cero);
+            r = _mm_add_ps(r, _mm_mul_ps(f, _mm_set1_ps(l->r[j])));
+            g = _mm_add_ps(g, _mm_mul_ps(f, _mm_set1_ps(l->g[j])));
+            b = _mm_add_ps(b, _mm_mul_ps(f, _mm_set1_ps(l->b[j])));
+        }
+
+        for (; j < l->num; j++) {
+            __m128 lx = _mm_sub_ps(_mm_set1_ps(l->pos_x[j]), px);
+            __m128 ly = _mm_sub_ps(_mm_set1_ps(l->pos_y[j]), py);
+            __m128 lz = _mm_sub_ps(_mm_set1_ps(l->pos_z[j]), pz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+            d2 = _mm_max_ps(d2, epsilon);
+            __m128 inv_d = inv_raiz_sse(d2);
+
+            __m128 a = _mm_sub_ps(uno, _mm_mul_ps(_mm_mul_ps(d2, inv_d), _mm_set1_ps(l->inv_rango[j])));
+            a = _mm_max_ps(a, cero);
+            __m128 ndl = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz));
+            ndl = _mm_max_ps(_mm_mul_ps(ndl, inv_d), cero);
+            __m128 f = _mm_mul_ps(_mm_mul_ps(a, a), ndl);
+
+            if (j >= s->fin_posicionales) {
+                __m128 coseno = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_set1_ps(l->dir_x[j])),
+                                                      _mm_mul_ps(ly, _mm_set1_ps(l->dir_y[j]))),
+                                           _mm_mul_ps(lz, _mm_set1_ps(l->dir_z[j])));
+                coseno = _mm_mul_ps(_mm_sub_ps(cero, coseno), inv_d);
+                __m128 cono = _mm_mul_ps(_mm_sub_ps(coseno, _mm_set1_ps(l->cos_exterior[j])), _mm_set1_ps(l->inv_cono[j]));
+                f = _mm_mul_ps(f, _mm_min_ps(_mm_max_ps(cono, cero), uno));
+            }
+
+            r = _mm_add_ps(r, _mm_mul_ps(f, _mm_set1_ps(l->r[j])));
+            g = _mm_add_ps(g, _mm_mul_ps(f, _mm_set1_ps(l->g[j])));
+            b = _mm_add_ps(b, _mm_mul_ps(f, _mm_set1_ps(l->b[j])));
+        }
+
+        _mm_storeu_ps(&s->r[i], _mm_min_ps(r, uno));
+        _mm_storeu_ps(&s->g[i], _mm_min_ps(g, uno));
+        _mm_storeu_ps(&s->b[i], _mm_min_ps(b, uno));
+    }
+    return i;
+}
+
+#endif // SOMBREADO_SSE
+
+static inline void punto_mundo(const float* m, const Punto* p, float* x, float* y, float* z) {
+    *x = m[0] * p->x + m[1] * p->y + m[2] * p->z + m[3];
+    *y = m[4] * p->x + m[5] * p->y + m[6] * p->z + m[7];
+    *z = m[8] * p->x + m[9] * p->y + m[10] * p->z + m[11];
+}
+
+/**
+ * Pasa los triángulos [inicio, fin) a puntos de muestreo del lote: uno
+ * por cara (centroide) en plano, tres por cara en Gouraud, con las
+ * normales de vértice en espacio mundo si se pasan. Los objetos
+ * comprimidos se descomprimen aquí mismo; m ya lleva su descuantización.
+ * @return Número de puntos del lote.
+ */
+static int preparar_lote(Sombreador* s, const triobj* obj, const float* m, const Vector3* normales, ModoSombreado modo,
+                         int inicio, int fin) {
+    int n = 0;
+    for (int i = inicio; i < fin; i++) {
+        float x[3], y[3], z[3];
+        Triangulo descomprimido;
+        const Triangulo* tri = &descomprimido;
+        if (obj->compacta) {
+            const PuntoCompacto* q = &obj->compacta->vertices[3L * i];
+            punto_compacto(obj->compacta, &q[0], &descomprimido.p1);
+            punto_compacto(obj->compacta, &q[1], &descomprimido.p2);
+            punto_compacto(obj->compacta, &q[2], &descomprimido.p3);
+        } else {
+            tri = &obj->triptr[i];
+        }
+        punto_mundo(m, &tri->p1, &x[0], &y[0], &z[0]);
+        punto_mundo(m, &tri->p2, &x[1], &y[1], &z[1]);
+        punto_mundo(m, &tri->p3, &x[2], &y[2], &z[2]);
+
+        // Normal de la cara en espacio mundo, como obtain_normal_vector().
+        float ax = x[1] - x[0], ay = y[1] - y[0], az = z[1] - z[0];
+        float bx = x[2] - x[0], by = y[2] - y[0], bz = z[2] - z[0];
+        float cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+        float longitud = sqrtf(cx * cx + cy * cy + cz * cz);
+        float inv = longitud > 0.0f ? 1.0f / longitud : 0.0f;
+        cx *= inv;
+        cy *= inv;
+        cz *= inv;
+
+        if (modo == SOMBREADO_PLANO) {
+            s->px[n] = (x[0] + x[1] + x[2]) * (1.0f / 3.0f);
+            s->py[n] = (y[0] + y[1] + y[2]) * (1.0f / 3.0f);
+            s->pz[n] = (z[0] + z[1] + z[2]) * (1.0f / 3.0f);
+            s->nx[n] = cx;
+            s->ny[n] = cy;
+            s->nz[n] = cz;
+            n++;
+        } else {
+            for (int k = 0; k < 3; k++, n++) {
+                s->px[n] = x[k];
+                s->py[n] = y[k];
+                s->pz[n] = z[k];
+                if (normales) {
+                    const Vector3* normal = &normales[3L * i + k];
+                    s->nx[n] = normal->x;
+                    s->ny[n] = normal->y;
+                    s->nz[n] = normal->z;
+                } else {
+                    s->nx[n] = cx;
+                    s->ny[n] = cy;
+                    s->nz[n] = cz;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * Sombrea un objeto con todas las luces que le llegan.
+ * @param s Sombreador (uno por hilo).
+ * @param luces Luces de la escena, en espacio mundo.
+ * @param obj Objeto a sombrear, con su matriz de modelo actual (se
+ *            actualiza su caché de normales en espacio mundo).
+ * @param modo SOMBREADO_PLANO o SOMBREADO_GOURAUD.
+ * @param colores Salida: un color por triángulo en plano, tres por
+ *                triángulo (p1, p2, p3) en Gouraud.
+ * @return Número de luces que alcanzan al objeto.
+ */
+int sombrear_objeto(Sombreador* s, const Luces* luces, triobj* obj, ModoSombreado modo, Color* colores) {
+    TIMING_INICIO(marca);
+    const double* m = obj->mptr->m;
+
+    Vector3 centro;
+    float radio;
+    esfera_objeto(obj, m, &centro, &radio);
+    seleccionar_luces(s, luces, centro, radio);
+    s->objetos++;
+
+    // Con floats basta para sombrear y la transformación sale al doble de rápido.
+    double m_descuantizada[16];
+    if (obj->compacta) {
+        matriz_descuantizada(obj->compacta, m, m_descuantizada);
+        m = m_descuantizada;
+    }
+    float mf[12];
+    for (int i = 0; i < 12; i++)
+        mf[i] = (float)m[i];
+
+    // Sólo se transforman si la matriz del objeto ha cambiado.
+    const Vector3* normales = modo == SOMBREADO_GOURAUD ? normales_mundo(obj) : NULL;
+
+    int por_lote = modo == SOMBREADO_PLANO ? LUCES_LOTE : LUCES_LOTE / 3;
+    for (int inicio = 0; inicio < obj->num_triangles; inicio += por_lote) {
+        int fin = inicio + por_lote < obj->num_triangles ? inicio + por_lote : obj->num_triangles;
+        int n = preparar_lote(s, obj, mf, normales, modo, inicio, fin);
+
+        int evaluados = 0;
+#ifdef SOMBREADO_SSE
+        evaluados = evaluar_sse(s, n);
+#endif
+        evaluar_escalar(s, evaluados, n);
+
+        Color* salida = &colores[modo == SOMBREADO_PLANO ? inicio : inicio * 3];
+        for (int i = 0; i < n; i++) {
+            salida[i].r = s->r[i];
+            salida[i].g = s->g[i];
+            salida[i].b = s->b[i];
+        }
+    }
+
+    TIMING_ETAPA(ETAPA_SOMBREADO, marca, obj->num_triangles);
+    return s->activas.num;
+}
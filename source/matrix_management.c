@@ -44,6 +44,8 @@ mlist* gestionar_nueva_matriz(triobj* sel_ptr) {
  */
 void undo(triobj* sel_ptr)
 {
+    GRABAR_ENTRADA(ENTRADA_UNDO, 0, 0, 0, sel_ptr);
+
     // Primero verifico si hay un nodo anterior para deshacer
     if (sel_ptr->mptr && sel_ptr->mptr->hptr)
     {
@@ -7,6 +7,42 @@
  *                                                                     *
  ***********************************************************************/
 
+/***********************************************************************
+ * Las capas de ayuda (ejes, malla del suelo y vectores normales) se
+ * guardan en arrays de vértices del cliente y cada una se dibuja con un
+ * solo glDrawArrays, en lugar de mandar vértice a vértice con glBegin y
+ * glVertex3f cada frame. Son de OpenGL 1.1, así que funcionan igual con
+ * el GL por software de Mesa (llvmpipe/OSMesa).
+ *
+ * Los ejes no cambian nunca, la malla sólo cuando cambia el tamaño de la
+ * cuadrícula y los vectores normales se acumulan con
+ * encolar_vector_normal() y se dibujan todos juntos con
+ * dibujar_vectores_normales(). draw_vector() sigue dibujando uno suelto
+ * en el momento, para quien lo llame fuera de ese recorrido.
+ ***********************************************************************/
+
+// Ejes: X rojo oscuro, Y verde oscuro, Z azul oscuro.
+static const GLfloat ejes_vertices[] = {
+    -500.0f, 0.0f, 0.0f,    500.0f, 0.0f, 0.0f,
+    0.0f, -500.0f, 0.0f,    0.0f, 500.0f, 0.0f,
+    0.0f, 0.0f, -500.0f,    0.0f, 0.0f, 500.0f,
+};
+static const GLfloat ejes_colores[] = {
+    0.5f, 0.0f, 0.0f,    0.5f, 0.0f, 0.0f,
+    0.0f, 0.5f, 0.0f,    0.0f, 0.5f, 0.0f,
+    0.0f, 0.0f, 0.5f,    0.0f, 0.0f, 0.5f,
+};
+
+// Malla del suelo, construida para malla_tamano.
+static GLfloat* malla_vertices = NULL;
+static int malla_num_vertices = 0;
+static float malla_tamano = 0.0f;
+
+// Vectores normales pendientes de dibujar, 2 vértices por vector.
+static GLfloat* normales_vertices = NULL;
+static int normales_num_vertices = 0;
+static int normales_capacidad = 0;
+
 /**
  * Dibuja los ejes coordenados en el espacio de visualización.
  * El eje X se dibuja en rojo, el eje Y en verde y el eje Z en azul.
@@ -15,23 +51,41 @@
 void dibujar_ejes() {
     glLineWidth(1.0f); // Líneas más finas
 
-    glBegin(GL_LINES);
-    // Eje X en rojo oscuro
-    glColor3f(0.5f, 0.0f, 0.0f);
-    glVertex3f(-500.0f, 0.0f, 0.0f);
-    glVertex3f(500.0f, 0.0f, 0.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, ejes_vertices);
+    glColorPointer(3, GL_FLOAT, 0, ejes_colores);
+    glDrawArrays(GL_LINES, 0, 6);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+/**
+ * Reconstruye los vértices de la malla para un tamaño de cuadrícula,
+ * recorriendo el rango igual que se hacía con glVertex3f.
+ * @return 0 si todo fue bien, -1 si no hay memoria.
+ */
+static int construir_malla(float grid_size) {
+    int lineas = 0;
+    for (float i = -500.0f; i <= 500.0f; i += grid_size)
+        lineas++;
 
-    // Eje Y en verde oscuro
-    glColor3f(0.0f, 0.5f, 0.0f);
-    glVertex3f(0.0f, -500.0f, 0.0f);
-    glVertex3f(0.0f, 500.0f, 0.0f);
+    GLfloat* vertices = (GLfloat*)malloc(sizeof(GLfloat) * 12 * (size_t)(lineas > 0 ? lineas : 1));
+    if (!vertices)
+        return -1;
 
-    // Eje Z en azul oscuro
-    glColor3f(0.0f, 0.0f, 0.5f);
-    glVertex3f(0.0f, 0.0f, -500.0f);
-    glVertex3f(0.0f, 0.0f, 500.0f);
+    int n = 0;
+    for (float i = -500.0f; i <= 500.0f && n < 12 * lineas; i += grid_size) {
+        const GLfloat linea[12] = {i, -500.0f, 0.0f, i, 500.0f, 0.0f, -500.0f, i, 0.0f, 500.0f, i, 0.0f};
+        memcpy(&vertices[n], linea, sizeof(linea));
+        n += 12;
+    }
 
-    glEnd();
+    free(malla_vertices);
+    malla_vertices = vertices;
+    malla_num_vertices = n / 3;
+    malla_tamano = grid_size;
+    return 0;
 }
 
 /**
@@ -43,17 +97,16 @@ void dibujar_ejes() {
  * y el movimiento relativo de los objetos en la escena.
  */
 void dibujar_malla(float grid_size) {
-    glColor3f(0.2f, 0.2f, 0.2f); // Gris oscuro
-    glBegin(GL_LINES);
-
-    for (float i = -500.0f; i <= 500.0f; i += grid_size) {
-        glVertex3f(i, -500.0f, 0.0f);
-        glVertex3f(i, 500.0f, 0.0f);
-        glVertex3f(-500.0f, i, 0.0f);
-        glVertex3f(500.0f, i, 0.0f);
-    }
+    if (grid_size <= 0.0f)
+        return;
+    if ((!malla_vertices || grid_size != malla_tamano) && construir_malla(grid_size) != 0)
+        return;
 
-    glEnd();
+    glColor3f(0.2f, 0.2f, 0.2f); // Gris oscuro
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, malla_vertices);
+    glDrawArrays(GL_LINES, 0, malla_num_vertices);
+    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
 /**
@@ -136,21 +189,29 @@ void dibujar_ejes_objeto(triobj *obj) {
     glPointSize(prevPointSize); // Restaurar el tamaño del punto a su valor anterior
 }
 
+/**
+ * Extremos del vector normal de un triángulo: desde el centroide/baricentro
+ * del polígono, en lugar del primer vértice.
+ */
+static void extremos_vector(Triangulo* triangulo, Vector3 normal_vector, Vector3* baricentro, Vector3* end_point) {
+    // Centro del triangulo/poligono, de aquí nacerá el vector.
+    *baricentro = compute_polygon_centroid(triangulo);
+    // Calculo el punto final, +40 ha dicho Joseba.
+    *end_point = (Vector3){baricentro->x + normal_vector.x * PERSPECTIVE_FACTOR*4,
+                           baricentro->y + normal_vector.y * PERSPECTIVE_FACTOR*4,
+                           baricentro->z + normal_vector.z * PERSPECTIVE_FACTOR*4};
+}
+
 /**
  * Dibuja un vector normal a partir de un triángulo dado.
  * Ahora mismo lo hace desde el centroide/baricentro del polígono, en lugar del primer
- * vértice.
+ * vértice. Para dibujar los de muchos triángulos, mejor encolar_vector_normal().
  * @param triangulo Puntero al triángulo del cual se calculará y dibujará el vector normal.
  * @param normal_vector Vector normal que se desea dibujar.
  */
 void draw_vector(Triangulo* triangulo, Vector3 normal_vector) {
-    // Centro del triangulo/poligono, de aquí nacerá el vector.
-    Vector3 baricentro = compute_polygon_centroid(triangulo);
-    //print_vector(&baricentro);
-    // Calculo el punto final, +40 ha dicho Joseba.
-    Vector3 end_point = {baricentro.x + normal_vector.x * PERSPECTIVE_FACTOR*4,
-                         baricentro.y + normal_vector.y * PERSPECTIVE_FACTOR*4,
-                         baricentro.z + normal_vector.z * PERSPECTIVE_FACTOR*4};
+    Vector3 baricentro, end_point;
+    extremos_vector(triangulo, normal_vector, &baricentro, &end_point);
 
     // Establecer el color de la línea a amarillo
     glColor3f(1.0f, 1.0f, 0.0f);
@@ -168,4 +229,62 @@ void draw_vector(Triangulo* triangulo, Vector3 normal_vector) {
 
     // Restablezco ahora el valor que tenía.
     glLineWidth(prevLineWidth);
-}
\ No newline at end of file
+}
+
+/**
+ * Añade el vector normal de un triángulo a los pendientes de dibujar, con
+ * los mismos extremos que draw_vector(). No dibuja nada: quien encola
+ * tiene que llamar a dibujar_vectores_normales() después de recorrer los
+ * triángulos del frame, que es lo que vacía la lista.
+ * @param triangulo Puntero al triángulo del cual se calculará el vector normal.
+ * @param normal_vector Vector normal que se desea dibujar.
+ */
+void encolar_vector_normal(Triangulo* triangulo, Vector3 normal_vector) {
+    Vector3 baricentro, end_point;
+    extremos_vector(triangulo, normal_vector, &baricentro, &end_point);
+
+    if (normales_num_vertices + 2 > normales_capacidad) {
+        int capacidad = normales_capacidad > 0 ? normales_capacidad * 2 : 1024;
+        GLfloat* vertices = (GLfloat*)realloc(normales_vertices, sizeof(GLfloat) * 3 * (size_t)capacidad);
+        if (!vertices)
+            return; // Sin memoria, este vector no se verá
+        normales_vertices = vertices;
+        normales_capacidad = capacidad;
+    }
+
+    GLfloat* v = &normales_vertices[3 * normales_num_vertices];
+    v[0] = baricentro.x;
+    v[1] = baricentro.y;
+    v[2] = baricentro.z;
+    v[3] = end_point.x;
+    v[4] = end_point.y;
+    v[5] = end_point.z;
+    normales_num_vertices += 2;
+}
+
+/**
+ * Dibuja de una vez todos los vectores normales acumulados con
+ * encolar_vector_normal() y vacía la lista. Sólo cambia el grosor de línea una vez
+ * por frame, no una por triángulo.
+ */
+void dibujar_vectores_normales(void) {
+    if (normales_num_vertices == 0)
+        return;
+
+    // Establecer el color de la línea a amarillo
+    glColor3f(1.0f, 1.0f, 0.0f);
+
+    // Capturo el valor actual de linewidth antes de machacarlo.
+    GLfloat prevLineWidth;
+    glGetFloatv(GL_LINE_WIDTH, &prevLineWidth);
+    glLineWidth(3.0f);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, normales_vertices);
+    glDrawArrays(GL_LINES, 0, normales_num_vertices);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    // Restablezco ahora el valor que tenía.
+    glLineWidth(prevLineWidth);
+    normales_num_vertices = 0;
+}
@@ -0,0 +1,190 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                           MALLAS COMPRIMIDAS                        *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo pasa un objeto ya cargado al formato comprimido de
+ * MallaCompacta (ver shared_defines.h), para los modelos enormes en los
+ * que el array de Triangulo no cabe o se come el ancho de banda.
+ *
+ * Un triángulo pasa de 72 bytes (más 36 de normales de vértice) a 36. La
+ * pipeline no descomprime la posición: procesar_escena() transforma los
+ * enteros con la matriz de modelo multiplicada por la de descuantización,
+ * así que el coste por vértice es el mismo que con Punto.
+ ***********************************************************************/
+
+static unsigned short cuantizar(float valor, float min, float inv_escala) {
+    float q = (valor - min) * inv_escala + 0.5f;
+    if (q < 0.0f)
+        q = 0.0f;
+    if (q > CUANTIZACION_MAX)
+        q = CUANTIZACION_MAX;
+    return (unsigned short)q;
+}
+
+/**
+ * Codifica una normal en octaédrico a 8+8 bits. De los cuatro redondeos
+ * posibles se queda con el que decodifica más cerca de la original: con
+ * sólo 8 bits por componente, redondear sin más pierde casi el doble.
+ */
+static void codificar_normal(Vector3 n, unsigned char codigo[2]) {
+    float suma = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    if (suma <= 0.0f) {
+        n = vector3(0.0f, 0.0f, 1.0f);
+        suma = 1.0f;
+    }
+    float x = n.x / suma, y = n.y / suma;
+    if (n.z < 0.0f) {
+        float px = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float py = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = px;
+        y = py;
+    }
+
+    float longitud = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    codigo[0] = codigo[1] = 0;
+    float qx = floorf((x + 1.0f) * 127.5f), qy = floorf((y + 1.0f) * 127.5f);
+    float mejor = -2.0f;
+    for (int i = 0; i < 4; i++) {
+        float cx = qx + (i & 1), cy = qy + (i >> 1);
+        if (cx < 0.0f || cx > 255.0f || cy < 0.0f || cy > 255.0f)
+            continue;
+        unsigned char candidato[2] = {(unsigned char)cx, (unsigned char)cy};
+        Vector3 d = normal_octaedrica(candidato);
+        float coseno = (d.x * n.x + d.y * n.y + d.z * n.z) / longitud;
+        if (coseno > mejor) {
+            mejor = coseno;
+            codigo[0] = candidato[0];
+            codigo[1] = candidato[1];
+        }
+    }
+}
+
+/**
+ * Comprime un objeto: cuantiza posiciones y coordenadas de textura en sus
+ * cajas y codifica las normales de vértice (o la de la cara si no se han
+ * calculado). Libera triptr y normales; a partir de aquí el objeto sólo
+ * se puede leer a través de obj->compacta.
+ * @param obj Objeto con triptr.
+ * @return 0 si todo fue bien, -1 si no hay memoria o ya estaba comprimido.
+ */
+int comprimir_triobj(triobj* obj) {
+    if (!obj->triptr || obj->compacta)
+        return -1;
+
+    long esquinas = 3L * obj->num_triangles;
+    MallaCompacta* c = (MallaCompacta*)calloc(1, sizeof(MallaCompacta));
+    PuntoCompacto* vertices = (PuntoCompacto*)malloc(sizeof(PuntoCompacto) * (size_t)(esquinas > 0 ? esquinas : 1));
+    if (!c || !vertices) {
+        free(c);
+        free(vertices);
+        return -1;
+    }
+
+    float min[5] = {INFINITY, INFINITY, INFINITY, INFINITY, INFINITY};
+    float max[5] = {-INFINITY, -INFINITY, -INFINITY, -INFINITY, -INFINITY};
+    for (long e = 0; e < esquinas; e++) {
+        const Punto* p = &(&obj->triptr[e / 3].p1)[e % 3];
+        float v[5] = {p->x, p->y, p->z, p->u, p->v};
+        for (int k = 0; k < 5; k++) {
+            if (v[k] < min[k]) min[k] = v[k];
+            if (v[k] > max[k]) max[k] = v[k];
+        }
+    }
+
+    float inv_escala[5];
+    for (int k = 0; k < 5; k++) {
+        if (esquinas == 0)
+            min[k] = max[k] = 0.0f;
+        float escala = (max[k] - min[k]) / CUANTIZACION_MAX;
+        inv_escala[k] = escala > 0.0f ? 1.0f / escala : 0.0f;
+        if (k < 3) {
+            c->min[k] = min[k];
+            c->escala[k] = escala;
+        } else {
+            c->uv_min[k - 3] = min[k];
+            c->uv_escala[k - 3] = escala;
+        }
+    }
+
+    for (int t = 0; t < obj->num_triangles; t++) {
+        Vector3 cara;
+        obtain_normal_vector(&obj->triptr[t], &cara);
+
+        for (int k = 0; k < 3; k++) {
+            const Punto* p = &(&obj->triptr[t].p1)[k];
+            PuntoCompacto* q = &vertices[3L * t + k];
+            q->x = cuantizar(p->x, min[0], inv_escala[0]);
+            q->y = cuantizar(p->y, min[1], inv_escala[1]);
+            q->z = cuantizar(p->z, min[2], inv_escala[2]);
+            q->u = cuantizar(p->u, min[3], inv_escala[3]);
+            q->v = cuantizar(p->v, min[4], inv_escala[4]);
+            codificar_normal(obj->normales ? obj->normales[3L * t + k] : cara, q->normal);
+        }
+    }
+
+    c->vertices = vertices;
+    obj->compacta = c;
+
+    free(obj->triptr);
+    free(obj->normales);
+    descartar_triangulos_mundo(obj);
+    liberar_conos(obj);
+    obj->triptr = NULL;
+    obj->normales = NULL;
+    // Las normales en mundo se vuelven a sacar de las codificadas.
+    obj->normales_mptr = NULL;
+    return 0;
+}
+
+/**
+ * Matriz de modelo con la descuantización incluida: m * D, donde D lleva
+ * las coordenadas cuantizadas a coordenadas de objeto (escala por eje y
+ * origen de la caja).
+ * @param c Malla comprimida.
+ * @param m Matriz de modelo del objeto.
+ * @param resultado Salida: matriz que transforma los enteros directamente.
+ */
+void matriz_descuantizada(const MallaCompacta* c, const double m[16], double resultado[16]) {
+    for (int i = 0; i < 4; i++) {
+        const double* fila = &m[i * 4];
+        resultado[i * 4 + 0] = fila[0] * c->escala[0];
+        resultado[i * 4 + 1] = fila[1] * c->escala[1];
+        resultado[i * 4 + 2] = fila[2] * c->escala[2];
+        resultado[i * 4 + 3] = fila[0] * c->min[0] + fila[1] * c->min[1] + fila[2] * c->min[2] + fila[3];
+    }
+}
+
+/**
+ * Memoria que ocupan los datos de un objeto (triángulos o su versión
+ * comprimida, normales, índices, niveles de detalle, copia en mundo,
+ * conos de normales y matriz actual), para los informes.
+ * @param obj Objeto.
+ * @return Bytes.
+ */
+size_t memoria_triobj(const triobj* obj) {
+    size_t esquinas = 3 * (size_t)obj->num_triangles;
+    size_t bytes = sizeof(triobj) + sizeof(mlist);
+
+    if (obj->triptr)
+        bytes += sizeof(Triangulo) * (size_t)obj->num_triangles;
+    if (obj->normales)
+        bytes += sizeof(Vector3) * esquinas;
+    if (obj->normales_mundo)
+        bytes += sizeof(Vector3) * esquinas;
+    if (obj->triangulos_mundo)
+        bytes += (sizeof(Triangulo) + sizeof(Vector3)) * (size_t)obj->num_triangles;
+    if (obj->indices)
+        bytes += sizeof(int) * esquinas;
+    if (obj->compacta)
+        bytes += sizeof(MallaCompacta) + sizeof(PuntoCompacto) * esquinas;
+    for (int i = 0; i < obj->num_lods; i++)
+        bytes += sizeof(NivelDetalle) + sizeof(Triangulo) * (size_t)obj->lods[i].num_triangles;
+    bytes += memoria_conos(obj);
+    return bytes;
+}
@@ -0,0 +1,286 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                      GENERACIÓN PROCEDURAL DE MALLAS                *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo genera mallas de triángulos directamente en memoria
+ * (cilindros, esferas y mallas teseladas), con el número de triángulos
+ * que se pida, para poder probar el escalado de la pipeline sin tener
+ * que cargar ficheros enormes con cargar_triangulos().
+ *
+ * Los triángulos se generan en sentido antihorario visto desde fuera,
+ * de forma que obtain_normal_vector() devuelve normales hacia el exterior,
+ * y con coordenadas de textura normalizadas en [0, 1].
+ ***********************************************************************/
+
+/**
+ * Crea un objeto a partir de un array de triángulos, con la matriz de
+ * transformación inicial a identidad, su caja y las normales de vértice
+ * (con el índice de vértices) ya calculadas. El resto de campos quedan a
+ * cero.
+ * @param triangulos Array de triángulos (el objeto pasa a ser su dueño).
+ * @param num_triangulos Número de triángulos del array.
+ * @return Puntero al objeto creado, o NULL si no hay memoria.
+ */
+triobj* crear_triobj(Triangulo* triangulos, int num_triangulos) {
+    triobj* obj = (triobj*)calloc(1, sizeof(triobj));
+    if (!obj)
+        return NULL;
+
+    obj->mptr = (mlist*)calloc(1, sizeof(mlist));
+    if (!obj->mptr) {
+        free(obj);
+        return NULL;
+    }
+    obj->mptr->m[0] = obj->mptr->m[5] = obj->mptr->m[10] = obj->mptr->m[15] = 1.0;
+
+    obj->triptr = triangulos;
+    obj->num_triangles = num_triangulos;
+
+    for (int k = 0; k < 3; k++) {
+        obj->caja_min[k] = num_triangulos > 0 ? INFINITY : 0.0f;
+        obj->caja_max[k] = num_triangulos > 0 ? -INFINITY : 0.0f;
+    }
+    for (long e = 0; e < 3L * num_triangulos; e++) {
+        const Punto* p = &(&triangulos[e / 3].p1)[e % 3];
+        float v[3] = {p->x, p->y, p->z};
+        for (int k = 0; k < 3; k++) {
+            if (v[k] < obj->caja_min[k]) obj->caja_min[k] = v[k];
+            if (v[k] > obj->caja_max[k]) obj->caja_max[k] = v[k];
+        }
+    }
+
+    // Las normales de vértice se calculan al cargar; si no hay memoria el
+    // objeto sigue siendo válido y el Gouraud usa la normal de cada cara.
+    calcular_normales_vertice(obj, NORMALES_ANGULO_PLIEGUE);
+    return obj;
+}
+
+/**
+ * Libera un objeto, su historial de matrices, sus triángulos (o su malla
+ * comprimida) y sus normales.
+ * @param obj Objeto a liberar.
+ */
+void liberar_triobj(triobj* obj) {
+    if (!obj)
+        return;
+
+    mlist* m = obj->mptr;
+    while (m) {
+        mlist* anterior = m->hptr;
+        free(m);
+        m = anterior;
+    }
+
+    free(obj->triptr);
+    free(obj->normales);
+    free(obj->normales_mundo);
+    free(obj->triangulos_mundo);
+    free(obj->caras_mundo);
+    free(obj->indices);
+    liberar_lods(obj);
+    liberar_conos(obj);
+    if (obj->compacta)
+        free(obj->compacta->vertices);
+    free(obj->compacta);
+    free(obj);
+}
+
+static Punto punto_uv(float x, float y, float z, float u, float v) {
+    Punto p = {x, y, z, u, v, 1.0f};
+    return p;
+}
+
+static void emitir_quad(Triangulo* t, int* n, Punto a, Punto b, Punto c, Punto d) {
+    // a-b-c-d en sentido antihorario
+    t[(*n)++] = (Triangulo){a, b, c};
+    t[(*n)++] = (Triangulo){a, c, d};
+}
+
+/**
+ * Genera un cilindro con eje en Y, centrado en el origen, con tapas.
+ * Se reparten segmentos y anillos para acercarse al número de triángulos
+ * pedido (2 * segmentos * (anillos + 1)).
+ * @param radio Radio del cilindro.
+ * @param altura Altura del cilindro.
+ * @param num_triangulos Número aproximado de triángulos deseado.
+ * @return Objeto generado, o NULL si no hay memoria.
+ */
+triobj* generar_cilindro(float radio, float altura, long num_triangulos) {
+    // Segmentos ~ raíz del total, para que los triángulos no queden muy alargados.
+    int segmentos = (int)sqrt((double)num_triangulos / 2.0);
+    if (segmentos < 3)
+        segmentos = 3;
+    int anillos = (int)(num_triangulos / (2L * segmentos)) - 1;
+    if (anillos < 1)
+        anillos = 1;
+
+    long total = 2L * segmentos * anillos + 2L * segmentos;
+    Triangulo* t = (Triangulo*)malloc(sizeof(Triangulo) * total);
+    if (!t)
+        return NULL;
+
+    int n = 0;
+    float y0 = -altura / 2.0f;
+
+    // Cara lateral
+    for (int a = 0; a < anillos; a++) {
+        float v0 = (float)a / anillos, v1 = (float)(a + 1) / anillos;
+        for (int s = 0; s < segmentos; s++) {
+            float u0 = (float)s / segmentos, u1 = (float)(s + 1) / segmentos;
+            float th0 = 2.0f * PI * u0, th1 = 2.0f * PI * u1;
+            Punto p00 = punto_uv(radio * sinf(th0), y0 + altura * v0, radio * cosf(th0), u0, v0);
+            Punto p10 = punto_uv(radio * sinf(th1), y0 + altura * v0, radio * cosf(th1), u1, v0);
+            Punto p11 = punto_uv(radio * sinf(th1), y0 + altura * v1, radio * cosf(th1), u1, v1);
+            Punto p01 = punto_uv(radio * sinf(th0), y0 + altura * v1, radio * cosf(th0), u0, v1);
+            emitir_quad(t, &n, p00, p10, p11, p01);
+        }
+    }
+
+    // Tapas, en abanico desde el centro
+    Punto centro_sup = punto_uv(0.0f, -y0, 0.0f, 0.5f, 0.5f);
+    Punto centro_inf = punto_uv(0.0f, y0, 0.0f, 0.5f, 0.5f);
+    for (int s = 0; s < segmentos; s++) {
+        float th0 = 2.0f * PI * s / segmentos, th1 = 2.0f * PI * (s + 1) / segmentos;
+        float x0 = sinf(th0), z0 = cosf(th0), x1 = sinf(th1), z1 = cosf(th1);
+        Punto a_sup = punto_uv(radio * x0, -y0, radio * z0, 0.5f + 0.5f * x0, 0.5f + 0.5f * z0);
+        Punto b_sup = punto_uv(radio * x1, -y0, radio * z1, 0.5f + 0.5f * x1, 0.5f + 0.5f * z1);
+        Punto a_inf = punto_uv(radio * x0, y0, radio * z0, 0.5f + 0.5f * x0, 0.5f + 0.5f * z0);
+        Punto b_inf = punto_uv(radio * x1, y0, radio * z1, 0.5f + 0.5f * x1, 0.5f + 0.5f * z1);
+        t[n++] = (Triangulo){centro_sup, a_sup, b_sup};
+        t[n++] = (Triangulo){centro_inf, b_inf, a_inf};
+    }
+
+    triobj* obj = crear_triobj(t, n);
+    if (!obj)
+        free(t);
+    return obj;
+}
+
+/**
+ * Genera una esfera UV centrada en el origen. Con S pilas y 2S meridianos
+ * salen 4S(S-1) triángulos; S se ajusta al número pedido.
+ * @param radio Radio de la esfera.
+ * @param num_triangulos Número aproximado de triángulos deseado.
+ * @return Objeto generado, o NULL si no hay memoria.
+ */
+triobj* generar_esfera(float radio, long num_triangulos) {
+    int pilas = (int)(0.5 + sqrt((double)num_triangulos / 4.0));
+    if (pilas < 3)
+        pilas = 3;
+    int meridianos = 2 * pilas;
+
+    long total = 2L * meridianos * (pilas - 1);
+    Triangulo* t = (Triangulo*)malloc(sizeof(Triangulo) * total);
+    if (!t)
+        return NULL;
+
+    int n = 0;
+    for (int i = 0; i < pilas; i++) {
+        float v0 = (float)i / pilas, v1 = (float)(i + 1) / pilas;
+        float phi0 = PI * v0, phi1 = PI * v1;
+        for (int j = 0; j < meridianos; j++) {
+            float u0 = (float)j / meridianos, u1 = (float)(j + 1) / meridianos;
+            float th0 = 2.0f * PI * u0, th1 = 2.0f * PI * u1;
+
+            // Desde el polo norte (y = radio) hacia el sur.
+            Punto p00 = punto_uv(radio * sinf(phi0) * sinf(th0), radio * cosf(phi0), radio * sinf(phi0) * cosf(th0), u0, 1.0f - v0);
+            Punto p10 = punto_uv(radio * sinf(phi0) * sinf(th1), radio * cosf(phi0), radio * sinf(phi0) * cosf(th1), u1, 1.0f - v0);
+            Punto p11 = punto_uv(radio * sinf(phi1) * sinf(th1), radio * cosf(phi1), radio * sinf(phi1) * cosf(th1), u1, 1.0f - v1);
+            Punto p01 = punto_uv(radio * sinf(phi1) * sinf(th0), radio * cosf(phi1), radio * sinf(phi1) * cosf(th0), u0, 1.0f - v1);
+
+            // En los polos uno de los triángulos del quad es degenerado, se omite.
+            if (i != 0)
+                t[n++] = (Triangulo){p00, p01, p10};
+            if (i != pilas - 1)
+                t[n++] = (Triangulo){p10, p01, p11};
+        }
+    }
+
+    triobj* obj = crear_triobj(t, n);
+    if (!obj)
+        free(t);
+    return obj;
+}
+
+/**
+ * Genera una malla teselada en el plano XY (como la de dibujar_malla),
+ * centrada en el origen y mirando hacia +Z.
+ * @param ancho, alto Dimensiones de la malla.
+ * @param num_triangulos Número aproximado de triángulos deseado.
+ * @return Objeto generado, o NULL si no hay memoria.
+ */
+triobj* generar_malla_teselada(float ancho, float alto, long num_triangulos) {
+    int celdas = (int)sqrt((double)num_triangulos / 2.0);
+    if (celdas < 1)
+        celdas = 1;
+
+    long total = 2L * celdas * celdas;
+    Triangulo* t = (Triangulo*)malloc(sizeof(Triangulo) * total);
+    if (!t)
+        return NULL;
+
+    int n = 0;
+    for (int i = 0; i < celdas; i++) {
+        float v0 = (float)i / celdas, v1 = (float)(i + 1) / celdas;
+        for (int j = 0; j < celdas; j++) {
+            float u0 = (float)j / celdas, u1 = (float)(j + 1) / celdas;
+            Punto p00 = punto_uv(-ancho / 2 + ancho * u0, -alto / 2 + alto * v0, 0.0f, u0, v0);
+            Punto p10 = punto_uv(-ancho / 2 + ancho * u1, -alto / 2 + alto * v0, 0.0f, u1, v0);
+            Punto p11 = punto_uv(-ancho / 2 + ancho * u1, -alto / 2 + alto * v1, 0.0f, u1, v1);
+            Punto p01 = punto_uv(-ancho / 2 + ancho * u0, -alto / 2 + alto * v1, 0.0f, u0, v1);
+            emitir_quad(t, &n, p00, p10, p11, p01);
+        }
+    }
+
+    triobj* obj = crear_triobj(t, n);
+    if (!obj)
+        free(t);
+    return obj;
+}
+
+/**
+ * Construye la escena de prueba de los benchmarks: un cilindro en el origen,
+ * una esfera desplazada en X y una malla teselada detrás, repartiendo entre
+ * los tres los num_triangulos pedidos. El cilindro es el primero de la lista.
+ * @param num_triangulos Número total aproximado de triángulos.
+ * @return Primer objeto de la lista, o NULL si no hay memoria.
+ */
+triobj* generar_escena_prueba(long num_triangulos) {
+    long por_objeto = num_triangulos / 3 > 0 ? num_triangulos / 3 : 1;
+
+    triobj* cilindro = generar_cilindro(60.0f, 200.0f, por_objeto);
+    triobj* esfera = generar_esfera(80.0f, por_objeto);
+    triobj* malla = generar_malla_teselada(400.0f, 400.0f, por_objeto);
+    if (!cilindro || !esfera || !malla) {
+        liberar_triobj(cilindro);
+        liberar_triobj(esfera);
+        liberar_triobj(malla);
+        return NULL;
+    }
+
+    // Los colocamos con traslaciones en su matriz de modelo, como haría el usuario.
+    esfera->mptr->m[3] = 250.0;
+    malla->mptr->m[11] = -200.0;
+
+    cilindro->hptr = esfera;
+    esfera->hptr = malla;
+    return cilindro;
+}
+
+/**
+ * Libera todos los objetos de una lista enlazada por hptr.
+ * @param lista Primer objeto de la lista.
+ */
+void liberar_escena(triobj* lista) {
+    while (lista) {
+        triobj* siguiente = lista->hptr;
+        liberar_triobj(lista);
+        lista = siguiente;
+    }
+}
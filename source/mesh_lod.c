@@ -0,0 +1,616 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                           NIVELES DE DETALLE                        *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo genera versiones simplificadas de cada objeto y elige cada
+ * frame cuál usar. Sin esto, un cilindro que ocupa cuatro píxeles pasa
+ * por camera_pipeline() con todos sus triángulos.
+ *
+ * La simplificación es la de colapso de aristas con error cuadrático
+ * (Garland y Heckbert): cada vértice acumula los planos de sus caras y
+ * el coste de juntar dos vértices es la suma de distancias al cuadrado
+ * del punto resultante a esos planos. Se colapsa siempre la arista más
+ * barata, sin dejar que ninguna cara se dé la vuelta, y los bordes
+ * abiertos se sujetan con planos perpendiculares de mucho peso. Los
+ * niveles salen de una sola pasada: se guarda una copia cada vez que el
+ * número de caras baja a LOD_REDUCCION del nivel anterior.
+ *
+ * Se trabaja sobre los vértices soldados de obj->indices, así que en las
+ * costuras de textura la uv de los niveles simplificados es la de una de
+ * las esquinas. Para lo que se ve de lejos no se nota.
+ ***********************************************************************/
+
+#define LOD_DESEMPATE 1e-4
+
+// Cuadrica simétrica 4x4: a2 ab ac ad b2 bc bd c2 cd d2
+typedef struct {
+    double q[10];
+} Cuadrica;
+
+typedef struct {
+    double coste;
+    int a, b;                 // b se junta con a
+    int version_a, version_b; // Para descartar colapsos con vértices que ya han cambiado
+    double destino[3];
+} Colapso;
+
+typedef struct {
+    int* caras;
+    int num, capacidad;
+    int propia;               // caras es memoria propia y no de la reserva inicial
+} ListaCaras;
+
+typedef struct {
+    unsigned long long clave; // (menor << 32) | mayor
+    int cara;
+} Arista;
+
+typedef struct {
+    int num_vertices;
+    double (*pos)[3];
+    float (*uv)[2];
+    Cuadrica* cuadricas;
+    int* version;
+    int* marca;               // Vecinos ya vistos en el colapso número sello
+    int sello;
+    unsigned char* vivo;
+
+    int num_caras, caras_vivas;
+    int (*cara)[3];
+    unsigned char* cara_viva;
+    ListaCaras* adyacentes;
+    int* reserva;
+
+    Colapso* monticulo;
+    long num_colapsos, capacidad_colapsos;
+    double error_max;
+} Simplificador;
+
+static void cuadrica_plano(Cuadrica* c, double a, double b, double cc, double d, double peso) {
+    double* q = c->q;
+    q[0] += peso * a * a;  q[1] += peso * a * b;  q[2] += peso * a * cc;  q[3] += peso * a * d;
+    q[4] += peso * b * b;  q[5] += peso * b * cc; q[6] += peso * b * d;
+    q[7] += peso * cc * cc; q[8] += peso * cc * d;
+    q[9] += peso * d * d;
+}
+
+static double cuadrica_error(const double q[10], const double p[3]) {
+    double x = p[0], y = p[1], z = p[2];
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x + q[4] * y * y + 2 * q[5] * y * z +
+           2 * q[6] * y + q[7] * z * z + 2 * q[8] * z + q[9];
+}
+
+static void normal_cara(const double a[3], const double b[3], const double c[3], double n[3]) {
+    double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/***********************************************************************
+ * Montículo de colapsos (el más barato arriba).
+ ***********************************************************************/
+
+static int monticulo_meter(Simplificador* s, const Colapso* c) {
+    if (s->num_colapsos == s->capacidad_colapsos) {
+        long capacidad = s->capacidad_colapsos > 0 ? s->capacidad_colapsos * 2 : 1024;
+        Colapso* nuevo = (Colapso*)realloc(s->monticulo, sizeof(Colapso) * (size_t)capacidad);
+        if (!nuevo)
+            return -1;
+        s->monticulo = nuevo;
+        s->capacidad_colapsos = capacidad;
+    }
+
+    long i = s->num_colapsos++;
+    while (i > 0) {
+        long padre = (i - 1) / 2;
+        if (s->monticulo[padre].coste <= c->coste)
+            break;
+        s->monticulo[i] = s->monticulo[padre];
+        i = padre;
+    }
+    s->monticulo[i] = *c;
+    return 0;
+}
+
+static Colapso monticulo_sacar(Simplificador* s) {
+    Colapso primero = s->monticulo[0];
+    Colapso ultimo = s->monticulo[--s->num_colapsos];
+    long i = 0, n = s->num_colapsos;
+
+    for (;;) {
+        long hijo = 2 * i + 1;
+        if (hijo >= n)
+            break;
+        if (hijo + 1 < n && s->monticulo[hijo + 1].coste < s->monticulo[hijo].coste)
+            hijo++;
+        if (ultimo.coste <= s->monticulo[hijo].coste)
+            break;
+        s->monticulo[i] = s->monticulo[hijo];
+        i = hijo;
+    }
+    if (n > 0)
+        s->monticulo[i] = ultimo;
+    return primero;
+}
+
+/**
+ * Calcula el mejor punto para juntar a y b y lo mete en el montículo. El
+ * punto óptimo sale de resolver el sistema de la cuádrica; si es singular
+ * o queda lejos de la arista, se prueba con los extremos y el punto medio.
+ */
+static int meter_colapso(Simplificador* s, int a, int b) {
+    Cuadrica q;
+    for (int k = 0; k < 10; k++)
+        q.q[k] = s->cuadricas[a].q[k] + s->cuadricas[b].q[k];
+
+    const double* pa = s->pos[a];
+    const double* pb = s->pos[b];
+    double medio[3] = {(pa[0] + pb[0]) / 2, (pa[1] + pb[1]) / 2, (pa[2] + pb[2]) / 2};
+    double longitud2 = (pb[0] - pa[0]) * (pb[0] - pa[0]) + (pb[1] - pa[1]) * (pb[1] - pa[1]) +
+                       (pb[2] - pa[2]) * (pb[2] - pa[2]);
+
+    Colapso c = {0};
+    c.a = a;
+    c.b = b;
+    c.version_a = s->version[a];
+    c.version_b = s->version[b];
+    c.coste = INFINITY;
+
+    const double* m = q.q;
+    double det = m[0] * (m[4] * m[7] - m[5] * m[5]) - m[1] * (m[1] * m[7] - m[5] * m[2]) +
+                 m[2] * (m[1] * m[5] - m[4] * m[2]);
+    double traza = fabs(m[0]) + fabs(m[4]) + fabs(m[7]);
+    if (fabs(det) > 1e-9 * traza * traza * traza) {
+        double r[3] = {-m[3], -m[6], -m[8]};
+        double optimo[3] = {
+            (r[0] * (m[4] * m[7] - m[5] * m[5]) - m[1] * (r[1] * m[7] - m[5] * r[2]) + m[2] * (r[1] * m[5] - m[4] * r[2])) / det,
+            (m[0] * (r[1] * m[7] - m[5] * r[2]) - r[0] * (m[1] * m[7] - m[5] * m[2]) + m[2] * (m[1] * r[2] - r[1] * m[2])) / det,
+            (m[0] * (m[4] * r[2] - r[1] * m[5]) - m[1] * (m[1] * r[2] - r[1] * m[2]) + r[0] * (m[1] * m[5] - m[4] * m[2])) / det,
+        };
+        double distancia2 = (optimo[0] - medio[0]) * (optimo[0] - medio[0]) +
+                            (optimo[1] - medio[1]) * (optimo[1] - medio[1]) +
+                            (optimo[2] - medio[2]) * (optimo[2] - medio[2]);
+        if (distancia2 <= longitud2) {
+            c.coste = cuadrica_error(m, optimo);
+            memcpy(c.destino, optimo, sizeof(optimo));
+        }
+    }
+
+    const double* candidatos[3] = {pa, pb, medio};
+    for (int i = 0; i < 3; i++) {
+        double coste = cuadrica_error(m, candidatos[i]);
+        if (coste < c.coste) {
+            c.coste = coste;
+            memcpy(c.destino, candidatos[i], sizeof(c.destino));
+        }
+    }
+    if (c.coste < 0.0)
+        c.coste = 0.0; // Redondeo
+
+    // En zonas planas todos los colapsos cuestan 0 y, sin desempate, un
+    // vértice se come a sus vecinos uno tras otro y acaba con cientos de
+    // caras. Un poco de la longitud de la arista hace que vayan primero
+    // las cortas, repartidas por toda la malla.
+    c.coste += LOD_DESEMPATE * longitud2;
+    return monticulo_meter(s, &c);
+}
+
+/**
+ * Comprueba si mover v a destino daría la vuelta a alguna de sus caras
+ * (las que comparte con otro desaparecen y no cuentan).
+ */
+static int invierte_caras(const Simplificador* s, int v, int otro, const double destino[3]) {
+    const ListaCaras* lista = &s->adyacentes[v];
+    for (int i = 0; i < lista->num; i++) {
+        int f = lista->caras[i];
+        const int* cara = s->cara[f];
+        if (!s->cara_viva[f] || cara[0] == otro || cara[1] == otro || cara[2] == otro)
+            continue;
+
+        const double* p[3] = {s->pos[cara[0]], s->pos[cara[1]], s->pos[cara[2]]};
+        double antes[3], despues[3];
+        normal_cara(p[0], p[1], p[2], antes);
+        for (int k = 0; k < 3; k++) {
+            if (cara[k] == v)
+                p[k] = destino;
+        }
+        normal_cara(p[0], p[1], p[2], despues);
+        if (antes[0] * despues[0] + antes[1] * despues[1] + antes[2] * despues[2] <= 0.0)
+            return 1;
+    }
+    return 0;
+}
+
+static int lista_anadir(ListaCaras* lista, int cara) {
+    if (lista->num == lista->capacidad) {
+        int capacidad = lista->capacidad > 4 ? lista->capacidad * 2 : 8;
+        int* caras = lista->propia ? (int*)realloc(lista->caras, sizeof(int) * (size_t)capacidad)
+                                   : (int*)malloc(sizeof(int) * (size_t)capacidad);
+        if (!caras)
+            return -1;
+        if (!lista->propia && lista->num > 0)
+            memcpy(caras, lista->caras, sizeof(int) * (size_t)lista->num);
+        lista->caras = caras;
+        lista->capacidad = capacidad;
+        lista->propia = 1;
+    }
+    lista->caras[lista->num++] = cara;
+    return 0;
+}
+
+/**
+ * Junta b con a en el destino del colapso: a se queda con la cuádrica de
+ * los dos y con las caras de b que no desaparecen, y se vuelven a meter
+ * en el montículo las aristas de a con sus vecinos.
+ */
+static int colapsar(Simplificador* s, const Colapso* c) {
+    int u = c->a, v = c->b;
+
+    // La uv se interpola según dónde queda el punto sobre la arista.
+    double ab[3] = {s->pos[v][0] - s->pos[u][0], s->pos[v][1] - s->pos[u][1], s->pos[v][2] - s->pos[u][2]};
+    double longitud2 = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+    double t = longitud2 > 0.0 ? ((c->destino[0] - s->pos[u][0]) * ab[0] + (c->destino[1] - s->pos[u][1]) * ab[1] +
+                                  (c->destino[2] - s->pos[u][2]) * ab[2]) / longitud2
+                               : 0.0;
+    if (t < 0.0) t = 0.0;
+    if (t > 1.0) t = 1.0;
+    s->uv[u][0] += (float)t * (s->uv[v][0] - s->uv[u][0]);
+    s->uv[u][1] += (float)t * (s->uv[v][1] - s->uv[u][1]);
+
+    memcpy(s->pos[u], c->destino, sizeof(c->destino));
+    for (int k = 0; k < 10; k++)
+        s->cuadricas[u].q[k] += s->cuadricas[v].q[k];
+    s->version[u]++;
+    s->vivo[v] = 0;
+    if (c->coste > s->error_max)
+        s->error_max = c->coste;
+
+    ListaCaras* lu = &s->adyacentes[u];
+    ListaCaras* lv = &s->adyacentes[v];
+    for (int i = 0; i < lv->num; i++) {
+        int f = lv->caras[i];
+        int* cara = s->cara[f];
+        if (!s->cara_viva[f])
+            continue;
+        if (cara[0] == u || cara[1] == u || cara[2] == u) {
+            s->cara_viva[f] = 0;
+            s->caras_vivas--;
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (cara[k] == v)
+                cara[k] = u;
+        }
+        if (lista_anadir(lu, f) != 0)
+            return -1;
+    }
+    if (lv->propia)
+        free(lv->caras);
+    lv->caras = NULL;
+    lv->num = lv->capacidad = lv->propia = 0;
+
+    // De paso se quitan de la lista de u las caras muertas.
+    int marca = ++s->sello;
+    s->marca[u] = marca;
+    int n = 0;
+    for (int i = 0; i < lu->num; i++) {
+        int f = lu->caras[i];
+        if (!s->cara_viva[f])
+            continue;
+        lu->caras[n++] = f;
+        for (int k = 0; k < 3; k++) {
+            int w = s->cara[f][k];
+            if (s->marca[w] == marca)
+                continue;
+            s->marca[w] = marca;
+            if (meter_colapso(s, u, w) != 0)
+                return -1;
+        }
+    }
+    lu->num = n;
+    return 0;
+}
+
+static int comparar_aristas(const void* a, const void* b) {
+    unsigned long long x = ((const Arista*)a)->clave, y = ((const Arista*)b)->clave;
+    return (x > y) - (x < y);
+}
+
+static void liberar_simplificador(Simplificador* s) {
+    if (s->adyacentes) {
+        for (int v = 0; v < s->num_vertices; v++) {
+            if (s->adyacentes[v].propia)
+                free(s->adyacentes[v].caras);
+        }
+    }
+    free(s->pos);
+    free(s->uv);
+    free(s->cuadricas);
+    free(s->version);
+    free(s->marca);
+    free(s->vivo);
+    free(s->cara);
+    free(s->cara_viva);
+    free(s->adyacentes);
+    free(s->reserva);
+    free(s->monticulo);
+}
+
+/**
+ * Prepara vértices, caras, adyacencia y cuádricas, y mete en el montículo
+ * todas las aristas.
+ */
+static int preparar_simplificador(Simplificador* s, const triobj* obj) {
+    int nv = obj->num_vertices, nf = obj->num_triangles;
+    s->num_vertices = nv;
+    s->num_caras = nf;
+    s->pos = malloc(sizeof(*s->pos) * (size_t)nv);
+    s->uv = malloc(sizeof(*s->uv) * (size_t)nv);
+    s->cuadricas = (Cuadrica*)calloc((size_t)nv, sizeof(Cuadrica));
+    s->version = (int*)calloc((size_t)nv, sizeof(int));
+    s->marca = (int*)calloc((size_t)nv, sizeof(int));
+    s->vivo = (unsigned char*)malloc((size_t)nv);
+    s->cara = malloc(sizeof(*s->cara) * (size_t)nf);
+    s->cara_viva = (unsigned char*)malloc((size_t)nf);
+    s->adyacentes = (ListaCaras*)calloc((size_t)nv, sizeof(ListaCaras));
+    s->reserva = (int*)malloc(sizeof(int) * 3 * (size_t)nf);
+    Arista* aristas = (Arista*)malloc(sizeof(Arista) * 3 * (size_t)nf);
+    if (!s->pos || !s->uv || !s->cuadricas || !s->version || !s->marca || !s->vivo || !s->cara || !s->cara_viva ||
+        !s->adyacentes || !s->reserva || !aristas) {
+        free(aristas);
+        return -1;
+    }
+
+    memset(s->vivo, 1, (size_t)nv);
+    for (long e = 0; e < 3L * nf; e++) {
+        const Punto* p = &(&obj->triptr[e / 3].p1)[e % 3];
+        int v = obj->indices[e];
+        s->pos[v][0] = p->x;
+        s->pos[v][1] = p->y;
+        s->pos[v][2] = p->z;
+        s->uv[v][0] = p->u;
+        s->uv[v][1] = p->v;
+    }
+
+    // Caras (las degeneradas por la soldadura se descartan) y sus planos.
+    s->caras_vivas = 0;
+    for (int f = 0; f < nf; f++) {
+        int* cara = s->cara[f];
+        for (int k = 0; k < 3; k++)
+            cara[k] = obj->indices[3L * f + k];
+        s->cara_viva[f] = cara[0] != cara[1] && cara[1] != cara[2] && cara[0] != cara[2];
+        if (!s->cara_viva[f])
+            continue;
+        s->caras_vivas++;
+
+        double n[3];
+        normal_cara(s->pos[cara[0]], s->pos[cara[1]], s->pos[cara[2]], n);
+        double longitud = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (longitud <= 0.0)
+            continue;
+        n[0] /= longitud; n[1] /= longitud; n[2] /= longitud;
+        double d = -(n[0] * s->pos[cara[0]][0] + n[1] * s->pos[cara[0]][1] + n[2] * s->pos[cara[0]][2]);
+        for (int k = 0; k < 3; k++) {
+            cuadrica_plano(&s->cuadricas[cara[k]], n[0], n[1], n[2], d, 1.0);
+            s->adyacentes[cara[k]].num++;
+        }
+    }
+
+    // Adyacencia inicial en una sola reserva, como en las normales de vértice.
+    int inicio = 0;
+    for (int v = 0; v < nv; v++) {
+        s->adyacentes[v].caras = &s->reserva[inicio];
+        s->adyacentes[v].capacidad = s->adyacentes[v].num;
+        inicio += s->adyacentes[v].num;
+        s->adyacentes[v].num = 0;
+    }
+    long num_aristas = 0;
+    for (int f = 0; f < nf; f++) {
+        if (!s->cara_viva[f])
+            continue;
+        for (int k = 0; k < 3; k++) {
+            int a = s->cara[f][k], b = s->cara[f][(k + 1) % 3];
+            ListaCaras* lista = &s->adyacentes[a];
+            lista->caras[lista->num++] = f;
+            unsigned long long menor = (unsigned)(a < b ? a : b), mayor = (unsigned)(a < b ? b : a);
+            aristas[num_aristas++] = (Arista){(menor << 32) | mayor, f};
+        }
+    }
+    qsort(aristas, (size_t)num_aristas, sizeof(Arista), comparar_aristas);
+
+    // Las aristas de una sola cara son borde: se sujetan con un plano que
+    // contiene la arista y es perpendicular a la cara.
+    for (long i = 0; i < num_aristas; i++) {
+        int borde = (i == 0 || aristas[i - 1].clave != aristas[i].clave) &&
+                    (i + 1 == num_aristas || aristas[i + 1].clave != aristas[i].clave);
+        if (!borde)
+            continue;
+
+        int a = (int)(aristas[i].clave >> 32), b = (int)(aristas[i].clave & 0xffffffffu);
+        const int* cara = s->cara[aristas[i].cara];
+        double n[3], e[3] = {s->pos[b][0] - s->pos[a][0], s->pos[b][1] - s->pos[a][1], s->pos[b][2] - s->pos[a][2]};
+        normal_cara(s->pos[cara[0]], s->pos[cara[1]], s->pos[cara[2]], n);
+        double p[3] = {e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0]};
+        double longitud = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (longitud <= 0.0)
+            continue;
+        p[0] /= longitud; p[1] /= longitud; p[2] /= longitud;
+        double d = -(p[0] * s->pos[a][0] + p[1] * s->pos[a][1] + p[2] * s->pos[a][2]);
+        cuadrica_plano(&s->cuadricas[a], p[0], p[1], p[2], d, LOD_PESO_BORDE);
+        cuadrica_plano(&s->cuadricas[b], p[0], p[1], p[2], d, LOD_PESO_BORDE);
+    }
+
+    int resultado = 0;
+    for (long i = 0; i < num_aristas && resultado == 0; i++) {
+        if (i > 0 && aristas[i - 1].clave == aristas[i].clave)
+            continue;
+        resultado = meter_colapso(s, (int)(aristas[i].clave >> 32), (int)(aristas[i].clave & 0xffffffffu));
+    }
+    free(aristas);
+    return resultado;
+}
+
+static Triangulo* copiar_caras(const Simplificador* s) {
+    Triangulo* triangulos = (Triangulo*)malloc(sizeof(Triangulo) * (size_t)(s->caras_vivas > 0 ? s->caras_vivas : 1));
+    if (!triangulos)
+        return NULL;
+
+    int n = 0;
+    for (int f = 0; f < s->num_caras; f++) {
+        if (!s->cara_viva[f])
+            continue;
+        Punto* p = &triangulos[n++].p1;
+        for (int k = 0; k < 3; k++) {
+            int v = s->cara[f][k];
+            p[k] = (Punto){(float)s->pos[v][0], (float)s->pos[v][1], (float)s->pos[v][2], s->uv[v][0], s->uv[v][1], 1.0f};
+        }
+    }
+    return triangulos;
+}
+
+/**
+ * Genera los niveles de detalle de un objeto, cada uno con LOD_REDUCCION
+ * veces los triángulos del anterior. Necesita los triángulos sin comprimir
+ * y los vértices soldados (obj->indices), que calcula crear_triobj().
+ * @param obj Objeto.
+ * @param niveles Niveles a generar sin contar el completo (como mucho LOD_NIVELES_MAX).
+ * @return Niveles generados (pueden ser menos si la malla no da para más),
+ *         o -1 si no se puede simplificar o no hay memoria.
+ */
+int generar_lods(triobj* obj, int niveles) {
+    if (!obj->triptr || !obj->indices || obj->num_triangles <= 0 || niveles < 1)
+        return -1;
+    if (niveles > LOD_NIVELES_MAX)
+        niveles = LOD_NIVELES_MAX;
+    liberar_lods(obj);
+
+    NivelDetalle* lods = (NivelDetalle*)calloc((size_t)niveles, sizeof(NivelDetalle));
+    Simplificador s = {0};
+    if (!lods || preparar_simplificador(&s, obj) != 0) {
+        free(lods);
+        liberar_simplificador(&s);
+        return -1;
+    }
+
+    int generados = 0, fallo = 0;
+    int anteriores = s.caras_vivas;
+    while (generados < niveles && !fallo) {
+        int objetivo = (int)(anteriores * LOD_REDUCCION);
+        while (s.caras_vivas > objetivo && s.num_colapsos > 0) {
+            Colapso c = monticulo_sacar(&s);
+            if (!s.vivo[c.a] || !s.vivo[c.b] || s.version[c.a] != c.version_a || s.version[c.b] != c.version_b)
+                continue; // Uno de los dos ya ha cambiado: hay otro colapso más nuevo
+            if (invierte_caras(&s, c.a, c.b, c.destino) || invierte_caras(&s, c.b, c.a, c.destino))
+                continue;
+            if (colapsar(&s, &c) != 0) {
+                fallo = 1;
+                break;
+            }
+        }
+
+        // Si ya no se puede simplificar más, no tiene sentido otro nivel igual.
+        if (fallo || s.caras_vivas >= anteriores)
+            break;
+        lods[generados].triptr = copiar_caras(&s);
+        if (!lods[generados].triptr)
+            break;
+        lods[generados].num_triangles = s.caras_vivas;
+        lods[generados].error = (float)sqrt(s.error_max);
+        generados++;
+        anteriores = s.caras_vivas;
+    }
+    liberar_simplificador(&s);
+
+    if (generados == 0) {
+        free(lods);
+        return fallo ? -1 : 0;
+    }
+    obj->lods = lods;
+    obj->num_lods = generados;
+    obj->lod_actual = 0;
+    return generados;
+}
+
+/**
+ * Libera los niveles de detalle de un objeto, que vuelve a usar siempre el completo.
+ * @param obj Objeto.
+ */
+void liberar_lods(triobj* obj) {
+    for (int i = 0; i < obj->num_lods; i++)
+        free(obj->lods[i].triptr);
+    free(obj->lods);
+    obj->lods = NULL;
+    obj->num_lods = 0;
+    obj->lod_actual = 0;
+}
+
+// Tamaño proyectado por debajo del cual se usa el nivel k (k >= 1).
+static float umbral_lod(int nivel) {
+    return LOD_TAMANO_COMPLETO / (float)(1 << (nivel - 1));
+}
+
+/**
+ * Elige el nivel de detalle de un objeto para este frame por el radio
+ * proyectado de su caja (tras la matriz de modelo), con la posición de la
+ * cámara y los parámetros de ProjectionData. Hay histéresis respecto al
+ * nivel del frame anterior, que se guarda en obj->lod_actual.
+ * @param obj Objeto.
+ * @param camera Cámara del frame.
+ * @param scene_status_mask Máscara de estado (tipo de proyección).
+ * @return Nivel elegido: 0 es el objeto completo, k es obj->lods[k - 1].
+ */
+int seleccionar_lod(triobj* obj, const Camera* camera, unsigned int scene_status_mask) {
+    if (!obj->lods || obj->num_lods == 0) {
+        obj->lod_actual = 0;
+        return 0;
+    }
+
+    const double* m = obj->mptr->m;
+    double centro[3], semieje[3];
+    for (int k = 0; k < 3; k++) {
+        centro[k] = (obj->caja_min[k] + obj->caja_max[k]) / 2.0;
+        semieje[k] = (obj->caja_max[k] - obj->caja_min[k]) / 2.0;
+    }
+    double mundo[3], escala = 0.0;
+    for (int i = 0; i < 3; i++) {
+        mundo[i] = m[i * 4] * centro[0] + m[i * 4 + 1] * centro[1] + m[i * 4 + 2] * centro[2] + m[i * 4 + 3];
+        double columna = sqrt(m[i] * m[i] + m[4 + i] * m[4 + i] + m[8 + i] * m[8 + i]);
+        if (columna > escala)
+            escala = columna;
+    }
+    double radio = escala * sqrt(semieje[0] * semieje[0] + semieje[1] * semieje[1] + semieje[2] * semieje[2]);
+
+    // Radio proyectado en coordenadas normalizadas, como en la matriz de proyección.
+    double tamano;
+    if (scene_status_mask & PROJECTION_PERSPECTIVE) {
+        double dx = mundo[0] - camera->eye_position.x;
+        double dy = mundo[1] - camera->eye_position.y;
+        double dz = mundo[2] - camera->eye_position.z;
+        double distancia = sqrt(dx * dx + dy * dy + dz * dz);
+        if (distancia <= radio)
+            tamano = INFINITY; // La cámara está dentro
+        else
+            tamano = radio * 2.0 * ProjectionData.near_plane / (ProjectionData.top - ProjectionData.bottom) / distancia;
+    } else {
+        tamano = radio * 2.0 / (ProjectionData.top - ProjectionData.bottom);
+    }
+
+    int nivel = obj->lod_actual;
+    if (nivel < 0) nivel = 0;
+    if (nivel > obj->num_lods) nivel = obj->num_lods;
+    while (nivel < obj->num_lods && tamano < umbral_lod(nivel + 1) * (1.0f - LOD_HISTERESIS))
+        nivel++;
+    while (nivel > 0 && tamano > umbral_lod(nivel) * (1.0f + LOD_HISTERESIS))
+        nivel--;
+
+    obj->lod_actual = nivel;
+    return nivel;
+}
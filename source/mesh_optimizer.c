@@ -0,0 +1,309 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                        OPTIMIZACIÓN DE MALLAS                       *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo reordena los triángulos de una malla al cargarla. Llegan
+ * en el orden en que los escribió quien hizo el fichero, que para la
+ * memoria y para una caché de vértices transformados suele ser malo:
+ * triángulos consecutivos que no comparten vértices.
+ *
+ * El orden de triángulos es el de Tom Forsyth ("Linear-speed vertex cache
+ * optimisation"): cada vértice puntúa por su posición en una caché LRU
+ * simulada y por cuántos triángulos le quedan por emitir (así no se
+ * quedan vértices sueltos para el final), y se emite siempre el triángulo
+ * con más puntuación entre los que tocan la caché. Es lineal en el número
+ * de triángulos por CACHE_VERTICES.
+ *
+ * Después los vértices soldados (obj->indices) se renumeran por orden de
+ * primer uso, para que los que se leen juntos estén juntos. La malla no
+ * tiene buffer de vértices aparte (cada triángulo lleva sus puntos), así
+ * que esto ordena el índice que usan las normales, los niveles de detalle
+ * y la compresión, y el que tendrá un buffer indexado.
+ *
+ * El ACMR (fallos de caché por triángulo: 3 sin ninguna reutilización,
+ * 0.5 en una malla regular ideal) se calcula antes y después.
+ ***********************************************************************/
+
+typedef struct {
+    int* inicio;            // CSR de triángulos por vértice
+    int* triangulos;
+    int* activos;           // Triángulos sin emitir de cada vértice, al principio de su lista
+    int* posicion;          // Posición en la caché, -1 si no está
+    float* puntuacion;      // De cada vértice
+    float* puntuacion_triangulo;
+    unsigned char* emitido;
+    float puntuacion_cache[CACHE_VERTICES];
+    float puntuacion_valencia[CACHE_VERTICES + 1];
+} EstadoForsyth;
+
+/**
+ * Tablas de puntuación. Se rellenan en cada llamada (son unas pocas
+ * potencias) para no compartir estado entre los hilos de carga.
+ */
+static void preparar_tablas(EstadoForsyth* s) {
+    for (int p = 0; p < CACHE_VERTICES; p++) {
+        // Los tres del último triángulo puntúan lo mismo: da igual cuál
+        // de ellos use el siguiente.
+        if (p < 3)
+            s->puntuacion_cache[p] = FORSYTH_PESO_ULTIMO;
+        else
+            s->puntuacion_cache[p] = powf(1.0f - (float)(p - 3) / (CACHE_VERTICES - 3), FORSYTH_POTENCIA_CACHE);
+    }
+    s->puntuacion_valencia[0] = 0.0f;
+    for (int v = 1; v <= CACHE_VERTICES; v++)
+        s->puntuacion_valencia[v] = FORSYTH_PESO_VALENCIA * powf((float)v, -FORSYTH_POTENCIA_VALENCIA);
+}
+
+static float puntuacion_vertice(const EstadoForsyth* s, int posicion, int activos) {
+    // Sin triángulos pendientes no aporta nada a nadie.
+    if (activos == 0)
+        return -1.0f;
+    float p = posicion >= 0 ? s->puntuacion_cache[posicion] : 0.0f;
+    if (activos <= CACHE_VERTICES)
+        return p + s->puntuacion_valencia[activos];
+    return p + FORSYTH_PESO_VALENCIA * powf((float)activos, -FORSYTH_POTENCIA_VALENCIA);
+}
+
+/**
+ * ACMR de una lista de índices con una caché LRU de CACHE_VERTICES.
+ * @param indices 3 índices de vértice por triángulo.
+ * @param num_triangulos Número de triángulos.
+ * @param num_vertices Número de vértices distintos.
+ * @return Fallos de caché por triángulo, 0 si no hay triángulos.
+ */
+float acmr_indices(const int* indices, int num_triangulos, int num_vertices) {
+    int cache[CACHE_VERTICES];
+    int ocupadas = 0;
+    long fallos = 0;
+
+    if (num_triangulos <= 0 || num_vertices <= 0)
+        return 0.0f;
+
+    for (long e = 0; e < 3L * num_triangulos; e++) {
+        int v = indices[e];
+        int i = 0;
+        while (i < ocupadas && cache[i] != v)
+            i++;
+        if (i == ocupadas) {
+            fallos++;
+            if (ocupadas < CACHE_VERTICES)
+                ocupadas++;
+            i = ocupadas - 1;
+        }
+        // A la cabeza, desplazando los más recientes.
+        memmove(&cache[1], &cache[0], sizeof(int) * (size_t)i);
+        cache[0] = v;
+    }
+    return (float)fallos / num_triangulos;
+}
+
+/**
+ * Orden de Forsyth de los triángulos.
+ * @param indices 3 índices de vértice por triángulo.
+ * @param orden Salida: triángulos en el orden nuevo.
+ * @return 0 si todo fue bien, -1 si no hay memoria.
+ */
+static int orden_forsyth(const int* indices, int num_triangulos, int num_vertices, int* orden) {
+    EstadoForsyth s;
+    s.inicio = (int*)calloc((size_t)num_vertices + 1, sizeof(int));
+    s.triangulos = (int*)malloc(sizeof(int) * 3 * (size_t)num_triangulos);
+    s.activos = (int*)calloc((size_t)num_vertices, sizeof(int));
+    s.posicion = (int*)malloc(sizeof(int) * (size_t)num_vertices);
+    s.puntuacion = (float*)malloc(sizeof(float) * (size_t)num_vertices);
+    s.puntuacion_triangulo = (float*)malloc(sizeof(float) * (size_t)num_triangulos);
+    s.emitido = (unsigned char*)calloc((size_t)num_triangulos, 1);
+
+    int resultado = -1;
+    if (!s.inicio || !s.triangulos || !s.activos || !s.posicion || !s.puntuacion || !s.puntuacion_triangulo ||
+        !s.emitido)
+        goto fin;
+
+    preparar_tablas(&s);
+
+    for (long e = 0; e < 3L * num_triangulos; e++)
+        s.activos[indices[e]]++;
+    for (int v = 0; v < num_vertices; v++) {
+        s.inicio[v + 1] = s.inicio[v] + s.activos[v];
+        s.activos[v] = 0;
+        s.posicion[v] = -1;
+    }
+    for (long e = 0; e < 3L * num_triangulos; e++) {
+        int v = indices[e];
+        s.triangulos[s.inicio[v] + s.activos[v]++] = (int)(e / 3);
+    }
+    for (int v = 0; v < num_vertices; v++)
+        s.puntuacion[v] = puntuacion_vertice(&s, -1, s.activos[v]);
+
+    int mejor = -1;
+    float mejor_puntuacion = -1.0f;
+    for (int t = 0; t < num_triangulos; t++) {
+        const int* tri = &indices[3L * t];
+        s.puntuacion_triangulo[t] = s.puntuacion[tri[0]] + s.puntuacion[tri[1]] + s.puntuacion[tri[2]];
+        if (s.puntuacion_triangulo[t] > mejor_puntuacion) {
+            mejor_puntuacion = s.puntuacion_triangulo[t];
+            mejor = t;
+        }
+    }
+
+    int cache[CACHE_VERTICES];
+    int ocupadas = 0;
+    int siguiente_libre = 0;
+
+    for (int emitidos = 0; emitidos < num_triangulos; emitidos++) {
+        if (mejor < 0) {
+            // Nada en la caché tiene triángulos pendientes: el primero sin
+            // emitir, en el orden original.
+            while (s.emitido[siguiente_libre])
+                siguiente_libre++;
+            mejor = siguiente_libre;
+        }
+
+        int t = mejor;
+        const int* tri = &indices[3L * t];
+        orden[emitidos] = t;
+        s.emitido[t] = 1;
+
+        // Fuera de las listas de pendientes de sus vértices.
+        for (int k = 0; k < 3; k++) {
+            int v = tri[k];
+            int* lista = &s.triangulos[s.inicio[v]];
+            int n = s.activos[v];
+            for (int i = 0; i < n; i++) {
+                if (lista[i] == t) {
+                    lista[i] = lista[n - 1];
+                    lista[n - 1] = t;
+                    break;
+                }
+            }
+            s.activos[v]--;
+        }
+
+        // Caché nueva: el triángulo delante, luego lo que había. Tiene 3
+        // huecos de más para los vértices que se salen: también hay que
+        // bajarles la puntuación a sus triángulos.
+        int nueva[CACHE_VERTICES + 3];
+        int n_nueva = 0;
+        for (int k = 0; k < 3; k++)
+            nueva[n_nueva++] = tri[k];
+        for (int i = 0; i < ocupadas; i++) {
+            int v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                nueva[n_nueva++] = v;
+        }
+
+        mejor = -1;
+        mejor_puntuacion = -1.0f;
+        for (int i = 0; i < n_nueva; i++) {
+            int v = nueva[i];
+            s.posicion[v] = i < CACHE_VERTICES ? i : -1;
+            float puntuacion = puntuacion_vertice(&s, s.posicion[v], s.activos[v]);
+            float delta = puntuacion - s.puntuacion[v];
+            s.puntuacion[v] = puntuacion;
+
+            const int* lista = &s.triangulos[s.inicio[v]];
+            for (int j = 0; j < s.activos[v]; j++) {
+                int t2 = lista[j];
+                s.puntuacion_triangulo[t2] += delta;
+                if (i < CACHE_VERTICES && s.puntuacion_triangulo[t2] > mejor_puntuacion) {
+                    mejor_puntuacion = s.puntuacion_triangulo[t2];
+                    mejor = t2;
+                }
+            }
+        }
+
+        ocupadas = n_nueva < CACHE_VERTICES ? n_nueva : CACHE_VERTICES;
+        memcpy(cache, nueva, sizeof(int) * (size_t)ocupadas);
+    }
+    resultado = 0;
+
+fin:
+    free(s.inicio);
+    free(s.triangulos);
+    free(s.activos);
+    free(s.posicion);
+    free(s.puntuacion);
+    free(s.puntuacion_triangulo);
+    free(s.emitido);
+    return resultado;
+}
+
+/**
+ * Reordena los triángulos de un objeto para la caché de vértices y
+ * renumera sus vértices por orden de primer uso. Se reordenan a la vez
+ * triptr, las normales de vértice y obj->indices. Pensado para llamarse
+ * al cargar, tras crear_triobj() y antes de generar_lods() y de comprimir.
+ * @param obj Objeto con el índice de vértices soldados ya calculado.
+ * @param stats Salida opcional: ACMR antes y después.
+ * @return 0 si todo fue bien, -1 si no hay memoria, el objeto no tiene
+ *         índice de vértices o está comprimido (se queda como estaba).
+ */
+int optimizar_triobj(triobj* obj, EstadisticasOptimizacion* stats) {
+    if (!obj->triptr || !obj->indices || obj->num_triangles <= 0)
+        return -1;
+
+    int nt = obj->num_triangles, nv = obj->num_vertices;
+    float acmr_antes = acmr_indices(obj->indices, nt, nv);
+
+    int* orden = (int*)malloc(sizeof(int) * (size_t)nt);
+    int* renumerado = (int*)malloc(sizeof(int) * (size_t)nv);
+    Triangulo* triangulos = (Triangulo*)malloc(sizeof(Triangulo) * (size_t)nt);
+    int* indices = (int*)malloc(sizeof(int) * 3 * (size_t)nt);
+    Vector3* normales = obj->normales ? (Vector3*)malloc(sizeof(Vector3) * 3 * (size_t)nt) : NULL;
+
+    if (!orden || !renumerado || !triangulos || !indices || (obj->normales && !normales) ||
+        orden_forsyth(obj->indices, nt, nv, orden) != 0) {
+        free(orden);
+        free(renumerado);
+        free(triangulos);
+        free(indices);
+        free(normales);
+        return -1;
+    }
+
+    for (int v = 0; v < nv; v++)
+        renumerado[v] = -1;
+    int siguiente = 0;
+    for (int i = 0; i < nt; i++) {
+        int t = orden[i];
+        triangulos[i] = obj->triptr[t];
+        for (int k = 0; k < 3; k++) {
+            int v = obj->indices[3L * t + k];
+            if (renumerado[v] < 0)
+                renumerado[v] = siguiente++;
+            indices[3L * i + k] = renumerado[v];
+            if (normales)
+                normales[3L * i + k] = obj->normales[3L * t + k];
+        }
+    }
+
+    free(obj->triptr);
+    free(obj->indices);
+    free(obj->normales);
+    obj->triptr = triangulos;
+    obj->indices = indices;
+    obj->normales = normales;
+
+    // Lo que está en mundo seguía el orden viejo: se recalcula cuando se pida.
+    free(obj->normales_mundo);
+    obj->normales_mundo = NULL;
+    obj->normales_mptr = NULL;
+    descartar_triangulos_mundo(obj);
+    liberar_conos(obj);
+
+    if (stats) {
+        stats->triangulos = nt;
+        stats->vertices = nv;
+        stats->acmr_antes = acmr_antes;
+        stats->acmr_despues = acmr_indices(indices, nt, nv);
+    }
+
+    free(orden);
+    free(renumerado);
+    return 0;
+}
@@ -0,0 +1,655 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                    MALLAS POR TROZOS (FUERA DE MEMORIA)             *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo permite renderizar mallas más grandes que la memoria.
+ * cargar_triangulos() trae el array de Triangulo entero; aquí la malla
+ * se guarda una vez troceada (escribir_malla_trozos) y después se mapea
+ * con mmap sin leer nada.
+ *
+ * Cada frame, actualizar_trozos() mira qué trozos caen dentro del
+ * frustum de la cámara y pide los que falten, de más cercano a más
+ * lejano, mientras quepan en el presupuesto de memoria; si no caben se
+ * expulsan (madvise DONTNEED) los que lleven más tiempo sin verse. Un
+ * hilo de carga trae los pedidos (madvise WILLNEED y tocando cada
+ * página) y los marca como residentes. procesar_malla_trozos() dibuja
+ * sólo los visibles que ya están en memoria: un trozo recién pedido
+ * aparece un frame o dos después, pero el frame nunca se bloquea
+ * esperando al disco.
+ *
+ * Los estados de cada trozo sólo avanzan en un sentido por hilo: el
+ * principal pasa FUERA -> PEDIDO y RESIDENTE -> FUERA, el de carga
+ * PEDIDO -> RESIDENTE.
+ ***********************************************************************/
+
+typedef enum {
+    TROZO_FUERA = 0,
+    TROZO_PEDIDO,
+    TROZO_RESIDENTE
+} EstadoTrozo;
+
+typedef struct {
+    float distancia;
+    int trozo;
+} TrozoVisible;
+
+typedef struct {
+    CabeceraTrozo cabecera;
+    const Triangulo* triangulos;       // Dentro del mapeo
+    size_t bytes;                      // Redondeado a TROZOS_ALINEACION
+    _Atomic int estado;                // EstadoTrozo
+    long ultimo_frame_visible;
+    unsigned long long pedido_ns;
+} Trozo;
+
+struct MallaTrozos {
+    int fd;
+    unsigned char* mapa;
+    size_t tamano_fichero;
+
+    int num_trozos;
+    Trozo* trozos;
+    double m[16];                      // Matriz de modelo de toda la malla
+    long frame;
+    size_t presupuesto, bytes_ocupados;  // Ocupados: residentes y pedidos
+
+    // Cola de pedidos para el hilo de carga. Cada trozo está como mucho
+    // una vez (sólo se encola al pasar a PEDIDO), así que basta con
+    // num_trozos huecos.
+    pthread_t hilo;
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_pedidos;
+    int* cola;
+    int cola_inicio, cola_num;
+    int parar;
+
+    TrozoVisible* visibles;            // Trabajo de actualizar_trozos()
+
+    long cargas, expulsiones, sin_sitio;
+    double latencia_total_ms, latencia_max_ms;
+};
+
+static unsigned long long ahora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/***********************************************************************
+ * Escritura del fichero troceado
+ ***********************************************************************/
+
+typedef struct {
+    unsigned long long codigo;
+    int triangulo;
+} ClaveMorton;
+
+static int comparar_morton(const void* a, const void* b) {
+    unsigned long long x = ((const ClaveMorton*)a)->codigo, y = ((const ClaveMorton*)b)->codigo;
+    return (x > y) - (x < y);
+}
+
+// Intercala los 21 bits bajos de v con dos ceros entre cada bit.
+static unsigned long long separar_bits(unsigned long long v) {
+    v &= 0x1FFFFF;
+    v = (v | v << 32) & 0x1F00000000FFFFULL;
+    v = (v | v << 16) & 0x1F0000FF0000FFULL;
+    v = (v | v << 8) & 0x100F00F00F00F00FULL;
+    v = (v | v << 4) & 0x10C30C30C30C30C3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+/**
+ * Escribe un objeto como malla troceada. Los triángulos se ordenan por
+ * el código Morton de su centroide, así que cada trozo es un grupo
+ * compacto en el espacio y su caja es pequeña. La conversión necesita
+ * el objeto en memoria; se hace una vez, fuera de la aplicación.
+ * @param ruta Fichero de salida.
+ * @param obj Objeto con triptr (no comprimido).
+ * @param triangulos_por_trozo Triángulos por trozo (<= 0 para el valor por defecto).
+ * @return Número de trozos escritos, o -1 si hay un error.
+ */
+int escribir_malla_trozos(const char* ruta, const triobj* obj, int triangulos_por_trozo) {
+    if (!obj->triptr)
+        return -1;
+    if (triangulos_por_trozo <= 0)
+        triangulos_por_trozo = TROZOS_TRIANGULOS_POR_DEFECTO;
+
+    int n = obj->num_triangles;
+    int num_trozos = (n + triangulos_por_trozo - 1) / triangulos_por_trozo;
+
+    ClaveMorton* claves = (ClaveMorton*)malloc(sizeof(ClaveMorton) * (size_t)(n > 0 ? n : 1));
+    CabeceraTrozo* tabla = (CabeceraTrozo*)calloc((size_t)(num_trozos > 0 ? num_trozos : 1), sizeof(CabeceraTrozo));
+    Triangulo* bloque = (Triangulo*)malloc(sizeof(Triangulo) * (size_t)triangulos_por_trozo);
+    FILE* f = fopen(ruta, "wb");
+    if (!claves || !tabla || !bloque || !f) {
+        free(claves);
+        free(tabla);
+        free(bloque);
+        if (f)
+            fclose(f);
+        return -1;
+    }
+
+    // Caja de los centroides, para cuantizarlos a 21 bits por eje.
+    float min[3] = {INFINITY, INFINITY, INFINITY}, max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (int i = 0; i < n; i++) {
+        Vector3 c = compute_polygon_centroid(&obj->triptr[i]);
+        float v[3] = {c.x, c.y, c.z};
+        for (int k = 0; k < 3; k++) {
+            if (v[k] < min[k]) min[k] = v[k];
+            if (v[k] > max[k]) max[k] = v[k];
+        }
+    }
+    float escala[3];
+    for (int k = 0; k < 3; k++)
+        escala[k] = max[k] > min[k] ? 2097151.0f / (max[k] - min[k]) : 0.0f;
+
+    for (int i = 0; i < n; i++) {
+        Vector3 c = compute_polygon_centroid(&obj->triptr[i]);
+        claves[i].codigo = separar_bits((unsigned long long)((c.x - min[0]) * escala[0])) |
+                           separar_bits((unsigned long long)((c.y - min[1]) * escala[1])) << 1 |
+                           separar_bits((unsigned long long)((c.z - min[2]) * escala[2])) << 2;
+        claves[i].triangulo = i;
+    }
+    qsort(claves, (size_t)n, sizeof(ClaveMorton), comparar_morton);
+
+    // Cabecera y tabla; los datos empiezan en la primera posición alineada.
+    CabeceraFicheroTrozos cabecera = {TROZOS_MAGIA, TROZOS_VERSION, (unsigned int)num_trozos, 0};
+    long long desplazamiento = (long long)(sizeof(cabecera) + sizeof(CabeceraTrozo) * (size_t)num_trozos);
+    desplazamiento = (desplazamiento + TROZOS_ALINEACION - 1) / TROZOS_ALINEACION * TROZOS_ALINEACION;
+
+    int error = 0;
+    for (int t = 0; t < num_trozos && !error; t++) {
+        int primero = t * triangulos_por_trozo;
+        int cuantos = n - primero < triangulos_por_trozo ? n - primero : triangulos_por_trozo;
+        CabeceraTrozo* trozo = &tabla[t];
+
+        trozo->desplazamiento = desplazamiento;
+        trozo->num_triangulos = cuantos;
+        for (int k = 0; k < 3; k++) {
+            trozo->min[k] = INFINITY;
+            trozo->max[k] = -INFINITY;
+        }
+        for (int i = 0; i < cuantos; i++) {
+            bloque[i] = obj->triptr[claves[primero + i].triangulo];
+            for (int v = 0; v < 3; v++) {
+                const Punto* p = &(&bloque[i].p1)[v];
+                float c[3] = {p->x, p->y, p->z};
+                for (int k = 0; k < 3; k++) {
+                    if (c[k] < trozo->min[k]) trozo->min[k] = c[k];
+                    if (c[k] > trozo->max[k]) trozo->max[k] = c[k];
+                }
+            }
+        }
+
+        size_t bytes = sizeof(Triangulo) * (size_t)cuantos;
+        if (fseek(f, (long)desplazamiento, SEEK_SET) != 0 || fwrite(bloque, 1, bytes, f) != bytes)
+            error = 1;
+        desplazamiento += (long long)((bytes + TROZOS_ALINEACION - 1) / TROZOS_ALINEACION * TROZOS_ALINEACION);
+    }
+
+    // Relleno final, para que el último trozo también ocupe páginas enteras.
+    if (!error && num_trozos > 0 && (fseek(f, (long)desplazamiento - 1, SEEK_SET) != 0 || fputc(0, f) == EOF))
+        error = 1;
+    if (!error && (fseek(f, 0, SEEK_SET) != 0 || fwrite(&cabecera, sizeof(cabecera), 1, f) != 1 ||
+                   fwrite(tabla, sizeof(CabeceraTrozo), (size_t)num_trozos, f) != (size_t)num_trozos))
+        error = 1;
+    if (fclose(f) != 0)
+        error = 1;
+
+    free(claves);
+    free(tabla);
+    free(bloque);
+    return error ? -1 : num_trozos;
+}
+
+/***********************************************************************
+ * Hilo de carga
+ ***********************************************************************/
+
+static void* bucle_carga(void* arg) {
+    MallaTrozos* malla = (MallaTrozos*)arg;
+    long pagina = sysconf(_SC_PAGESIZE);
+
+    pthread_mutex_lock(&malla->mutex);
+    for (;;) {
+        while (malla->cola_num == 0 && !malla->parar)
+            pthread_cond_wait(&malla->hay_pedidos, &malla->mutex);
+        if (malla->parar)
+            break;
+
+        int indice = malla->cola[malla->cola_inicio];
+        malla->cola_inicio = (malla->cola_inicio + 1) % malla->num_trozos;
+        malla->cola_num--;
+        pthread_mutex_unlock(&malla->mutex);
+
+        // Se pide todo el trozo de golpe y luego se toca cada página para
+        // que, cuando lo vea el hilo principal, no haya fallos de página.
+        Trozo* trozo = &malla->trozos[indice];
+        const volatile unsigned char* datos = (const volatile unsigned char*)trozo->triangulos;
+        madvise((void*)trozo->triangulos, trozo->bytes, MADV_WILLNEED);
+        unsigned char suma = 0;
+        for (size_t b = 0; b < trozo->bytes; b += (size_t)pagina)
+            suma += datos[b];
+        (void)suma;
+
+        double latencia_ms = (ahora_ns() - trozo->pedido_ns) / 1e6;
+        atomic_store_explicit(&trozo->estado, TROZO_RESIDENTE, memory_order_release);
+
+        pthread_mutex_lock(&malla->mutex);
+        malla->cargas++;
+        malla->latencia_total_ms += latencia_ms;
+        if (latencia_ms > malla->latencia_max_ms)
+            malla->latencia_max_ms = latencia_ms;
+    }
+    pthread_mutex_unlock(&malla->mutex);
+    return NULL;
+}
+
+/***********************************************************************
+ * Apertura y cierre
+ ***********************************************************************/
+
+/**
+ * Abre una malla troceada: mapea el fichero y arranca el hilo de carga.
+ * No se lee ningún triángulo hasta que actualizar_trozos() lo pida.
+ * @param ruta Fichero escrito con escribir_malla_trozos().
+ * @param presupuesto Bytes máximos de trozos en memoria a la vez.
+ * @return Malla abierta, o NULL si el fichero no es válido o no hay memoria.
+ */
+MallaTrozos* abrir_malla_trozos(const char* ruta, size_t presupuesto) {
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat info;
+    CabeceraFicheroTrozos cabecera;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(cabecera) ||
+        pread(fd, &cabecera, sizeof(cabecera), 0) != (ssize_t)sizeof(cabecera) || cabecera.magia != TROZOS_MAGIA ||
+        cabecera.version != TROZOS_VERSION ||
+        sizeof(cabecera) + sizeof(CabeceraTrozo) * (size_t)cabecera.num_trozos > (size_t)info.st_size) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t n = cabecera.num_trozos > 0 ? cabecera.num_trozos : 1;
+    MallaTrozos* malla = (MallaTrozos*)calloc(1, sizeof(MallaTrozos));
+    CabeceraTrozo* tabla = (CabeceraTrozo*)malloc(sizeof(CabeceraTrozo) * n);
+    void* mapa = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (malla) {
+        malla->trozos = (Trozo*)calloc(n, sizeof(Trozo));
+        malla->cola = (int*)malloc(sizeof(int) * n);
+        malla->visibles = (TrozoVisible*)malloc(sizeof(TrozoVisible) * n);
+    }
+
+    int valido = malla && tabla && mapa != MAP_FAILED && malla->trozos && malla->cola && malla->visibles &&
+                 pread(fd, tabla, sizeof(CabeceraTrozo) * cabecera.num_trozos, sizeof(cabecera)) ==
+                     (ssize_t)(sizeof(CabeceraTrozo) * cabecera.num_trozos);
+
+    for (unsigned int t = 0; valido && t < cabecera.num_trozos; t++) {
+        Trozo* trozo = &malla->trozos[t];
+        trozo->cabecera = tabla[t];
+        trozo->bytes = sizeof(Triangulo) * (size_t)tabla[t].num_triangulos;
+        trozo->bytes = (trozo->bytes + TROZOS_ALINEACION - 1) / TROZOS_ALINEACION * TROZOS_ALINEACION;
+        trozo->ultimo_frame_visible = -1;
+        if (tabla[t].num_triangulos < 0 || tabla[t].desplazamiento % TROZOS_ALINEACION != 0 ||
+            (size_t)tabla[t].desplazamiento + trozo->bytes > (size_t)info.st_size)
+            valido = 0;
+        else
+            trozo->triangulos = (const Triangulo*)((unsigned char*)mapa + tabla[t].desplazamiento);
+    }
+    free(tabla);
+
+    if (valido) {
+        malla->fd = fd;
+        malla->mapa = (unsigned char*)mapa;
+        malla->tamano_fichero = (size_t)info.st_size;
+        malla->num_trozos = (int)cabecera.num_trozos;
+        malla->presupuesto = presupuesto;
+        malla->m[0] = malla->m[5] = malla->m[10] = malla->m[15] = 1.0;
+        pthread_mutex_init(&malla->mutex, NULL);
+        pthread_cond_init(&malla->hay_pedidos, NULL);
+        if (pthread_create(&malla->hilo, NULL, bucle_carga, malla) != 0) {
+            pthread_mutex_destroy(&malla->mutex);
+            pthread_cond_destroy(&malla->hay_pedidos);
+            valido = 0;
+        }
+    }
+
+    if (!valido) {
+        if (mapa != MAP_FAILED)
+            munmap(mapa, (size_t)info.st_size);
+        if (malla) {
+            free(malla->trozos);
+            free(malla->cola);
+            free(malla->visibles);
+            free(malla);
+        }
+        close(fd);
+        return NULL;
+    }
+    return malla;
+}
+
+/**
+ * Para el hilo de carga, desmapea el fichero y libera la malla.
+ * @param malla Malla a cerrar.
+ */
+void cerrar_malla_trozos(MallaTrozos* malla) {
+    if (!malla)
+        return;
+
+    pthread_mutex_lock(&malla->mutex);
+    malla->parar = 1;
+    pthread_cond_signal(&malla->hay_pedidos);
+    pthread_mutex_unlock(&malla->mutex);
+    pthread_join(malla->hilo, NULL);
+    pthread_mutex_destroy(&malla->mutex);
+    pthread_cond_destroy(&malla->hay_pedidos);
+
+    munmap(malla->mapa, malla->tamano_fichero);
+    close(malla->fd);
+    free(malla->trozos);
+    free(malla->cola);
+    free(malla->visibles);
+    free(malla);
+}
+
+/**
+ * Cambia el presupuesto de memoria. Si baja, los trozos sobrantes se
+ * expulsan en el siguiente actualizar_trozos().
+ */
+void malla_trozos_presupuesto(MallaTrozos* malla, size_t presupuesto) {
+    malla->presupuesto = presupuesto;
+}
+
+/**
+ * Matriz de modelo de la malla (4x4 por filas), para colocarla en la escena.
+ */
+double* malla_trozos_matriz(MallaTrozos* malla) {
+    return malla->m;
+}
+
+/***********************************************************************
+ * Residencia
+ ***********************************************************************/
+
+/**
+ * Caja contra el frustum, en coordenadas de recorte (antes de dividir por
+ * w, igual que camera_pipeline): el trozo se descarta si sus 8 esquinas
+ * quedan fuera del mismo plano.
+ * @param distancia Salida: w mínima de las esquinas, para ordenar por cercanía.
+ * @return 1 si puede verse algo del trozo.
+ */
+static int caja_visible(const double t[4][4], const CabeceraTrozo* trozo, float* distancia) {
+    int fuera_todas = 0x1F;
+    double w_min = INFINITY;
+
+    for (int e = 0; e < 8; e++) {
+        double x = (e & 1) ? trozo->max[0] : trozo->min[0];
+        double y = (e & 2) ? trozo->max[1] : trozo->min[1];
+        double z = (e & 4) ? trozo->max[2] : trozo->min[2];
+        double cx = t[0][0] * x + t[0][1] * y + t[0][2] * z + t[0][3];
+        double cy = t[1][0] * x + t[1][1] * y + t[1][2] * z + t[1][3];
+        double cw = t[3][0] * x + t[3][1] * y + t[3][2] * z + t[3][3];
+
+        int fuera = 0;
+        if (cx > cw) fuera |= 1;
+        if (cx < -cw) fuera |= 2;
+        if (cy > cw) fuera |= 4;
+        if (cy < -cw) fuera |= 8;
+        if (cw < ProjectionData.near_plane) fuera |= 16;
+        fuera_todas &= fuera;
+
+        if (cw < w_min)
+            w_min = cw;
+    }
+
+    *distancia = w_min > 0.0 ? (float)w_min : 0.0f;
+    return fuera_todas == 0;
+}
+
+/**
+ * Expulsa el trozo residente que lleve más frames sin verse (nunca uno
+ * visible en el frame actual).
+ * @return 1 si se ha liberado algo.
+ */
+static int expulsar_trozo(MallaTrozos* malla) {
+    int elegido = -1;
+    for (int t = 0; t < malla->num_trozos; t++) {
+        Trozo* trozo = &malla->trozos[t];
+        if (trozo->ultimo_frame_visible == malla->frame ||
+            atomic_load_explicit(&trozo->estado, memory_order_acquire) != TROZO_RESIDENTE)
+            continue;
+        if (elegido < 0 || trozo->ultimo_frame_visible < malla->trozos[elegido].ultimo_frame_visible)
+            elegido = t;
+    }
+    if (elegido < 0)
+        return 0;
+
+    Trozo* trozo = &malla->trozos[elegido];
+    madvise((void*)trozo->triangulos, trozo->bytes, MADV_DONTNEED);
+    atomic_store_explicit(&trozo->estado, TROZO_FUERA, memory_order_relaxed);
+    malla->bytes_ocupados -= trozo->bytes;
+    malla->expulsiones++;
+    return 1;
+}
+
+static int comparar_distancia(const void* a, const void* b) {
+    float x = ((const TrozoVisible*)a)->distancia, y = ((const TrozoVisible*)b)->distancia;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Decide qué trozos deben estar en memoria para la cámara actual. Se
+ * llama una vez por frame, antes de procesar_malla_trozos(); nunca espera
+ * al disco.
+ * @param malla Malla troceada.
+ * @param camera Cámara del frame.
+ * @param scene_status_mask Máscara de estado (tipo de proyección).
+ * @return Número de trozos visibles.
+ */
+int actualizar_trozos(MallaTrozos* malla, const Camera* camera, unsigned int scene_status_mask) {
+    malla->frame++;
+
+    // Modelo, vista y proyección en una sola matriz, como las aplica camera_pipeline().
+    double proyeccion[4][4], modelo[4][4], vista_modelo[4][4], total[4][4];
+    if (scene_status_mask & PROJECTION_PERSPECTIVE)
+        set_perspective_projection_matrix(proyeccion, ProjectionData.near_plane, ProjectionData.far_plane,
+                                          ProjectionData.right, ProjectionData.left, ProjectionData.top,
+                                          ProjectionData.bottom);
+    else
+        set_orthographic_projection_matrix(proyeccion, ProjectionData.near_plane, ProjectionData.far_plane,
+                                           ProjectionData.right, ProjectionData.left, ProjectionData.top,
+                                           ProjectionData.bottom);
+    memcpy(modelo, malla->m, sizeof(modelo));
+    matrix_multiplication(camera->view->matrix, modelo, vista_modelo);
+    matrix_multiplication(proyeccion, vista_modelo, total);
+
+    int num_visibles = 0;
+    for (int t = 0; t < malla->num_trozos; t++) {
+        TrozoVisible* visible = &malla->visibles[num_visibles];
+        if (caja_visible((const double(*)[4])total, &malla->trozos[t].cabecera, &visible->distancia)) {
+            malla->trozos[t].ultimo_frame_visible = malla->frame;
+            visible->trozo = t;
+            num_visibles++;
+        }
+    }
+
+    // Los más cercanos primero: si no cabe todo, que falte lo del fondo.
+    qsort(malla->visibles, (size_t)num_visibles, sizeof(TrozoVisible), comparar_distancia);
+
+    int pedidos = 0;
+    for (int v = 0; v < num_visibles; v++) {
+        Trozo* trozo = &malla->trozos[malla->visibles[v].trozo];
+        if (atomic_load_explicit(&trozo->estado, memory_order_acquire) != TROZO_FUERA)
+            continue;
+
+        while (malla->bytes_ocupados + trozo->bytes > malla->presupuesto && expulsar_trozo(malla))
+            ;
+        if (malla->bytes_ocupados + trozo->bytes > malla->presupuesto) {
+            malla->sin_sitio++;
+            continue;
+        }
+
+        malla->bytes_ocupados += trozo->bytes;
+        trozo->pedido_ns = ahora_ns();
+        atomic_store_explicit(&trozo->estado, TROZO_PEDIDO, memory_order_relaxed);
+
+        pthread_mutex_lock(&malla->mutex);
+        malla->cola[(malla->cola_inicio + malla->cola_num) % malla->num_trozos] = malla->visibles[v].trozo;
+        malla->cola_num++;
+        pthread_mutex_unlock(&malla->mutex);
+        pedidos++;
+    }
+    if (pedidos)
+        pthread_cond_signal(&malla->hay_pedidos);
+
+    // Si el presupuesto ha bajado, se devuelve lo que sobre.
+    while (malla->bytes_ocupados > malla->presupuesto && expulsar_trozo(malla))
+        ;
+
+    return num_visibles;
+}
+
+/**
+ * Procesa un frame de la malla: los trozos visibles que ya están en
+ * memoria pasan por camera_pipeline() y el back culling, igual que en
+ * procesar_escena().
+ * @param malla Malla troceada, con actualizar_trozos() ya llamado este frame.
+ * @param camera Cámara desde la que se renderiza.
+ * @param scene_status_mask Máscara de estado (proyección, BACK_CULLING...).
+ * @return Número de triángulos que sobreviven al culling.
+ */
+long procesar_malla_trozos(MallaTrozos* malla, Camera* camera, unsigned int scene_status_mask) {
+    Triangulo procesado;
+    Vector3 normal;
+    long dibujados = 0;
+
+    for (int t = 0; t < malla->num_trozos; t++) {
+        Trozo* trozo = &malla->trozos[t];
+        if (trozo->ultimo_frame_visible != malla->frame ||
+            atomic_load_explicit(&trozo->estado, memory_order_acquire) != TROZO_RESIDENTE)
+            continue;
+
+        for (int i = 0; i < trozo->cabecera.num_triangulos; i++) {
+            camera_pipeline(camera, scene_status_mask, &procesado, (Triangulo*)&trozo->triangulos[i], malla->m);
+
+            if (scene_status_mask & BACK_CULLING) {
+                obtain_normal_vector(&procesado, &normal);
+                if (!should_draw_polygon(normal, camera->vector_forward))
+                    continue;
+            }
+            dibujados++;
+        }
+    }
+
+    return dibujados;
+}
+
+/**
+ * Estado actual de la residencia y latencias de carga acumuladas.
+ * @param malla Malla troceada.
+ * @param stats Salida.
+ */
+void malla_trozos_estadisticas(const MallaTrozos* malla, EstadisticasTrozos* stats) {
+    memset(stats, 0, sizeof(EstadisticasTrozos));
+    stats->trozos = malla->num_trozos;
+    stats->presupuesto = malla->presupuesto;
+    stats->expulsiones = malla->expulsiones;
+    stats->sin_sitio = malla->sin_sitio;
+
+    for (int t = 0; t < malla->num_trozos; t++) {
+        const Trozo* trozo = &malla->trozos[t];
+        int estado = atomic_load_explicit(&trozo->estado, memory_order_acquire);
+        if (trozo->ultimo_frame_visible == malla->frame) {
+            stats->visibles++;
+            if (estado != TROZO_RESIDENTE)
+                stats->visibles_sin_cargar++;
+        }
+        if (estado == TROZO_RESIDENTE) {
+            stats->residentes++;
+            stats->bytes_residentes += trozo->bytes;
+        } else if (estado == TROZO_PEDIDO) {
+            stats->pendientes++;
+        }
+    }
+
+    pthread_mutex_lock((pthread_mutex_t*)&malla->mutex);
+    stats->cargas = malla->cargas;
+    stats->latencia_media_ms = malla->cargas ? malla->latencia_total_ms / malla->cargas : 0.0;
+    stats->latencia_max_ms = malla->latencia_max_ms;
+    pthread_mutex_unlock((pthread_mutex_t*)&malla->mutex);
+}
+
+/**
+ * Carga entera una malla troceada, con la firma de cargar_triangulos(),
+ * para poder usar el formato como fichero de escena normal.
+ * @param ruta Fichero escrito con escribir_malla_trozos().
+ * @param num_triangulos Salida: número de triángulos.
+ * @param triangulos Salida: array reservado con todos los triángulos.
+ * @return 1 si todo fue bien, -1 si el fichero no es válido o no hay memoria.
+ */
+int cargar_triangulos_trozos(char* ruta, int* num_triangulos, Triangulo** triangulos) {
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    CabeceraFicheroTrozos cabecera;
+    CabeceraTrozo* tabla = NULL;
+    Triangulo* resultado = NULL;
+    long total = 0;
+    int valido = pread(fd, &cabecera, sizeof(cabecera), 0) == (ssize_t)sizeof(cabecera) &&
+                 cabecera.magia == TROZOS_MAGIA && cabecera.version == TROZOS_VERSION;
+
+    if (valido) {
+        size_t bytes_tabla = sizeof(CabeceraTrozo) * cabecera.num_trozos;
+        tabla = (CabeceraTrozo*)malloc(bytes_tabla > 0 ? bytes_tabla : 1);
+        valido = tabla && pread(fd, tabla, bytes_tabla, sizeof(cabecera)) == (ssize_t)bytes_tabla;
+    }
+    for (unsigned int t = 0; valido && t < cabecera.num_trozos; t++) {
+        if (tabla[t].num_triangulos < 0)
+            valido = 0;
+        total += tabla[t].num_triangulos;
+    }
+    if (valido && total <= 0x7FFFFFFF) {
+        resultado = (Triangulo*)malloc(sizeof(Triangulo) * (size_t)(total > 0 ? total : 1));
+        valido = resultado != NULL;
+    } else {
+        valido = 0;
+    }
+
+    long n = 0;
+    for (unsigned int t = 0; valido && t < cabecera.num_trozos; t++) {
+        size_t bytes = sizeof(Triangulo) * (size_t)tabla[t].num_triangulos;
+        if (pread(fd, &resultado[n], bytes, tabla[t].desplazamiento) != (ssize_t)bytes)
+            valido = 0;
+        n += tabla[t].num_triangulos;
+    }
+
+    free(tabla);
+    close(fd);
+    if (!valido) {
+        free(resultado);
+        return -1;
+    }
+
+    *num_triangulos = (int)total;
+    *triangulos = resultado;
+    return 1;
+}
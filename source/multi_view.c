@@ -0,0 +1,234 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                            VARIAS VISTAS                            *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo rasteriza la escena desde varias cámaras en el mismo frame
+ * (pantalla partida con la cámara principal y la de objeto, un juego de
+ * cámaras fijas...). Llamar a rasterizar_escena() una vez por cámara
+ * repetiría para cada una todo lo que no depende de ella.
+ *
+ * Lo compartido se hace una vez por objeto y frame:
+ *   - los triángulos en espacio mundo y la normal de cada cara (con la
+ *     misma caché que VERTICES_MUNDO, así que si el objeto no se ha movido
+ *     ni siquiera eso: ver world_vertices.c),
+ *   - la caja del objeto en mundo, para el frustum de cada vista.
+ * Por vista quedan el frustum, el back culling, la vista y proyección
+ * (camera_pipeline_mundo) y el rasterizado en su framebuffer.
+ *
+ * El back culling se hace en mundo, antes de transformar, con la normal
+ * de cada cara y el centro de proyección de la vista (en ortográfica, la
+ * dirección de la cámara): da el mismo sentido de giro en pantalla que
+ * tendría el triángulo proyectado, así que los de espaldas, la mitad en
+ * un objeto cerrado, no pasan por la vista y la proyección en ninguna
+ * cámara. El centro de proyección se saca de la propia matriz de vista,
+ * que es lo que usa la pipeline, con el signo de su determinante porque
+ * la matriz de set_view_matrix() invierte la orientación. Con la cámara
+ * por defecto descarta lo mismo que should_draw_polygon(); con cámaras
+ * que miran hacia z positiva should_draw_polygon() se queda con las
+ * caras de atrás, y aquí no.
+ *
+ * Los objetos comprimidos (sin copia en mundo) van por procesar_objeto()
+ * en cada vista. rasterizar_vistas() rehace la copia en mundo si hace
+ * falta, así que no se puede llamar desde varios hilos sobre la misma
+ * escena; rasterizar_vistas_preparadas() sólo la lee, para cuando ya se
+ * ha hecho antes de lanzarlos (renderizar_lote).
+ *
+ * Los niveles de detalle no se usan: el nivel se elige con histéresis
+ * por objeto y cada vista pediría uno distinto, ni los conos de normales
+ * (CONOS_NORMALES), que guardan en el objeto lo del frame anterior.
+ * Tampoco se usa la pirámide de oclusión, que es por framebuffer.
+ ***********************************************************************/
+
+typedef struct {
+    double pv[4][4];    // Proyección por vista, para la caja
+    Vector3 centro;     // Centro de proyección en mundo (perspectiva)
+    Vector3 hacia_camara; // Dirección a la cámara en mundo, escalada (ortográfica)
+    float signo;        // Signo del determinante de la vista
+} DatosVista;
+
+static Vector3 fila(const double m[4][4], int i) {
+    return vector3((float)m[i][0], (float)m[i][1], (float)m[i][2]);
+}
+
+/**
+ * Lo que hace falta de cada vista para el culling en mundo. Con A la
+ * parte 3x3 de la vista y t su traslación, el centro de proyección es el
+ * punto que va al origen, -A^-1 t, y la normal en vista de una cara es
+ * cof(A) n: su z es (a0 x a1) . n.
+ */
+static void preparar_vista(const Camera* camera, unsigned int scene_status_mask, DatosVista* d) {
+    const double (*v)[4] = (const double (*)[4])camera->view->matrix;
+    Vector3 a0 = fila(v, 0), a1 = fila(v, 1), a2 = fila(v, 2);
+    Vector3 c0 = vector3_cross_product(a1, a2);
+    Vector3 c1 = vector3_cross_product(a2, a0);
+    Vector3 c2 = vector3_cross_product(a0, a1);
+    float det = vector3_dot_product(a0, c0);
+    float inv = det != 0.0f ? 1.0f / det : 0.0f;
+    float t0 = (float)v[0][3], t1 = (float)v[1][3], t2 = (float)v[2][3];
+
+    d->centro = vector3(-(c0.x * t0 + c1.x * t1 + c2.x * t2) * inv, -(c0.y * t0 + c1.y * t1 + c2.y * t2) * inv,
+                        -(c0.z * t0 + c1.z * t1 + c2.z * t2) * inv);
+    d->signo = det < 0.0f ? -1.0f : 1.0f;
+    // c2 es det A^-1 (0, 0, 1): con el signo, la dirección hacia la cámara,
+    // que es hacia donde tiende centro - p cuando la cámara se aleja.
+    d->hacia_camara = vector3(d->signo * c2.x, d->signo * c2.y, d->signo * c2.z);
+    matriz_proyeccion_vista(camera, scene_status_mask, d->pv);
+}
+
+/**
+ * Caja en mundo del objeto: las 8 esquinas de su caja local por la
+ * matriz de modelo.
+ */
+static void caja_mundo(const triobj* obj, float min[3], float max[3]) {
+    const double* m = obj->mptr->m;
+    for (int k = 0; k < 3; k++) {
+        min[k] = INFINITY;
+        max[k] = -INFINITY;
+    }
+    for (int e = 0; e < 8; e++) {
+        double p[3] = {(e & 1) ? obj->caja_max[0] : obj->caja_min[0], (e & 2) ? obj->caja_max[1] : obj->caja_min[1],
+                       (e & 4) ? obj->caja_max[2] : obj->caja_min[2]};
+        for (int k = 0; k < 3; k++) {
+            float c = (float)(m[k * 4 + 0] * p[0] + m[k * 4 + 1] * p[1] + m[k * 4 + 2] * p[2] + m[k * 4 + 3]);
+            if (c < min[k]) min[k] = c;
+            if (c > max[k]) max[k] = c;
+        }
+    }
+}
+
+/**
+ * 1 si la caja en mundo queda entera fuera de un mismo plano del frustum,
+ * con las cuentas de rasterizar_escena(). En ortográfica no se descarta.
+ */
+static int caja_fuera(const DatosVista* d, unsigned int scene_status_mask, const float min[3], const float max[3]) {
+    if (!(scene_status_mask & PROJECTION_PERSPECTIVE))
+        return 0;
+
+    int fuera_todas = 0x1F;
+    for (int e = 0; e < 8 && fuera_todas; e++) {
+        double x = (e & 1) ? max[0] : min[0];
+        double y = (e & 2) ? max[1] : min[1];
+        double z = (e & 4) ? max[2] : min[2];
+        double cx = d->pv[0][0] * x + d->pv[0][1] * y + d->pv[0][2] * z + d->pv[0][3];
+        double cy = d->pv[1][0] * x + d->pv[1][1] * y + d->pv[1][2] * z + d->pv[1][3];
+        double cw = d->pv[3][0] * x + d->pv[3][1] * y + d->pv[3][2] * z + d->pv[3][3];
+        int fuera = 0;
+        if (cx > cw) fuera |= 1;
+        if (cx < -cw) fuera |= 2;
+        if (cy > cw) fuera |= 4;
+        if (cy < -cw) fuera |= 8;
+        if (cw < ProjectionData.near_plane) fuera |= 16;
+        fuera_todas &= fuera;
+    }
+    return fuera_todas != 0;
+}
+
+/**
+ * Cuerpo de rasterizar_vistas(). Con preparada, la copia en mundo de cada
+ * objeto no se rehace: se usa la que haya y, si no hay, el objeto va por
+ * procesar_objeto() sin VERTICES_MUNDO, que también la rehace.
+ */
+static long rasterizar(Vista* vistas, int num_vistas, unsigned int scene_status_mask, triobj* lista, const Textura* tex,
+                       int preparada) {
+    if (num_vistas < 0 || num_vistas > VISTAS_MAX)
+        return -1;
+
+    DatosVista datos[VISTAS_MAX];
+    for (int v = 0; v < num_vistas; v++) {
+        preparar_vista(vistas[v].camera, scene_status_mask, &datos[v]);
+        vistas[v].triangulos = 0;
+        vistas[v].objetos = 0;
+    }
+
+    int perspectiva = (scene_status_mask & PROJECTION_PERSPECTIVE) != 0;
+    int culling = (scene_status_mask & BACK_CULLING) != 0;
+    unsigned int mascara_objeto =
+        scene_status_mask & ~(NIVEL_DETALLE | CONOS_NORMALES | (preparada ? VERTICES_MUNDO : 0));
+    long total = 0;
+    Triangulo procesado;
+
+    for (triobj* obj = lista; obj; obj = obj->hptr) {
+        float min[3], max[3];
+        caja_mundo(obj, min, max);
+
+        int dentro[VISTAS_MAX], alguna = 0;
+        for (int v = 0; v < num_vistas; v++) {
+            dentro[v] = !caja_fuera(&datos[v], scene_status_mask, min, max);
+            vistas[v].objetos += dentro[v];
+            alguna |= dentro[v];
+        }
+        if (!alguna)
+            continue;
+
+        const Triangulo* mundo = preparada ? obj->triangulos_mundo : triangulos_mundo(obj);
+        if (!mundo) {
+            for (int v = 0; v < num_vistas; v++) {
+                if (!dentro[v])
+                    continue;
+                long n = procesar_objeto(vistas[v].camera, mascara_objeto, obj, vistas[v].fb, tex);
+                vistas[v].triangulos += n;
+                total += n;
+            }
+            continue;
+        }
+
+        const Vector3* caras = obj->caras_mundo;
+        for (int v = 0; v < num_vistas; v++) {
+            if (!dentro[v])
+                continue;
+            const DatosVista* d = &datos[v];
+            long n = 0;
+
+            for (int i = 0; i < obj->num_triangles; i++) {
+                if (culling) {
+                    const Punto* p = &mundo[i].p1;
+                    Vector3 hacia = perspectiva ? vector3(d->centro.x - p->x, d->centro.y - p->y, d->centro.z - p->z)
+                                                : d->hacia_camara;
+                    // Signo elegido para coincidir con should_draw_polygon() en la cámara por defecto.
+                    if (d->signo * vector3_dot_product(caras[i], hacia) >= 0.0f)
+                        continue;
+                }
+                camera_pipeline_mundo(vistas[v].camera, scene_status_mask, &procesado, &mundo[i]);
+                rasterizar_triangulo(vistas[v].fb, &procesado, tex, scene_status_mask);
+                n++;
+            }
+            vistas[v].triangulos += n;
+            total += n;
+        }
+    }
+    return total;
+}
+
+/**
+ * Rasteriza la escena desde varias cámaras, cada una en su framebuffer,
+ * calculando una sola vez lo que no depende de la cámara. Los
+ * framebuffers no se limpian aquí.
+ * @param vistas Cámara y framebuffer de cada vista; a la salida, los
+ *        triángulos rasterizados y los objetos dentro del frustum de cada una.
+ * @param num_vistas Número de vistas (hasta VISTAS_MAX).
+ * @param scene_status_mask Máscara de estado (proyección, BACK_CULLING...).
+ * @param lista Primer objeto de la escena.
+ * @param tex Textura (NULL para blanco).
+ * @return Triángulos rasterizados en total, o -1 si hay demasiadas vistas.
+ */
+long rasterizar_vistas(Vista* vistas, int num_vistas, unsigned int scene_status_mask, triobj* lista, const Textura* tex) {
+    return rasterizar(vistas, num_vistas, scene_status_mask, lista, tex, 0);
+}
+
+/**
+ * Como rasterizar_vistas(), pero sin tocar la copia en mundo de los
+ * objetos, que tiene que estar hecha (triangulos_mundo) con las matrices
+ * actuales: los objetos sin ella van por procesar_objeto(). Sólo lee la
+ * escena, así que varios hilos pueden llamarla a la vez.
+ * @return Triángulos rasterizados en total, o -1 si hay demasiadas vistas.
+ */
+long rasterizar_vistas_preparadas(Vista* vistas, int num_vistas, unsigned int scene_status_mask, triobj* lista,
+                                  const Textura* tex) {
+    return rasterizar(vistas, num_vistas, scene_status_mask, lista, tex, 1);
+}
@@ -0,0 +1,367 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                          CONOS DE NORMALES                          *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * El back culling de procesar_objeto() pasa cada triángulo por la vista
+ * y la proyección para mirar su normal en pantalla, y en una órbita la
+ * cámara sólo gira un grado por frame: casi todos los triángulos dan lo
+ * mismo que en el frame anterior.
+ *
+ * Con CONOS_NORMALES los triángulos se agrupan de CONOS_TRIANGULOS_GRUPO
+ * en CONOS_TRIANGULOS_GRUPO, en el orden de triptr (que tras
+ * optimizar_triobj() o en las mallas generadas son caras vecinas), y de
+ * cada grupo se guarda en espacio de objeto el cono que contiene sus
+ * normales y la esfera que contiene sus vértices. Cada frame se sacan el
+ * centro de proyección y el signo de la vista en espacio de objeto, como
+ * en rasterizar_vistas() (ver multi_view.c), y con el cono:
+ *   - si todas las caras del grupo miran hacia atrás, se descarta entero;
+ *   - si todas miran hacia la cámara, se dibuja entero sin mirarlas;
+ *   - si no (el cono cruza la dirección de la cámara: la silueta), se
+ *     prueba cada cara con su plano, salvo que la cámara no se haya
+ *     movido lo bastante desde la última vez para cambiar ninguna, y
+ *     entonces vale lo que se guardó.
+ * El resultado es un bit por triángulo, que procesar_objeto() recorre de
+ * 64 en 64 saltándose las palabras vacías.
+ *
+ * Como en rasterizar_vistas(), la prueba es la geométrica: con la cámara
+ * por defecto descarta lo mismo que should_draw_polygon(), y con cámaras
+ * que miran hacia z positiva no se queda con las caras de atrás.
+ *
+ * Sólo para el objeto completo sin comprimir; si cambian los triángulos
+ * (optimizar_triobj, comprimir_triobj) se suelta con liberar_conos() y se
+ * rehace al pedirlo.
+ *
+ * obj->conos guarda el resultado y las pruebas del frame anterior y sus
+ * estadísticas, así que, como lod_actual, es estado de un solo hilo y de
+ * una sola cámara: rasterizar_vistas() (y con ella el render por lotes)
+ * quita CONOS_NORMALES de la máscara igual que NIVEL_DETALLE.
+ ***********************************************************************/
+
+typedef struct {
+    float eje[3];
+    float coseno, seno;          // Del semiángulo del cono; coseno 0 si no hay cono
+    float centro[3], radio;      // Esfera que contiene los vértices
+    unsigned long long validas;  // Triángulos del grupo que existen y no son degenerados
+
+    // Última prueba cara a cara: con qué centro de proyección (o dirección,
+    // en ortográfica) se hizo y cuánto se puede mover sin que cambie ninguna.
+    int probado;
+    float clave[3];
+    float margen;
+} GrupoConos;
+
+struct ConosNormales {
+    int num_grupos;
+    GrupoConos* grupos;
+    float* planos;                 // Normal unitaria y distancia al origen de cada cara (4 floats)
+    unsigned long long* visibles;  // Un bit por triángulo, el resultado del último frame
+    int perspectiva;               // Con qué se hicieron las pruebas guardadas
+    float signo;
+    EstadisticasConos stats;
+};
+
+static inline float punto4(const float* plano, const float* k) {
+    return plano[0] * k[0] + plano[1] * k[1] + plano[2] * k[2];
+}
+
+/**
+ * Planos de las caras y, por grupo, el cono de las normales y la esfera.
+ */
+static struct ConosNormales* construir_conos(const triobj* obj) {
+    int n = obj->num_triangles;
+    int num_grupos = (n + CONOS_TRIANGULOS_GRUPO - 1) / CONOS_TRIANGULOS_GRUPO;
+
+    struct ConosNormales* conos = (struct ConosNormales*)calloc(1, sizeof(struct ConosNormales));
+    if (!conos)
+        return NULL;
+    conos->num_grupos = num_grupos;
+    conos->grupos = (GrupoConos*)calloc((size_t)(num_grupos > 0 ? num_grupos : 1), sizeof(GrupoConos));
+    conos->planos = (float*)malloc(sizeof(float) * 4 * (size_t)(n > 0 ? n : 1));
+    conos->visibles = (unsigned long long*)calloc((size_t)(num_grupos > 0 ? num_grupos : 1), sizeof(unsigned long long));
+    if (!conos->grupos || !conos->planos || !conos->visibles) {
+        free(conos->grupos);
+        free(conos->planos);
+        free(conos->visibles);
+        free(conos);
+        return NULL;
+    }
+
+    for (int t = 0; t < n; t++) {
+        const Triangulo* tri = &obj->triptr[t];
+        Vector3 a = vector3(tri->p2.x - tri->p1.x, tri->p2.y - tri->p1.y, tri->p2.z - tri->p1.z);
+        Vector3 b = vector3(tri->p3.x - tri->p1.x, tri->p3.y - tri->p1.y, tri->p3.z - tri->p1.z);
+        Vector3 cara = vector3_cross_product(a, b);
+        float largo = sqrtf(vector3_dot_product(cara, cara));
+        float* plano = &conos->planos[4L * t];
+        if (largo > 0.0f) {
+            plano[0] = cara.x / largo;
+            plano[1] = cara.y / largo;
+            plano[2] = cara.z / largo;
+            plano[3] = plano[0] * tri->p1.x + plano[1] * tri->p1.y + plano[2] * tri->p1.z;
+        } else {
+            // Degenerada: n . (E - p) es 0 y se descarta siempre, como en la prueba normal.
+            plano[0] = plano[1] = plano[2] = plano[3] = 0.0f;
+        }
+    }
+
+    for (int g = 0; g < num_grupos; g++) {
+        GrupoConos* grupo = &conos->grupos[g];
+        int inicio = g * CONOS_TRIANGULOS_GRUPO;
+        int fin = inicio + CONOS_TRIANGULOS_GRUPO < n ? inicio + CONOS_TRIANGULOS_GRUPO : n;
+
+        float suma[3] = {0.0f, 0.0f, 0.0f};
+        float min[3] = {INFINITY, INFINITY, INFINITY}, max[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for (int t = inicio; t < fin; t++) {
+            const float* plano = &conos->planos[4L * t];
+            if (plano[0] == 0.0f && plano[1] == 0.0f && plano[2] == 0.0f)
+                continue;
+            grupo->validas |= 1ULL << (t - inicio);
+            for (int k = 0; k < 3; k++)
+                suma[k] += plano[k];
+
+            const Punto* p[3] = {&obj->triptr[t].p1, &obj->triptr[t].p2, &obj->triptr[t].p3};
+            for (int v = 0; v < 3; v++) {
+                float xyz[3] = {p[v]->x, p[v]->y, p[v]->z};
+                for (int k = 0; k < 3; k++) {
+                    if (xyz[k] < min[k]) min[k] = xyz[k];
+                    if (xyz[k] > max[k]) max[k] = xyz[k];
+                }
+            }
+        }
+        if (!grupo->validas)
+            continue;
+
+        for (int k = 0; k < 3; k++)
+            grupo->centro[k] = 0.5f * (min[k] + max[k]);
+        for (int t = inicio; t < fin; t++) {
+            if (!(grupo->validas >> (t - inicio) & 1))
+                continue;
+            const Punto* p[3] = {&obj->triptr[t].p1, &obj->triptr[t].p2, &obj->triptr[t].p3};
+            for (int v = 0; v < 3; v++) {
+                float dx = p[v]->x - grupo->centro[0], dy = p[v]->y - grupo->centro[1], dz = p[v]->z - grupo->centro[2];
+                float d = sqrtf(dx * dx + dy * dy + dz * dz);
+                if (d > grupo->radio)
+                    grupo->radio = d;
+            }
+        }
+
+        // Eje: la media de las normales; el semiángulo, lo que se aleja la más apartada.
+        float largo = sqrtf(suma[0] * suma[0] + suma[1] * suma[1] + suma[2] * suma[2]);
+        if (largo <= 0.0f)
+            continue;
+        for (int k = 0; k < 3; k++)
+            grupo->eje[k] = suma[k] / largo;
+        float min_coseno = 1.0f;
+        for (int t = inicio; t < fin; t++) {
+            if (!(grupo->validas >> (t - inicio) & 1))
+                continue;
+            float c = punto4(&conos->planos[4L * t], grupo->eje);
+            if (c < min_coseno)
+                min_coseno = c;
+        }
+        // Si las normales no caben en medio espacio el cono no sirve para nada.
+        if (min_coseno > 0.0f) {
+            grupo->coseno = min_coseno;
+            grupo->seno = sqrtf(1.0f - min_coseno * min_coseno);
+        }
+    }
+    return conos;
+}
+
+/**
+ * Prueba cara a cara de un grupo. Dibujada si signo * n . (K - p) < 0,
+ * con K el centro de proyección; en ortográfica, signo * n . K con K la
+ * dirección de la vista. Como n es unitaria, cada valor cambia como mucho
+ * lo que se mueva K: el menor en valor absoluto es el margen.
+ */
+static unsigned long long probar_grupo(const struct ConosNormales* conos, GrupoConos* grupo, int g, int n,
+                                       const float* k, int perspectiva, float signo) {
+    int inicio = g * CONOS_TRIANGULOS_GRUPO;
+    int fin = inicio + CONOS_TRIANGULOS_GRUPO < n ? inicio + CONOS_TRIANGULOS_GRUPO : n;
+    unsigned long long bits = 0;
+    float margen = INFINITY;
+
+    for (int t = inicio; t < fin; t++) {
+        const float* plano = &conos->planos[4L * t];
+        float valor = punto4(plano, k) - (perspectiva ? plano[3] : 0.0f);
+        if (signo * valor < 0.0f)
+            bits |= 1ULL << (t - inicio);
+        if (grupo->validas >> (t - inicio) & 1) {
+            float absoluto = fabsf(valor);
+            if (absoluto < margen)
+                margen = absoluto;
+        }
+    }
+    // Las degeneradas dan 0 y no se dibujan nunca.
+    bits &= grupo->validas;
+
+    grupo->probado = 1;
+    grupo->clave[0] = k[0];
+    grupo->clave[1] = k[1];
+    grupo->clave[2] = k[2];
+    grupo->margen = margen;
+    return bits;
+}
+
+/**
+ * Calcula qué triángulos del objeto miran a la cámara, por grupos con los
+ * conos de normales y reaprovechando las pruebas cara a cara del frame
+ * anterior. Construye los conos la primera vez que se piden.
+ * @param obj Objeto con triptr.
+ * @param camera Cámara del frame.
+ * @param scene_status_mask Máscara de estado (la proyección).
+ * @return Un bit por triángulo (el bit t % 64 de la palabra t / 64) a 1
+ *         si hay que dibujarlo, válido hasta la siguiente llamada; o NULL
+ *         si el objeto está comprimido o no hay memoria.
+ */
+const unsigned long long* visibilidad_conos(triobj* obj, const Camera* camera, unsigned int scene_status_mask) {
+    if (!obj->triptr)
+        return NULL;
+    if (!obj->conos) {
+        obj->conos = construir_conos(obj);
+        if (!obj->conos)
+            return NULL;
+    }
+    struct ConosNormales* conos = obj->conos;
+
+    // Vista por modelo: con A su parte 3x3 y t su traslación, el centro de
+    // proyección en objeto es -A^-1 t (ver preparar_vista en multi_view.c).
+    double modelo[4][4], vm[4][4];
+    memcpy(modelo, obj->mptr->m, sizeof(modelo));
+    matrix_multiplication((double(*)[4])camera->view->matrix, modelo, vm);
+
+    Vector3 a0 = vector3((float)vm[0][0], (float)vm[0][1], (float)vm[0][2]);
+    Vector3 a1 = vector3((float)vm[1][0], (float)vm[1][1], (float)vm[1][2]);
+    Vector3 a2 = vector3((float)vm[2][0], (float)vm[2][1], (float)vm[2][2]);
+    Vector3 c0 = vector3_cross_product(a1, a2);
+    Vector3 c1 = vector3_cross_product(a2, a0);
+    Vector3 c2 = vector3_cross_product(a0, a1);
+    float det = vector3_dot_product(a0, c0);
+
+    int perspectiva = (scene_status_mask & PROJECTION_PERSPECTIVE) != 0;
+    float k[3], signo;
+    if (perspectiva) {
+        float inv = det != 0.0f ? 1.0f / det : 0.0f;
+        float t0 = (float)vm[0][3], t1 = (float)vm[1][3], t2 = (float)vm[2][3];
+        k[0] = -(c0.x * t0 + c1.x * t1 + c2.x * t2) * inv;
+        k[1] = -(c0.y * t0 + c1.y * t1 + c2.y * t2) * inv;
+        k[2] = -(c0.z * t0 + c1.z * t1 + c2.z * t2) * inv;
+        signo = det < 0.0f ? -1.0f : 1.0f;
+    } else {
+        // En ortográfica, n . (a0 x a1) es la z de la normal en vista, que
+        // es el giro en pantalla tal cual, sin signo (sale lo mismo en
+        // objeto que en mundo: el cofactor del modelo se cancela).
+        float largo = sqrtf(vector3_dot_product(c2, c2));
+        float inv = largo > 0.0f ? 1.0f / largo : 0.0f;
+        k[0] = c2.x * inv;
+        k[1] = c2.y * inv;
+        k[2] = c2.z * inv;
+        signo = 1.0f;
+    }
+
+    // Con otra proyección u orientación no vale nada de lo guardado.
+    int conservar = conos->perspectiva == perspectiva && conos->signo == signo;
+    conos->perspectiva = perspectiva;
+    conos->signo = signo;
+
+    EstadisticasConos* stats = &conos->stats;
+    stats->grupos += conos->num_grupos;
+    for (int g = 0; g < conos->num_grupos; g++) {
+        GrupoConos* grupo = &conos->grupos[g];
+        if (!grupo->validas) {
+            conos->visibles[g] = 0;
+            stats->atras++;
+            continue;
+        }
+
+        if (grupo->coseno > 0.0f) {
+            // v = signo (K - c); para toda normal del cono y todo punto de
+            // la esfera, n . signo (K - p) >= (eje . v) cos - |v| sen - r.
+            float v[3];
+            for (int i = 0; i < 3; i++)
+                v[i] = signo * (k[i] - (perspectiva ? grupo->centro[i] : 0.0f));
+            float largo = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            float eje_v = grupo->eje[0] * v[0] + grupo->eje[1] * v[1] + grupo->eje[2] * v[2];
+            float holgura = largo * grupo->seno + (perspectiva ? grupo->radio : 0.0f);
+            if (eje_v * grupo->coseno >= holgura) {
+                conos->visibles[g] = 0;
+                grupo->probado = 0;
+                stats->atras++;
+                continue;
+            }
+            if (-eje_v * grupo->coseno > holgura) {
+                conos->visibles[g] = grupo->validas;
+                grupo->probado = 0;
+                stats->delante++;
+                continue;
+            }
+        }
+
+        stats->mixtos++;
+        if (conservar && grupo->probado) {
+            float dx = k[0] - grupo->clave[0], dy = k[1] - grupo->clave[1], dz = k[2] - grupo->clave[2];
+            if (dx * dx + dy * dy + dz * dz < grupo->margen * grupo->margen) {
+                stats->reutilizados++;
+                continue;
+            }
+        }
+        conos->visibles[g] = probar_grupo(conos, grupo, g, obj->num_triangles, k, perspectiva, signo);
+        int en_grupo = obj->num_triangles - g * CONOS_TRIANGULOS_GRUPO;
+        stats->triangulos_probados += en_grupo < CONOS_TRIANGULOS_GRUPO ? en_grupo : CONOS_TRIANGULOS_GRUPO;
+    }
+    return conos->visibles;
+}
+
+/**
+ * Suelta los conos del objeto, para cuando cambian sus triángulos.
+ * @param obj Objeto.
+ */
+void liberar_conos(triobj* obj) {
+    if (!obj->conos)
+        return;
+    free(obj->conos->grupos);
+    free(obj->conos->planos);
+    free(obj->conos->visibles);
+    free(obj->conos);
+    obj->conos = NULL;
+}
+
+/**
+ * Memoria de los conos del objeto, para memoria_triobj().
+ * @param obj Objeto.
+ * @return Bytes (0 si no se han construido).
+ */
+size_t memoria_conos(const triobj* obj) {
+    if (!obj->conos)
+        return 0;
+    return sizeof(struct ConosNormales) +
+           (sizeof(GrupoConos) + sizeof(unsigned long long)) * (size_t)obj->conos->num_grupos +
+           sizeof(float) * 4 * (size_t)obj->num_triangles;
+}
+
+/**
+ * Suma los contadores de los conos de todos los objetos de la escena
+ * desde que se construyeron.
+ * @param lista Primer objeto de la escena.
+ * @param stats Salida.
+ */
+void conos_estadisticas(const triobj* lista, EstadisticasConos* stats) {
+    memset(stats, 0, sizeof(EstadisticasConos));
+    for (const triobj* obj = lista; obj; obj = obj->hptr) {
+        if (!obj->conos)
+            continue;
+        const EstadisticasConos* s = &obj->conos->stats;
+        stats->grupos += s->grupos;
+        stats->atras += s->atras;
+        stats->delante += s->delante;
+        stats->mixtos += s->mixtos;
+        stats->reutilizados += s->reutilizados;
+        stats->triangulos_probados += s->triangulos_probados;
+    }
+}
@@ -0,0 +1,298 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                  OCLUSIÓN CON PIRÁMIDE DE PROFUNDIDAD               *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo rasteriza la escena completa descartando los objetos que
+ * quedan detrás de otros. En una escena cargada casi todo está tapado y
+ * aun así cada objeto se transformaba y se rasterizaba entero, para que
+ * luego el test de profundidad tirara los píxeles.
+ *
+ * Por frame:
+ *   1) Se calcula el rectángulo en pantalla y la profundidad mínima de la
+ *      caja de cada objeto. Lo que cae fuera del frustum ni se mira.
+ *   2) Se ordenan de delante a atrás.
+ *   3) Los grandes (oclusores) se dibujan primero y con su profundidad se
+ *      construye la pirámide: cada nivel guarda la profundidad máxima de
+ *      bloques cada vez más grandes.
+ *   4) Cada uno de los demás se prueba en el nivel en el que su
+ *      rectángulo cubre como mucho 2x2 celdas: si su punto más cercano
+ *      está más lejos que lo más lejano ya pintado en esas celdas, no se
+ *      puede ver y se salta sin transformar ningún triángulo.
+ *
+ * El test es conservador: las celdas cubren algo más que el rectángulo y
+ * un objeto que cruza el plano cercano se da siempre por visible.
+ ***********************************************************************/
+
+/**
+ * Construye la pirámide de profundidad a partir del buffer de profundidad
+ * del framebuffer. Reserva los niveles la primera vez.
+ * @param fb Framebuffer.
+ * @return 0 si todo fue bien, -1 si no hay memoria.
+ */
+int construir_piramide_profundidad(Framebuffer* fb) {
+    if (fb->piramide_niveles == 0) {
+        int ancho = fb->ancho, alto = fb->alto;
+        while (fb->piramide_niveles < PIRAMIDE_NIVELES_MAX && (ancho > 1 || alto > 1)) {
+            ancho = (ancho + 1) / 2;
+            alto = (alto + 1) / 2;
+            int n = fb->piramide_niveles;
+            fb->piramide[n] = (float*)malloc(sizeof(float) * (size_t)ancho * alto);
+            if (!fb->piramide[n])
+                return -1;
+            fb->piramide_ancho[n] = ancho;
+            fb->piramide_alto[n] = alto;
+            fb->piramide_niveles++;
+        }
+    }
+
+    const float* origen = fb->profundidad;
+    int ancho_origen = fb->ancho, alto_origen = fb->alto;
+    for (int n = 0; n < fb->piramide_niveles; n++) {
+        float* destino = fb->piramide[n];
+        int ancho = fb->piramide_ancho[n], alto = fb->piramide_alto[n];
+
+        for (int y = 0; y < alto; y++) {
+            // Con tamaño impar, la última fila o columna se repite.
+            const float* fila0 = &origen[(size_t)(2 * y) * ancho_origen];
+            const float* fila1 = &origen[(size_t)(2 * y + 1 < alto_origen ? 2 * y + 1 : 2 * y) * ancho_origen];
+            for (int x = 0; x < ancho; x++) {
+                int x0 = 2 * x, x1 = 2 * x + 1 < ancho_origen ? 2 * x + 1 : 2 * x;
+                float a = fila0[x0] > fila0[x1] ? fila0[x0] : fila0[x1];
+                float b = fila1[x0] > fila1[x1] ? fila1[x0] : fila1[x1];
+                destino[(size_t)y * ancho + x] = a > b ? a : b;
+            }
+        }
+        origen = destino;
+        ancho_origen = ancho;
+        alto_origen = alto;
+    }
+    return 0;
+}
+
+/**
+ * Prueba un rectángulo de pantalla contra la pirámide.
+ * @param fb Framebuffer con la pirámide construida.
+ * @param x0, y0, x1, y1 Rectángulo en píxeles.
+ * @param z_min Profundidad más cercana de lo que hay dentro del rectángulo.
+ * @return 1 si todo lo ya pintado en el rectángulo está más cerca que z_min.
+ */
+int rectangulo_ocluido(const Framebuffer* fb, float x0, float y0, float x1, float y1, float z_min) {
+    if (fb->piramide_niveles == 0)
+        return 0;
+
+    int px0 = (int)floorf(x0), py0 = (int)floorf(y0);
+    int px1 = (int)ceilf(x1) - 1, py1 = (int)ceilf(y1) - 1;
+    if (px0 < 0) px0 = 0;
+    if (py0 < 0) py0 = 0;
+    if (px1 >= fb->ancho) px1 = fb->ancho - 1;
+    if (py1 >= fb->alto) py1 = fb->alto - 1;
+    if (px0 > px1 || py0 > py1)
+        return 0;
+
+    // El nivel más fino en el que el rectángulo cubre como mucho 2x2 celdas.
+    int nivel = 0;
+    while (nivel + 1 < fb->piramide_niveles &&
+           ((px1 >> (nivel + 1)) - (px0 >> (nivel + 1)) > 1 || (py1 >> (nivel + 1)) - (py0 >> (nivel + 1)) > 1))
+        nivel++;
+
+    const float* celdas = fb->piramide[nivel];
+    int ancho = fb->piramide_ancho[nivel];
+    int cx1 = px1 >> (nivel + 1), cy1 = py1 >> (nivel + 1);
+    for (int y = py0 >> (nivel + 1); y <= cy1; y++) {
+        for (int x = px0 >> (nivel + 1); x <= cx1; x++) {
+            if (celdas[(size_t)y * ancho + x] >= z_min)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Proyección por vista de la cámara, como las aplica camera_pipeline().
+ * En ortográfica camera_pipeline() deja los triángulos en espacio de
+ * vista (la proyección se calcula pero no se aplica), así que es la vista
+ * sola.
+ * @param camera Cámara.
+ * @param scene_status_mask Máscara de estado (el tipo de proyección).
+ * @param pv Salida: proyección * vista.
+ */
+void matriz_proyeccion_vista(const Camera* camera, unsigned int scene_status_mask, double pv[4][4]) {
+    if (!(scene_status_mask & PROJECTION_PERSPECTIVE)) {
+        memcpy(pv, camera->view->matrix, sizeof(double) * 16);
+        return;
+    }
+    double proyeccion[4][4];
+    set_perspective_projection_matrix(proyeccion, ProjectionData.near_plane, ProjectionData.far_plane,
+                                      ProjectionData.right, ProjectionData.left, ProjectionData.top,
+                                      ProjectionData.bottom);
+    matrix_multiplication(proyeccion, camera->view->matrix, pv);
+}
+
+/**
+ * Rectángulo en pantalla y profundidad mínima de la caja de un objeto,
+ * con las mismas cuentas que camera_pipeline() y rasterizar_triangulo().
+ * El rectángulo se recorta al recorte actual del framebuffer.
+ * @param fb Framebuffer (tamaño y recorte).
+ * @param pv Proyección por vista (matriz_proyeccion_vista).
+ * @param scene_status_mask Máscara de estado (el tipo de proyección).
+ * @param obj Objeto.
+ * @param o Salida: rectángulo, profundidad y área.
+ * @return 0 si la caja queda fuera del frustum o del recorte.
+ */
+int objeto_en_pantalla(const Framebuffer* fb, const double pv[4][4], unsigned int scene_status_mask, triobj* obj,
+                       ObjetoPantalla* o) {
+    double modelo[4][4], t[4][4];
+    memcpy(modelo, obj->mptr->m, sizeof(modelo));
+    matrix_multiplication((double(*)[4])pv, modelo, t);
+
+    int perspectiva = (scene_status_mask & PROJECTION_PERSPECTIVE) != 0;
+    int fuera_todas = 0x1F, cruza_cercano = 0;
+    float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY, z_min = INFINITY;
+
+    for (int e = 0; e < 8; e++) {
+        double x = (e & 1) ? obj->caja_max[0] : obj->caja_min[0];
+        double y = (e & 2) ? obj->caja_max[1] : obj->caja_min[1];
+        double z = (e & 4) ? obj->caja_max[2] : obj->caja_min[2];
+        double cx = t[0][0] * x + t[0][1] * y + t[0][2] * z + t[0][3];
+        double cy = t[1][0] * x + t[1][1] * y + t[1][2] * z + t[1][3];
+        double cz = t[2][0] * x + t[2][1] * y + t[2][2] * z + t[2][3];
+        double cw = t[3][0] * x + t[3][1] * y + t[3][2] * z + t[3][3];
+
+        float sx, sy, profundidad;
+        if (perspectiva) {
+            int fuera = 0;
+            if (cx > cw) fuera |= 1;
+            if (cx < -cw) fuera |= 2;
+            if (cy > cw) fuera |= 4;
+            if (cy < -cw) fuera |= 8;
+            if (cw < ProjectionData.near_plane) fuera |= 16;
+            fuera_todas &= fuera;
+            if (cw < ProjectionData.near_plane) {
+                cruza_cercano = 1;
+                continue;
+            }
+            sx = (float)(cx / cw);
+            sy = (float)(cy / cw);
+            profundidad = (float)(cz * PERSPECTIVE_FACTOR / cw);
+        } else {
+            // En ortográfica pv es la vista: no hay división y la profundidad
+            // es la -z de vista, la que guarda rasterizar_triangulo().
+            fuera_todas = 0;
+            sx = (float)(cx / PERSPECTIVE_FACTOR);
+            sy = (float)(cy / PERSPECTIVE_FACTOR);
+            profundidad = (float)-cz;
+        }
+
+        float px = (sx * 0.5f + 0.5f) * fb->ancho;
+        float py = (0.5f - sy * 0.5f) * fb->alto;
+        if (px < x0) x0 = px;
+        if (px > x1) x1 = px;
+        if (py < y0) y0 = py;
+        if (py > y1) y1 = py;
+        if (profundidad < z_min) z_min = profundidad;
+    }
+
+    if (fuera_todas)
+        return 0;
+
+    o->obj = obj;
+    if (cruza_cercano) {
+        // Parte de la caja está detrás de la cámara: puede ocupar cualquier sitio.
+        o->x0 = o->y0 = 0.0f;
+        o->x1 = (float)fb->ancho;
+        o->y1 = (float)fb->alto;
+        o->z_min = -INFINITY;
+    } else {
+        o->x0 = x0 > fb->clip_x0 ? x0 : (float)fb->clip_x0;
+        o->y0 = y0 > fb->clip_y0 ? y0 : (float)fb->clip_y0;
+        o->x1 = x1 < fb->clip_x1 ? x1 : (float)fb->clip_x1;
+        o->y1 = y1 < fb->clip_y1 ? y1 : (float)fb->clip_y1;
+        o->z_min = z_min;
+        if (o->x0 >= o->x1 || o->y0 >= o->y1)
+            return 0;
+    }
+    o->area = (o->x1 - o->x0) * (o->y1 - o->y0) / ((float)fb->ancho * fb->alto);
+    return 1;
+}
+
+static int comparar_profundidad(const void* a, const void* b) {
+    float x = ((const ObjetoPantalla*)a)->z_min, y = ((const ObjetoPantalla*)b)->z_min;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Rasteriza la escena completa. Con OCLUSION_HIZ en la máscara los
+ * objetos van de delante a atrás, los grandes primero, y los tapados se
+ * descartan con la pirámide; sin él se dibujan todos en el orden de la
+ * lista. En los dos casos se salta lo que cae fuera del frustum.
+ * El framebuffer no se limpia aquí.
+ * @param fb Framebuffer destino.
+ * @param camera Cámara del frame.
+ * @param scene_status_mask Máscara de estado (proyección, BACK_CULLING, OCLUSION_HIZ...).
+ * @param lista Primer objeto de la escena.
+ * @param tex Textura (NULL para blanco).
+ * @param stats Salida opcional: recuento de objetos del frame.
+ * @return Triángulos rasterizados, o -1 si no hay memoria.
+ */
+long rasterizar_escena(Framebuffer* fb, Camera* camera, unsigned int scene_status_mask, triobj* lista,
+                       const Textura* tex, EstadisticasOclusion* stats) {
+    EstadisticasOclusion e = {0};
+    for (triobj* obj = lista; obj; obj = obj->hptr)
+        e.objetos++;
+
+    ObjetoPantalla* objetos = (ObjetoPantalla*)malloc(sizeof(ObjetoPantalla) * (size_t)(e.objetos > 0 ? e.objetos : 1));
+    if (!objetos)
+        return -1;
+
+    double pv[4][4];
+    matriz_proyeccion_vista(camera, scene_status_mask, pv);
+
+    int n = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr) {
+        if (objeto_en_pantalla(fb, (const double(*)[4])pv, scene_status_mask, obj, &objetos[n]))
+            n++;
+        else
+            e.fuera++;
+    }
+
+    if (!(scene_status_mask & OCLUSION_HIZ)) {
+        for (int i = 0; i < n; i++)
+            e.triangulos += procesar_objeto(camera, scene_status_mask, objetos[i].obj, fb, tex);
+        e.visibles = n;
+    } else {
+        qsort(objetos, (size_t)n, sizeof(ObjetoPantalla), comparar_profundidad);
+
+        // Oclusores: los más grandes, en orden de cercanía.
+        for (int i = 0; i < n && e.oclusores < OCLUSION_MAX_OCLUSORES; i++) {
+            if (objetos[i].area < OCLUSION_AREA_OCLUSOR)
+                continue;
+            e.triangulos += procesar_objeto(camera, scene_status_mask, objetos[i].obj, fb, tex);
+            objetos[i].obj = NULL;
+            e.oclusores++;
+        }
+        int piramide = e.oclusores > 0 && construir_piramide_profundidad(fb) == 0;
+
+        for (int i = 0; i < n; i++) {
+            if (!objetos[i].obj)
+                continue;
+            if (piramide && rectangulo_ocluido(fb, objetos[i].x0, objetos[i].y0, objetos[i].x1, objetos[i].y1,
+                                               objetos[i].z_min)) {
+                e.ocluidos++;
+                continue;
+            }
+            e.triangulos += procesar_objeto(camera, scene_status_mask, objetos[i].obj, fb, tex);
+        }
+        e.visibles = n - e.ocluidos;
+    }
+
+    free(objetos);
+    if (stats)
+        *stats = e;
+    return e.triangulos;
+}
@@ -0,0 +1,208 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                        CONTEXTO GL SIN VENTANA                      *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo crea un contexto OpenGL sin ventana, para poder ejecutar
+ * el camino de GL (ejes, malla, vectores normales...) en los nodos de
+ * render Linux y en CI, donde no hay pantalla ni GLUT que abra ventanas.
+ *
+ * Hay dos backends, elegidos al compilar:
+ *   -DOSMESA  OSMesa, que pinta en un buffer de memoria nuestro (-lOSMesa).
+ *   Linux     EGL con la plataforma sin superficie de Mesa y un pbuffer
+ *             (-lEGL). Si no existe esa plataforma, la pantalla por
+ *             defecto de EGL.
+ * En macOS no hay backend: ahí se usa la ventana de GLUT de siempre.
+ *
+ * Salvo que se diga otra cosa en LIBGL_ALWAYS_SOFTWARE, se pide el GL por
+ * software de Mesa (llvmpipe), para que las medidas sean comparables
+ * entre máquinas con y sin GPU. El contexto es de GL de compatibilidad,
+ * así que el modo inmediato y los arrays de cliente funcionan igual que
+ * en la ventana.
+ ***********************************************************************/
+
+#if defined(OSMESA)
+
+#include <GL/osmesa.h>
+
+struct ContextoOffscreen {
+    OSMesaContext contexto;
+    unsigned char* buffer;  // RGBA, ancho * alto * 4
+    int ancho, alto;
+};
+
+#elif defined(__linux__)
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+struct ContextoOffscreen {
+    EGLDisplay pantalla;
+    EGLSurface superficie;
+    EGLContext contexto;
+    int ancho, alto;
+};
+
+/**
+ * Pantalla EGL sin ventana: la plataforma sin superficie de Mesa si está,
+ * y si no la pantalla por defecto.
+ */
+static EGLDisplay abrir_pantalla_egl(void) {
+    EGLDisplay pantalla = EGL_NO_DISPLAY;
+    const char* extensiones = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (extensiones && strstr(extensiones, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display)
+            pantalla = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (pantalla == EGL_NO_DISPLAY)
+        pantalla = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    return pantalla;
+}
+
+#endif
+
+/**
+ * Crea un contexto GL sin ventana de ancho x alto y lo deja activo en el
+ * hilo que llama.
+ * @param ancho, alto Tamaño del framebuffer.
+ * @return El contexto, o NULL si no hay backend o no se ha podido crear.
+ */
+ContextoOffscreen* crear_contexto_offscreen(int ancho, int alto) {
+#if defined(OSMESA) || defined(__linux__)
+    if (ancho <= 0 || alto <= 0)
+        return NULL;
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    ContextoOffscreen* ctx = (ContextoOffscreen*)calloc(1, sizeof(ContextoOffscreen));
+    if (!ctx)
+        return NULL;
+    ctx->ancho = ancho;
+    ctx->alto = alto;
+#endif
+
+#if defined(OSMESA)
+    ctx->buffer = (unsigned char*)malloc((size_t)ancho * alto * 4);
+    ctx->contexto = OSMesaCreateContextExt(OSMESA_RGBA, 24, 0, 0, NULL);
+    if (!ctx->buffer || !ctx->contexto ||
+        !OSMesaMakeCurrent(ctx->contexto, ctx->buffer, GL_UNSIGNED_BYTE, ancho, alto)) {
+        printf("\nNo se ha podido crear el contexto OSMesa.\n");
+        destruir_contexto_offscreen(ctx);
+        return NULL;
+    }
+    return ctx;
+
+#elif defined(__linux__)
+    static const EGLint atributos_config[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE,
+    };
+    const EGLint atributos_pbuffer[] = {EGL_WIDTH, ancho, EGL_HEIGHT, alto, EGL_NONE};
+
+    EGLConfig config;
+    EGLint num_configs = 0;
+    ctx->pantalla = abrir_pantalla_egl();
+    ctx->superficie = EGL_NO_SURFACE;
+    ctx->contexto = EGL_NO_CONTEXT;
+
+    if (ctx->pantalla == EGL_NO_DISPLAY || !eglInitialize(ctx->pantalla, NULL, NULL)) {
+        printf("\nNo se ha podido abrir una pantalla EGL.\n");
+        free(ctx);
+        return NULL;
+    }
+    if (!eglChooseConfig(ctx->pantalla, atributos_config, &config, 1, &num_configs) || num_configs < 1 ||
+        !eglBindAPI(EGL_OPENGL_API) ||
+        (ctx->superficie = eglCreatePbufferSurface(ctx->pantalla, config, atributos_pbuffer)) == EGL_NO_SURFACE ||
+        (ctx->contexto = eglCreateContext(ctx->pantalla, config, EGL_NO_CONTEXT, NULL)) == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(ctx->pantalla, ctx->superficie, ctx->superficie, ctx->contexto)) {
+        printf("\nNo se ha podido crear el contexto EGL (error 0x%x).\n", eglGetError());
+        destruir_contexto_offscreen(ctx);
+        return NULL;
+    }
+    return ctx;
+
+#else
+    printf("\nNo hay contexto sin ventana en esta plataforma, usa la ventana de GLUT.\n");
+    return NULL;
+#endif
+}
+
+/**
+ * Suelta el contexto (y lo desactiva si era el actual).
+ * @param ctx Contexto, puede ser NULL.
+ */
+void destruir_contexto_offscreen(ContextoOffscreen* ctx) {
+    if (!ctx)
+        return;
+#if defined(OSMESA)
+    if (ctx->contexto)
+        OSMesaDestroyContext(ctx->contexto);
+    free(ctx->buffer);
+#elif defined(__linux__)
+    eglMakeCurrent(ctx->pantalla, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (ctx->contexto != EGL_NO_CONTEXT)
+        eglDestroyContext(ctx->pantalla, ctx->contexto);
+    if (ctx->superficie != EGL_NO_SURFACE)
+        eglDestroySurface(ctx->pantalla, ctx->superficie);
+    eglTerminate(ctx->pantalla);
+#endif
+    free(ctx);
+}
+
+/**
+ * Nombre del backend y del renderer de GL, para los informes.
+ * @param ctx Contexto activo.
+ * @return Cadena estática.
+ */
+const char* contexto_offscreen_backend(const ContextoOffscreen* ctx) {
+    static char descripcion[160];
+#if defined(OSMESA)
+    const char* backend = "OSMesa";
+#elif defined(__linux__)
+    const char* backend = "EGL";
+#else
+    const char* backend = "ninguno";
+#endif
+    const GLubyte* renderer = ctx ? glGetString(GL_RENDERER) : NULL;
+    snprintf(descripcion, sizeof(descripcion), "%s, %s", backend, renderer ? (const char*)renderer : "sin renderer");
+    return descripcion;
+}
+
+/**
+ * Lee el framebuffer tras terminar lo pendiente, de arriba abajo (como un
+ * PPM, al revés que glReadPixels).
+ * @param ctx Contexto activo.
+ * @param rgb Salida: ancho * alto * 3 bytes.
+ * @return 0 si todo fue bien, -1 si no hay contexto.
+ */
+int leer_pixeles_offscreen(ContextoOffscreen* ctx, unsigned char* rgb) {
+    if (!ctx || !rgb)
+        return -1;
+
+    glFinish();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, ctx->ancho, ctx->alto, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+
+    // GL deja la primera fila abajo: se les da la vuelta en el sitio.
+    size_t bytes_fila = (size_t)ctx->ancho * 3;
+    for (int fila = 0; fila < ctx->alto / 2; fila++) {
+        unsigned char* a = &rgb[(size_t)fila * bytes_fila];
+        unsigned char* b = &rgb[(size_t)(ctx->alto - 1 - fila) * bytes_fila];
+        for (size_t i = 0; i < bytes_fila; i++) {
+            unsigned char t = a[i];
+            a[i] = b[i];
+            b[i] = t;
+        }
+    }
+    return 0;
+}
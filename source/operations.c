@@ -31,15 +31,8 @@ void mxp(Punto *pptr, double matriz_trans[16], Punto p)
     double res[4] = {0.0, 0.0, 0.0, 0.0};
 
 #ifdef DEBUG
-    // Imprime la matriz y el punto
-    printf("Matriz:\n");
-    for (int i = 0; i < 4; i++) {
-        for (int j = 0; j < 4; j++) {
-            printf("%.2f\t", matriz_trans[i * 4 + j]);
-        }
-        printf("\n");
-    }
-    printf("\nVector Punto: [%.2f, %.2f, %.2f, 1.0]\n\n", p.x, p.y, p.z);
+    // Nada de printf aquí, se llama millones de veces por frame. Va al registro de trazas.
+    TRACE_INSTANTE("mxp entrada", p.x, p.y, p.z);
 #endif
 
     // Multiplicar matriz por vector
@@ -56,7 +49,7 @@ void mxp(Punto *pptr, double matriz_trans[16], Punto p)
     pptr->w = res[3];
 
 #ifdef DEBUG
-    printf("Resultado: [%.2f, %.2f, %.2f]\n", pptr->x, pptr->y, pptr->z);
+    TRACE_INSTANTE("mxp resultado", pptr->x, pptr->y, pptr->z, pptr->w);
 #endif
 
     // Copio coordenadas de textura.
@@ -289,6 +282,22 @@ Punto calcular_centroide(triobj* obj) {
     Punto centro = {0, 0, 0};
     int total_puntos = 0;
 
+    if (obj->compacta) {
+        // Comprimido: la media de los enteros, llevada a la caja del objeto.
+        const MallaCompacta* c = obj->compacta;
+        double suma[3] = {0.0, 0.0, 0.0};
+        for (long i = 0; i < 3L * obj->num_triangles; i++) {
+            suma[0] += c->vertices[i].x;
+            suma[1] += c->vertices[i].y;
+            suma[2] += c->vertices[i].z;
+        }
+        double n = obj->num_triangles > 0 ? 3.0 * obj->num_triangles : 1.0;
+        centro.x = c->min[0] + (float)(suma[0] / n) * c->escala[0];
+        centro.y = c->min[1] + (float)(suma[1] / n) * c->escala[1];
+        centro.z = c->min[2] + (float)(suma[2] / n) * c->escala[2];
+        return centro;
+    }
+
     for (int i = 0; i < obj->num_triangles; i++) {
         centro.x += obj->triptr[i].p1.x + obj->triptr[i].p2.x + obj->triptr[i].p3.x;
         centro.y += obj->triptr[i].p1.y + obj->triptr[i].p2.y + obj->triptr[i].p3.y;
@@ -332,7 +341,8 @@ void scale_point(Punto* punto, const float factor) {
 /**
  * Aplica corrección de profundidad de perspectiva a los vértices de un triángulo.
  * Básicamente ajusta las coordenadas de los vértices del triángulo basándose en
- * su componente 'w'.
+ * su componente 'w'. La w se conserva en el triángulo, la necesita el rasterizado
+ * para interpolar las coordenadas de textura corregidas por perspectiva.
  * @param triangulo Puntero al triángulo a modificar.
  * @param p1, p2, p3 Puntos que definen los vértices del triángulo.
  */
@@ -348,6 +358,10 @@ void apply_perspective_depth(Triangulo* triangulo, Punto* p1, Punto* p2, Punto*
     triangulo->p3.x = p3->x / p3->w;
     triangulo->p3.y = p3->y / p3->w;
     triangulo->p3.z = p3->z / p3->w;
+
+    triangulo->p1.w = p1->w;
+    triangulo->p2.w = p2->w;
+    triangulo->p3.w = p3->w;
 }
 
 /**
@@ -398,6 +412,6 @@ void obtain_normal_vector(const Triangulo* poligono, Vector3* normal_vector) {
  */
 int should_draw_polygon(const Vector3 normal_vector, const Vector3 vector_forward) {
     const float dot_product = vector3_dot_product(normal_vector, vector_forward);
-    printf("\n dot product value: %f\n", dot_product);
+    TRACE_INSTANTE("dot product", dot_product);
     return dot_product > 0 ? 0 : 1;
 }
\ No newline at end of file
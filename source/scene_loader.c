@@ -0,0 +1,184 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/***********************************************************************
+ *                                                                     *
+ *                          CARGA DE ESCENAS                           *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo carga una escena de varios ficheros en paralelo. Antes se
+ * llamaba a cargar_triangulos() fichero a fichero y se enlazaban los
+ * triobj por hptr, así que el arranque crecía con el número de ficheros
+ * mientras el disco y el resto de núcleos estaban parados.
+ *
+ * Cada hilo toma el siguiente fichero pendiente, lo lee con el cargador
+ * y hace todo el postproceso de crear_triobj() (caja, normales de vértice
+ * e índice de vértices soldados), el reordenado para la caché de vértices
+ * de optimizar_triobj() y los niveles de detalle. Cuando han acabado
+ * todos, los objetos se enlazan en el orden de la lista de ficheros, el
+ * mismo que con la carga secuencial, y la lista completa se publica de
+ * una sola vez: un hilo que esté leyendo la escena ve la anterior o la
+ * nueva entera.
+ ***********************************************************************/
+
+typedef struct {
+    char** rutas;
+    int num_rutas;
+    CargadorTriangulos cargador;
+    triobj** objetos;             // Uno por fichero, NULL si ha fallado
+    _Atomic int siguiente;
+
+    pthread_mutex_t mutex;        // Sólo para acumular los tiempos y fallos de caché
+    double lectura_ms, postproceso_ms;
+    double fallos_antes, fallos_despues;
+    long triangulos_optimizados;
+} TrabajoCarga;
+
+static double ahora_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void* hilo_carga(void* arg) {
+    TrabajoCarga* trabajo = (TrabajoCarga*)arg;
+    double lectura_ms = 0.0, postproceso_ms = 0.0;
+    double fallos_antes = 0.0, fallos_despues = 0.0;
+    long triangulos_optimizados = 0;
+
+    for (;;) {
+        int i = atomic_fetch_add(&trabajo->siguiente, 1);
+        if (i >= trabajo->num_rutas)
+            break;
+
+        double inicio = ahora_ms();
+        Triangulo* triangulos = NULL;
+        int num_triangulos = 0;
+        int resultado = trabajo->cargador(trabajo->rutas[i], &num_triangulos, &triangulos);
+        double leido = ahora_ms();
+        lectura_ms += leido - inicio;
+
+        if (resultado < 0 || !triangulos) {
+            free(triangulos);
+            continue;
+        }
+
+        trabajo->objetos[i] = crear_triobj(triangulos, num_triangulos);
+        if (!trabajo->objetos[i]) {
+            free(triangulos);
+        } else {
+            // Antes de los niveles de detalle, que salen del orden de triptr.
+            // Si falla, el objeto se queda en el orden del fichero.
+            EstadisticasOptimizacion optimizacion;
+            if (optimizar_triobj(trabajo->objetos[i], &optimizacion) == 0) {
+                fallos_antes += (double)optimizacion.acmr_antes * optimizacion.triangulos;
+                fallos_despues += (double)optimizacion.acmr_despues * optimizacion.triangulos;
+                triangulos_optimizados += optimizacion.triangulos;
+            }
+            generar_lods(trabajo->objetos[i], LOD_NIVELES); // Si falla, se dibuja siempre completo
+        }
+        postproceso_ms += ahora_ms() - leido;
+    }
+
+    pthread_mutex_lock(&trabajo->mutex);
+    trabajo->lectura_ms += lectura_ms;
+    trabajo->postproceso_ms += postproceso_ms;
+    trabajo->fallos_antes += fallos_antes;
+    trabajo->fallos_despues += fallos_despues;
+    trabajo->triangulos_optimizados += triangulos_optimizados;
+    pthread_mutex_unlock(&trabajo->mutex);
+    return NULL;
+}
+
+/**
+ * Carga y prepara los objetos de una escena en paralelo.
+ * @param rutas Ficheros de la escena, en el orden en que quedarán en la lista.
+ * @param num_rutas Número de ficheros.
+ * @param cargador Función de lectura, normalmente cargar_triangulos.
+ * @param hilos Hilos de carga (<= 0 para uno por núcleo).
+ * @param stats Salida opcional: tiempos y recuento de la carga.
+ * @return Primer objeto de la lista enlazada por hptr, o NULL si no se ha
+ *         podido cargar ninguno. Los ficheros que fallan se omiten.
+ */
+triobj* cargar_escena(char** rutas, int num_rutas, CargadorTriangulos cargador, int hilos,
+                      EstadisticasCargaEscena* stats) {
+    double inicio = ahora_ms();
+
+    if (hilos <= 0)
+        hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos > num_rutas)
+        hilos = num_rutas;
+    if (hilos < 1)
+        hilos = 1;
+
+    TrabajoCarga trabajo = {.rutas = rutas, .num_rutas = num_rutas, .cargador = cargador, .siguiente = 0};
+    trabajo.objetos = (triobj**)calloc((size_t)(num_rutas > 0 ? num_rutas : 1), sizeof(triobj*));
+    pthread_t* ids = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)hilos);
+    if (!trabajo.objetos || !ids) {
+        free(trabajo.objetos);
+        free(ids);
+        return NULL;
+    }
+    pthread_mutex_init(&trabajo.mutex, NULL);
+
+    // El hilo que llama también trabaja; si no se puede crear algún hilo,
+    // los ficheros se los reparten los que haya.
+    int lanzados = 0;
+    for (int h = 1; h < hilos; h++) {
+        if (pthread_create(&ids[lanzados], NULL, hilo_carga, &trabajo) == 0)
+            lanzados++;
+    }
+    hilo_carga(&trabajo);
+    for (int h = 0; h < lanzados; h++)
+        pthread_join(ids[h], NULL);
+    pthread_mutex_destroy(&trabajo.mutex);
+
+    // Enlazado en el orden de los ficheros.
+    triobj* lista = NULL;
+    triobj** enlace = &lista;
+    int fallidos = 0;
+    long triangulos = 0;
+    for (int i = 0; i < num_rutas; i++) {
+        if (!trabajo.objetos[i]) {
+            fallidos++;
+            continue;
+        }
+        triangulos += trabajo.objetos[i]->num_triangles;
+        *enlace = trabajo.objetos[i];
+        enlace = &trabajo.objetos[i]->hptr;
+    }
+
+    if (stats) {
+        stats->ficheros = num_rutas;
+        stats->fallidos = fallidos;
+        stats->hilos = lanzados + 1;
+        stats->triangulos = triangulos;
+        stats->total_ms = ahora_ms() - inicio;
+        stats->lectura_ms = trabajo.lectura_ms;
+        stats->postproceso_ms = trabajo.postproceso_ms;
+        long optimizados = trabajo.triangulos_optimizados;
+        stats->acmr_antes = optimizados > 0 ? (float)(trabajo.fallos_antes / optimizados) : 0.0f;
+        stats->acmr_despues = optimizados > 0 ? (float)(trabajo.fallos_despues / optimizados) : 0.0f;
+    }
+
+    free(trabajo.objetos);
+    free(ids);
+    return lista;
+}
+
+/**
+ * Sustituye la escena de una vez. Los lectores que carguen el puntero
+ * con memory_order_acquire ven la lista nueva ya completa.
+ * @param escena Puntero compartido a la escena actual.
+ * @param lista Nueva lista (la de cargar_escena).
+ * @return La lista anterior, para liberarla cuando nadie la esté usando.
+ */
+triobj* publicar_escena(_Atomic(triobj*)* escena, triobj* lista) {
+    return atomic_exchange_explicit(escena, lista, memory_order_acq_rel);
+}
@@ -0,0 +1,130 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                          PIPELINE DE ESCENA                         *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo recorre la escena completa (la lista de triobj) y pasa
+ * cada triángulo por camera_pipeline() y el back culling, sin depender
+ * de GLUT. Es lo que usan los benchmarks y el reproductor de sesiones
+ * para tener frames "reales" sin ventana.
+ *
+ * Los objetos comprimidos se descomprimen triángulo a triángulo justo
+ * antes de transformarlos, con la descuantización metida en su matriz.
+ *
+ * Con NIVEL_DETALLE en la máscara, cada objeto que tenga niveles de
+ * detalle pasa por la pipeline con el que le toque por su tamaño en
+ * pantalla (ver mesh_lod.c).
+ *
+ * Con VERTICES_MUNDO, los objetos completos sin comprimir parten de sus
+ * triángulos ya en espacio mundo y sólo se les aplica vista y proyección
+ * (ver world_vertices.c).
+ *
+ * Con CONOS_NORMALES y BACK_CULLING, los mismos objetos deciden el back
+ * culling por grupos antes de la pipeline y los triángulos de espaldas
+ * no se transforman (ver normal_cones.c).
+ ***********************************************************************/
+
+/**
+ * Pasa un objeto por la pipeline y, si se da un framebuffer, rasteriza
+ * los triángulos que sobreviven al culling.
+ * @param camera Cámara desde la que se renderiza.
+ * @param scene_status_mask Máscara de estado (proyección, BACK_CULLING...).
+ * @param obj Objeto.
+ * @param fb Framebuffer donde rasterizar, o NULL para sólo transformar.
+ * @param tex Textura del rasterizado (NULL para blanco).
+ * @return Número de triángulos que sobreviven al culling.
+ */
+long procesar_objeto(Camera* camera, unsigned int scene_status_mask, triobj* obj, Framebuffer* fb, const Textura* tex) {
+    Triangulo procesado;
+    Vector3 normal;
+    long dibujados = 0;
+
+    const MallaCompacta* c = obj->compacta;
+    Triangulo* triangulos = obj->triptr;
+    int num_triangulos = obj->num_triangles;
+    double* m = obj->mptr->m;
+    double m_descuantizada[16];
+    Triangulo descomprimido;
+
+    // Los niveles simplificados se guardan sin comprimir.
+    int nivel = (scene_status_mask & NIVEL_DETALLE) ? seleccionar_lod(obj, camera, scene_status_mask) : 0;
+    if (nivel > 0) {
+        c = NULL;
+        triangulos = obj->lods[nivel - 1].triptr;
+        num_triangulos = obj->lods[nivel - 1].num_triangles;
+    }
+    if (c) {
+        matriz_descuantizada(c, m, m_descuantizada);
+        m = m_descuantizada;
+    }
+
+    // Si no se puede (comprimido, sin memoria), por el camino de siempre.
+    const Triangulo* mundo = NULL;
+    if ((scene_status_mask & VERTICES_MUNDO) && nivel == 0 && !c)
+        mundo = triangulos_mundo(obj);
+
+    const unsigned long long* visibles = NULL;
+    if ((scene_status_mask & CONOS_NORMALES) && (scene_status_mask & BACK_CULLING) && nivel == 0 && !c) {
+        TIMING_INICIO(marca_conos);
+        visibles = visibilidad_conos(obj, camera, scene_status_mask);
+        TIMING_ETAPA(ETAPA_CULLING, marca_conos, num_triangulos);
+    }
+
+    for (int i = 0; i < num_triangulos; i++) {
+        if (visibles) {
+            unsigned long long palabra = visibles[i / CONOS_TRIANGULOS_GRUPO];
+            if (!palabra) {
+                // Grupo entero de espaldas: al último de la palabra y el for pasa al siguiente.
+                i |= CONOS_TRIANGULOS_GRUPO - 1;
+                continue;
+            }
+            if (!(palabra >> (i % CONOS_TRIANGULOS_GRUPO) & 1))
+                continue;
+        }
+        Triangulo* triangulo = &descomprimido;
+        if (c) {
+            punto_compacto(c, &c->vertices[3L * i], &descomprimido.p1);
+            punto_compacto(c, &c->vertices[3L * i + 1], &descomprimido.p2);
+            punto_compacto(c, &c->vertices[3L * i + 2], &descomprimido.p3);
+        } else {
+            triangulo = &triangulos[i];
+        }
+        if (mundo)
+            camera_pipeline_mundo(camera, scene_status_mask, &procesado, &mundo[i]);
+        else
+            camera_pipeline(camera, scene_status_mask, &procesado, triangulo, m);
+
+        if ((scene_status_mask & BACK_CULLING) && !visibles) {
+            TIMING_INICIO_MUESTREO(marca_culling);
+            obtain_normal_vector(&procesado, &normal);
+            int dibujar = should_draw_polygon(normal, camera->vector_forward);
+            TIMING_ETAPA(ETAPA_CULLING, marca_culling, 1);
+            if (!dibujar)
+                continue;
+        }
+        if (fb)
+            rasterizar_triangulo(fb, &procesado, tex, scene_status_mask);
+        dibujados++;
+    }
+
+    return dibujados;
+}
+
+/**
+ * Procesa un frame de toda la escena desde una cámara.
+ * @param camera Cámara desde la que se renderiza.
+ * @param scene_status_mask Máscara de estado (proyección, BACK_CULLING...).
+ * @param lista Primer objeto de la lista de la escena.
+ * @return Número de triángulos que sobreviven al culling.
+ */
+long procesar_escena(Camera* camera, unsigned int scene_status_mask, triobj* lista) {
+    long dibujados = 0;
+    for (triobj* obj = lista; obj; obj = obj->hptr)
+        dibujados += procesar_objeto(camera, scene_status_mask, obj, NULL, NULL);
+    return dibujados;
+}
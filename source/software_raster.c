@@ -0,0 +1,275 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                         RASTERIZADO POR SOFTWARE                    *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo implementa un backend de rasterizado por software: un
+ * framebuffer RGB con buffer de profundidad y el rasterizado de
+ * triángulos texturizados por spans, usando los gradientes corregidos
+ * por perspectiva de span_interpolation.c.
+ *
+ * Los triángulos llegan tal como salen de camera_pipeline(): en
+ * perspectiva, x e y van escalados por PERSPECTIVE_FACTOR, así que el
+ * lienzo visible es [-PERSPECTIVE_FACTOR, PERSPECTIVE_FACTOR] en ambos
+ * ejes (igual que la ventana de la versión GL) y se mapea al framebuffer.
+ ***********************************************************************/
+
+/**
+ * Crea un framebuffer con su buffer de profundidad y los arrays de
+ * trabajo de los spans.
+ * @param ancho, alto Dimensiones en píxeles.
+ * @return Framebuffer creado, o NULL si no hay memoria.
+ */
+Framebuffer* crear_framebuffer(int ancho, int alto) {
+    Framebuffer* fb = (Framebuffer*)calloc(1, sizeof(Framebuffer));
+    if (!fb)
+        return NULL;
+
+    fb->ancho = ancho;
+    fb->alto = alto;
+    fb->rgb = (unsigned char*)malloc((size_t)ancho * alto * 3);
+    fb->profundidad = (float*)malloc(sizeof(float) * (size_t)ancho * alto);
+    fb->span_u = (float*)malloc(sizeof(float) * ancho);
+    fb->span_v = (float*)malloc(sizeof(float) * ancho);
+    fb->span_z = (float*)malloc(sizeof(float) * ancho);
+    fb->span_x = (int*)malloc(sizeof(int) * ancho);
+    fb->span_rgba = (unsigned int*)malloc(sizeof(unsigned int) * ancho);
+
+    if (!fb->rgb || !fb->profundidad || !fb->span_u || !fb->span_v || !fb->span_z || !fb->span_x || !fb->span_rgba) {
+        liberar_framebuffer(fb);
+        return NULL;
+    }
+
+    framebuffer_recorte(fb, 0, 0, ancho, alto);
+    limpiar_framebuffer(fb, 0, 0, 0);
+    return fb;
+}
+
+/**
+ * Libera un framebuffer y todos sus buffers, pirámide de profundidad incluida.
+ * @param fb Framebuffer a liberar.
+ */
+void liberar_framebuffer(Framebuffer* fb) {
+    if (!fb)
+        return;
+    free(fb->rgb);
+    free(fb->profundidad);
+    free(fb->span_u);
+    free(fb->span_v);
+    free(fb->span_z);
+    free(fb->span_x);
+    free(fb->span_rgba);
+    for (int i = 0; i < fb->piramide_niveles; i++)
+        free(fb->piramide[i]);
+    free(fb);
+}
+
+/**
+ * Rellena el framebuffer con un color y reinicia la profundidad.
+ * @param fb Framebuffer.
+ * @param r, g, b Color de fondo.
+ */
+void limpiar_framebuffer(Framebuffer* fb, unsigned char r, unsigned char g, unsigned char b) {
+    size_t pixeles = (size_t)fb->ancho * fb->alto;
+    for (size_t i = 0; i < pixeles; i++) {
+        fb->rgb[i * 3 + 0] = r;
+        fb->rgb[i * 3 + 1] = g;
+        fb->rgb[i * 3 + 2] = b;
+        fb->profundidad[i] = INFINITY;
+    }
+}
+
+/**
+ * Como limpiar_framebuffer(), pero sólo en un rectángulo.
+ * @param fb Framebuffer.
+ * @param x0, y0, x1, y1 Rectángulo [x0, x1) x [y0, y1), en píxeles.
+ * @param r, g, b Color de fondo.
+ */
+void limpiar_rectangulo(Framebuffer* fb, int x0, int y0, int x1, int y1, unsigned char r, unsigned char g,
+                        unsigned char b) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > fb->ancho) x1 = fb->ancho;
+    if (y1 > fb->alto) y1 = fb->alto;
+
+    for (int y = y0; y < y1; y++) {
+        size_t fila = (size_t)y * fb->ancho;
+        for (int x = x0; x < x1; x++) {
+            fb->rgb[(fila + x) * 3 + 0] = r;
+            fb->rgb[(fila + x) * 3 + 1] = g;
+            fb->rgb[(fila + x) * 3 + 2] = b;
+            fb->profundidad[fila + x] = INFINITY;
+        }
+    }
+}
+
+/**
+ * Pasa un punto del lienzo de la escena a coordenadas de píxel. La y se
+ * invierte, en el framebuffer la fila 0 es la de arriba.
+ */
+static void punto_a_pantalla(const Framebuffer* fb, Punto* p) {
+    p->x = (p->x / PERSPECTIVE_FACTOR * 0.5f + 0.5f) * fb->ancho;
+    p->y = (0.5f - p->y / PERSPECTIVE_FACTOR * 0.5f) * fb->alto;
+}
+
+/**
+ * Rasteriza un triángulo texturizado con test de profundidad.
+ * @param fb Framebuffer destino.
+ * @param triangulo Triángulo tal como sale de camera_pipeline().
+ * @param tex Textura a aplicar, o NULL para pintar en blanco.
+ * @param scene_status_mask Máscara de escena; en ortográfica la profundidad es -z.
+ * @return Número de píxeles escritos.
+ */
+long rasterizar_triangulo(Framebuffer* fb, const Triangulo* triangulo, const Textura* tex, unsigned int scene_status_mask) {
+    TIMING_INICIO_MUESTREO(marca);
+
+    // Sin clipping contra el plano cercano: un vértice detrás de la cámara
+    // descarta el triángulo entero (el mismo umbral que preparar_gradientes()).
+    // En ortográfica no hay w.
+    int detras = (scene_status_mask & PROJECTION_PERSPECTIVE) &&
+                 (triangulo->p1.w <= 1e-6f || triangulo->p2.w <= 1e-6f || triangulo->p3.w <= 1e-6f);
+    TIMING_ETAPA(ETAPA_CLIPPING, marca, 1);
+    if (detras)
+        return 0;
+
+    Triangulo t = *triangulo;
+
+    punto_a_pantalla(fb, &t.p1);
+    punto_a_pantalla(fb, &t.p2);
+    punto_a_pantalla(fb, &t.p3);
+
+    // En ortográfica no hay w ni división; la profundidad crece hacia -z.
+    if (!(scene_status_mask & PROJECTION_PERSPECTIVE)) {
+        t.p1.w = t.p2.w = t.p3.w = 1.0f;
+        t.p1.z = -t.p1.z;
+        t.p2.z = -t.p2.z;
+        t.p3.z = -t.p3.z;
+    }
+
+    GradientesTriangulo g;
+    if (!preparar_gradientes(&t, &g))
+        return 0;
+
+    // Orden por y ascendente (fila 0 arriba), para recorrer las aristas.
+    Punto* p[3] = {&t.p1, &t.p2, &t.p3};
+    if (p[0]->y > p[1]->y) { Punto* aux = p[0]; p[0] = p[1]; p[1] = aux; }
+    if (p[0]->y > p[2]->y) { Punto* aux = p[0]; p[0] = p[2]; p[2] = aux; }
+    if (p[1]->y > p[2]->y) { Punto* aux = p[1]; p[1] = p[2]; p[2] = aux; }
+
+    int y_inicio = (int)ceilf(p[0]->y - 0.5f);
+    int y_fin = (int)ceilf(p[2]->y - 0.5f);
+    if (y_inicio < fb->clip_y0) y_inicio = fb->clip_y0;
+    if (y_fin > fb->clip_y1) y_fin = fb->clip_y1;
+
+    long escritos = 0;
+    for (int y = y_inicio; y < y_fin; y++) {
+        float yc = y + 0.5f;
+
+        // Arista larga p0-p2 y la corta que corresponda a esta fila.
+        float xa = p[0]->x + (yc - p[0]->y) * (p[2]->x - p[0]->x) / (p[2]->y - p[0]->y);
+        float xb;
+        if (yc < p[1]->y)
+            xb = p[0]->x + (yc - p[0]->y) * (p[1]->x - p[0]->x) / (p[1]->y - p[0]->y);
+        else
+            xb = p[1]->x + (yc - p[1]->y) * (p[2]->x - p[1]->x) / (p[2]->y - p[1]->y);
+
+        if (xa > xb) { float aux = xa; xa = xb; xb = aux; }
+
+        int x_inicio = (int)ceilf(xa - 0.5f);
+        int x_fin = (int)ceilf(xb - 0.5f);
+        if (x_inicio < fb->clip_x0) x_inicio = fb->clip_x0;
+        if (x_fin > fb->clip_x1) x_fin = fb->clip_x1;
+        if (x_inicio >= x_fin)
+            continue;
+
+        interpolar_span(&g, y, x_inicio, x_fin, fb->span_u, fb->span_v, fb->span_z);
+
+        // Primero el test de profundidad, compactando los píxeles visibles
+        // (en el mismo array, nunca se escribe por delante de lo que se lee).
+        size_t fila = (size_t)y * fb->ancho;
+        int visibles = 0;
+        for (int x = x_inicio; x < x_fin; x++) {
+            int i = x - x_inicio;
+            float z = fb->span_z[i];
+            if (z >= fb->profundidad[fila + x])
+                continue;
+            fb->profundidad[fila + x] = z;
+            fb->span_x[visibles] = x;
+            fb->span_u[visibles] = fb->span_u[i];
+            fb->span_v[visibles] = fb->span_v[i];
+            visibles++;
+        }
+        if (visibles == 0)
+            continue;
+
+        // Después se muestrean todos de una vez, un nivel de mipmap por span
+        // según la derivada de u,v en su centro.
+        if (tex) {
+            int nivel = textura_nivel_span(&g, tex, 0.5f * (x_inicio + x_fin), yc);
+            muestrear_span(tex, nivel, fb->span_u, fb->span_v, visibles, fb->span_rgba);
+        }
+
+        for (int i = 0; i < visibles; i++) {
+            unsigned char* destino = &fb->rgb[(fila + fb->span_x[i]) * 3];
+            if (tex) {
+                unsigned int texel = fb->span_rgba[i];
+                destino[0] = TEXTURA_R(texel);
+                destino[1] = TEXTURA_G(texel);
+                destino[2] = TEXTURA_B(texel);
+            } else {
+                destino[0] = destino[1] = destino[2] = 255;
+            }
+        }
+        escritos += visibles;
+    }
+
+    TIMING_ETAPA(ETAPA_RASTER, marca, 1);
+    return escritos;
+}
+
+/**
+ * Limita el rasterizado a un rectángulo [x0, x1) x [y0, y1) del framebuffer.
+ * @param fb Framebuffer.
+ * @param x0, y0, x1, y1 Rectángulo de recorte, en píxeles.
+ */
+void framebuffer_recorte(Framebuffer* fb, int x0, int y0, int x1, int y1) {
+    fb->clip_x0 = x0 < 0 ? 0 : x0;
+    fb->clip_y0 = y0 < 0 ? 0 : y0;
+    fb->clip_x1 = x1 > fb->ancho ? fb->ancho : x1;
+    fb->clip_y1 = y1 > fb->alto ? fb->alto : y1;
+}
+
+/**
+ * Escribe una imagen RGB en un PPM binario (P6), con las filas de arriba
+ * a abajo. Es el formato que lee cargar_textura_ppm().
+ * @param ruta Fichero de salida.
+ * @param rgb Píxeles, 3 bytes por píxel.
+ * @param ancho, alto Dimensiones en píxeles.
+ * @return 0 si se ha escrito entero, -1 si no.
+ */
+int guardar_ppm(const char* ruta, const unsigned char* rgb, int ancho, int alto) {
+    FILE* f = fopen(ruta, "wb");
+    if (!f)
+        return -1;
+
+    size_t bytes = (size_t)ancho * alto * 3;
+    int ok = fprintf(f, "P6\n%d %d\n255\n", ancho, alto) > 0 && fwrite(rgb, 1, bytes, f) == bytes;
+    if (fclose(f) != 0)
+        ok = 0;
+    return ok ? 0 : -1;
+}
+
+/**
+ * Guarda el color del framebuffer en un PPM binario (P6).
+ * @param fb Framebuffer.
+ * @param ruta Fichero de salida.
+ * @return 0 si se ha escrito entero, -1 si no.
+ */
+int guardar_framebuffer_ppm(const Framebuffer* fb, const char* ruta) {
+    return guardar_ppm(ruta, fb->rgb, fb->ancho, fb->alto);
+}
@@ -0,0 +1,227 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                               TEXTURAS                              *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo carga las texturas PPM (P6) y las convierte, en el mismo
+ * momento de la carga, a un formato pensado para la caché:
+ *
+ * - RGBA8 empaquetado en un unsigned int por texel (el cuarto byte es
+ *   relleno), para leer un texel con una sola carga alineada.
+ * - Teselas de 4x4 texels: cada tesela son 64 bytes, una línea de caché.
+ *   Así, recorrer la textura en vertical o en diagonal (triángulos rotados)
+ *   no supone un fallo de caché por texel como con las filas RGB.
+ * - Pirámide de mipmaps completa, generada con un filtro de caja 2x2. El
+ *   nivel se elige por span a partir de la derivada en pantalla de u,v,
+ *   de forma que la geometría lejana lee niveles pequeños.
+ ***********************************************************************/
+
+/**
+ * Lee un entero de la cabecera PPM, saltándose espacios y comentarios.
+ */
+static int leer_entero_ppm(FILE* f, int* valor) {
+    int c = fgetc(f);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n')
+                c = fgetc(f);
+        } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            c = fgetc(f);
+        } else {
+            break;
+        }
+    }
+    if (c == EOF)
+        return 0;
+    ungetc(c, f);
+    return fscanf(f, "%d", valor) == 1;
+}
+
+/**
+ * Reserva un nivel de mipmap con el ancho/alto redondeados a teselas.
+ */
+static int reservar_nivel(NivelTextura* nivel, int ancho, int alto) {
+    nivel->ancho = ancho;
+    nivel->alto = alto;
+    nivel->teselas_x = (ancho + TEXTURA_TESELA - 1) / TEXTURA_TESELA;
+    nivel->teselas_y = (alto + TEXTURA_TESELA - 1) / TEXTURA_TESELA;
+    nivel->texels = (unsigned int*)calloc((size_t)nivel->teselas_x * nivel->teselas_y * TEXTURA_TESELA * TEXTURA_TESELA,
+                                          sizeof(unsigned int));
+    return nivel->texels != NULL;
+}
+
+static inline void escribir_texel(NivelTextura* nivel, int x, int y, unsigned int rgba) {
+    nivel->texels[textura_indice_texel(nivel, x, y)] = rgba;
+}
+
+/**
+ * Genera el nivel siguiente de la pirámide con un filtro de caja 2x2.
+ * En dimensiones impares el último texel se repite.
+ */
+static int generar_nivel_mip(const NivelTextura* origen, NivelTextura* destino) {
+    int ancho = origen->ancho > 1 ? origen->ancho / 2 : 1;
+    int alto = origen->alto > 1 ? origen->alto / 2 : 1;
+    if (!reservar_nivel(destino, ancho, alto))
+        return 0;
+
+    for (int y = 0; y < alto; y++) {
+        int y0 = 2 * y < origen->alto ? 2 * y : origen->alto - 1;
+        int y1 = 2 * y + 1 < origen->alto ? 2 * y + 1 : origen->alto - 1;
+        for (int x = 0; x < ancho; x++) {
+            int x0 = 2 * x < origen->ancho ? 2 * x : origen->ancho - 1;
+            int x1 = 2 * x + 1 < origen->ancho ? 2 * x + 1 : origen->ancho - 1;
+
+            unsigned int t[4] = {
+                textura_texel(origen, x0, y0), textura_texel(origen, x1, y0),
+                textura_texel(origen, x0, y1), textura_texel(origen, x1, y1)
+            };
+
+            unsigned int rgba = 0;
+            for (int canal = 0; canal < 4; canal++) {
+                int desplazamiento = canal * 8;
+                unsigned int suma = 0;
+                for (int k = 0; k < 4; k++)
+                    suma += (t[k] >> desplazamiento) & 0xFF;
+                rgba |= ((suma + 2) / 4) << desplazamiento;
+            }
+            escribir_texel(destino, x, y, rgba);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Construye una textura (teselada, RGBA8 y con mipmaps) a partir de
+ * píxeles RGB por filas.
+ * @param rgb Píxeles RGB, fila a fila.
+ * @param ancho, alto Dimensiones de la imagen.
+ * @param tex Textura resultante.
+ * @return 0 si todo fue bien, -1 si no hay memoria.
+ */
+int crear_textura_rgb(const unsigned char* rgb, int ancho, int alto, Textura* tex) {
+    memset(tex, 0, sizeof(Textura));
+
+    if (!reservar_nivel(&tex->nivel[0], ancho, alto))
+        return -1;
+
+    for (int y = 0; y < alto; y++) {
+        for (int x = 0; x < ancho; x++) {
+            const unsigned char* p = &rgb[((size_t)y * ancho + x) * 3];
+            escribir_texel(&tex->nivel[0], x, y, TEXTURA_RGBA(p[0], p[1], p[2], 255));
+        }
+    }
+    tex->niveles = 1;
+
+    // Pirámide hasta 1x1.
+    while (tex->niveles < TEXTURA_MAX_NIVELES) {
+        const NivelTextura* anterior = &tex->nivel[tex->niveles - 1];
+        if (anterior->ancho == 1 && anterior->alto == 1)
+            break;
+        if (!generar_nivel_mip(anterior, &tex->nivel[tex->niveles])) {
+            liberar_textura(tex);
+            return -1;
+        }
+        tex->niveles++;
+    }
+
+    return 0;
+}
+
+/**
+ * Carga una textura PPM binaria (P6, 8 bits por canal) y la convierte al
+ * formato teselado con mipmaps.
+ * @param ruta Fichero PPM.
+ * @param tex Textura resultante.
+ * @return 0 si todo fue bien, -1 en caso de error.
+ */
+int cargar_textura_ppm(const char* ruta, Textura* tex) {
+    FILE* f = fopen(ruta, "rb");
+    if (!f) {
+        printf("\nNo se ha podido abrir la textura %s\n", ruta);
+        return -1;
+    }
+
+    char magic[2];
+    int ancho, alto, maximo;
+    if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' || magic[1] != '6' ||
+        !leer_entero_ppm(f, &ancho) || !leer_entero_ppm(f, &alto) || !leer_entero_ppm(f, &maximo) ||
+        ancho <= 0 || alto <= 0 || maximo != 255) {
+        printf("\n%s no es un PPM P6 de 8 bits.\n", ruta);
+        fclose(f);
+        return -1;
+    }
+    fgetc(f); // Un único espacio en blanco antes de los datos
+
+    size_t bytes = (size_t)ancho * alto * 3;
+    unsigned char* rgb = (unsigned char*)malloc(bytes);
+    if (!rgb || fread(rgb, 1, bytes, f) != bytes) {
+        printf("\nLa textura %s está incompleta.\n", ruta);
+        free(rgb);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    int resultado = crear_textura_rgb(rgb, ancho, alto, tex);
+    free(rgb);
+    return resultado;
+}
+
+/**
+ * Libera todos los niveles de una textura.
+ * @param tex Textura a liberar.
+ */
+void liberar_textura(Textura* tex) {
+    for (int i = 0; i < TEXTURA_MAX_NIVELES; i++) {
+        free(tex->nivel[i].texels);
+        tex->nivel[i].texels = NULL;
+    }
+    tex->niveles = 0;
+}
+
+/**
+ * Elige el nivel de mipmap para un span a partir de las derivadas en
+ * pantalla de u y v en el píxel (x, y). u = (u/w) / (1/w), así que por la
+ * regla del cociente du/dx = (d(u/w)/dx - u * d(1/w)/dx) / (1/w).
+ * @param g Gradientes del triángulo.
+ * @param tex Textura.
+ * @param x, y Píxel de referencia (normalmente el centro del span).
+ * @return Nivel de mipmap, entre 0 y tex->niveles - 1.
+ */
+int textura_nivel_span(const GradientesTriangulo* g, const Textura* tex, float x, float y) {
+    if (tex->niveles <= 1)
+        return 0;
+
+    float dx = x - g->x0, dy = y - g->y0;
+    float iw = g->iw0 + dx * g->iw_dx + dy * g->iw_dy;
+    if (iw <= 0.0f)
+        return 0;
+
+    float w = 1.0f / iw;
+    float u = (g->uw0 + dx * g->uw_dx + dy * g->uw_dy) * w;
+    float v = (g->vw0 + dx * g->vw_dx + dy * g->vw_dy) * w;
+
+    float du_dx = (g->uw_dx - u * g->iw_dx) * w * tex->nivel[0].ancho;
+    float du_dy = (g->uw_dy - u * g->iw_dy) * w * tex->nivel[0].ancho;
+    float dv_dx = (g->vw_dx - v * g->iw_dx) * w * tex->nivel[0].alto;
+    float dv_dy = (g->vw_dy - v * g->iw_dy) * w * tex->nivel[0].alto;
+
+    // Texels por píxel en la dirección que más se estira.
+    float rho2_x = du_dx * du_dx + dv_dx * dv_dx;
+    float rho2_y = du_dy * du_dy + dv_dy * dv_dy;
+    float rho2 = rho2_x > rho2_y ? rho2_x : rho2_y;
+    if (rho2 <= 1.0f)
+        return 0;
+
+    // floor(log2(sqrt(rho2))) = floor(log2(rho2)) / 2, y floor(log2(rho2)) es
+    // el exponente del float; así no hace falta log2f() en cada span.
+    unsigned int bits;
+    memcpy(&bits, &rho2, sizeof(bits));
+    int nivel = ((int)((bits >> 23) & 0xFF) - 127) >> 1;
+    return nivel < tex->niveles ? nivel : tex->niveles - 1;
+}
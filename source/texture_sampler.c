@@ -0,0 +1,366 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MUESTREO_SSE2
+#endif
+
+/***********************************************************************
+ *                                                                     *
+ *                         MUESTREO DE TEXTURAS                        *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo muestrea una textura para todos los píxeles visibles de
+ * un span a la vez, a partir de las u,v que deja interpolar_span().
+ *
+ * El filtro bilineal escalar cuesta cuatro lecturas y una docena de
+ * multiplicaciones por píxel, así que se hace con SIMD: con SSE2 de 4 en 4
+ * píxeles y, compilando con -mavx2, de 8 en 8 con gathers. Los pesos van
+ * en punto fijo de 8 bits y los cuatro canales de un texel se filtran en
+ * enteros de 16 bits a la vez. Los píxeles sobrantes (y otras
+ * arquitecturas) usan la versión escalar, que da exactamente lo mismo.
+ *
+ * Repetición (como GL_REPEAT) o límite al borde (GL_CLAMP_TO_EDGE) según
+ * tex->repeticion, también con dimensiones que no son potencia de dos.
+ ***********************************************************************/
+
+/**
+ * Parte de la posición en el array teselado que depende sólo de x o sólo
+ * de y. El índice del texel (x, y) es indice_y + indice_x, porque los
+ * bits de tesela y los de dentro de la tesela no se solapan.
+ */
+static inline int indice_x(int x) {
+    return ((x >> 2) << 4) | (x & 3);
+}
+
+static inline int indice_y(const NivelTextura* nivel, int y) {
+    return (((y >> 2) * nivel->teselas_x) << 4) | ((y & 3) << 2);
+}
+
+/**
+ * Coordenada de textura a texels: los dos texels vecinos y la fracción
+ * (0..256) entre ellos.
+ */
+static inline void coordenada_bilineal(float t, int tamano, RepeticionTextura repeticion, int* i0, int* i1, int* frac) {
+    if (repeticion == TEXTURA_LIMITAR)
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    else
+        t -= floorf(t);
+
+    float pos = t * tamano - 0.5f;
+    float base = floorf(pos);
+    *frac = (int)((pos - base) * 256.0f);
+    *i0 = (int)base;
+    *i1 = *i0 + 1;
+
+    if (repeticion == TEXTURA_LIMITAR) {
+        if (*i0 < 0) *i0 = 0;
+        if (*i1 > tamano - 1) *i1 = tamano - 1;
+    } else {
+        if (*i0 < 0) *i0 += tamano;
+        if (*i1 >= tamano) *i1 -= tamano;
+    }
+}
+
+static unsigned int bilineal_escalar(const NivelTextura* nivel, RepeticionTextura repeticion, float u, float v) {
+    int x0, x1, fx, y0, y1, fy;
+    coordenada_bilineal(u, nivel->ancho, repeticion, &x0, &x1, &fx);
+    coordenada_bilineal(v, nivel->alto, repeticion, &y0, &y1, &fy);
+
+    // Pesos que suman exactamente 256, como en la versión SIMD.
+    int w11 = (fx * fy) >> 8;
+    int w10 = fx - w11;
+    int w01 = fy - w11;
+    int w00 = 256 - fx - fy + w11;
+
+    unsigned int t00 = nivel->texels[indice_y(nivel, y0) + indice_x(x0)];
+    unsigned int t10 = nivel->texels[indice_y(nivel, y0) + indice_x(x1)];
+    unsigned int t01 = nivel->texels[indice_y(nivel, y1) + indice_x(x0)];
+    unsigned int t11 = nivel->texels[indice_y(nivel, y1) + indice_x(x1)];
+
+    unsigned int rgba = 0;
+    for (int desplazamiento = 0; desplazamiento < 32; desplazamiento += 8) {
+        unsigned int c = ((t00 >> desplazamiento) & 0xFF) * w00 + ((t10 >> desplazamiento) & 0xFF) * w10 +
+                         ((t01 >> desplazamiento) & 0xFF) * w01 + ((t11 >> desplazamiento) & 0xFF) * w11;
+        rgba |= ((c >> 8) & 0xFF) << desplazamiento;
+    }
+    return rgba;
+}
+
+static unsigned int cercano_escalar(const NivelTextura* nivel, RepeticionTextura repeticion, float u, float v) {
+    int tx = (int)floorf(u * nivel->ancho);
+    int ty = (int)floorf(v * nivel->alto);
+    if (repeticion == TEXTURA_LIMITAR) {
+        tx = tx < 0 ? 0 : (tx >= nivel->ancho ? nivel->ancho - 1 : tx);
+        ty = ty < 0 ? 0 : (ty >= nivel->alto ? nivel->alto - 1 : ty);
+    } else {
+        tx %= nivel->ancho;
+        ty %= nivel->alto;
+        if (tx < 0) tx += nivel->ancho;
+        if (ty < 0) ty += nivel->alto;
+    }
+    return nivel->texels[indice_y(nivel, ty) + indice_x(tx)];
+}
+
+#ifdef MUESTREO_SSE2
+
+/***********************************************************************
+ * SSE2 (4 píxeles). SSE2 no tiene floor, min/max de enteros de 32 bits
+ * ni multiplicación de 32 bits, así que van aquí como funciones.
+ ***********************************************************************/
+
+static inline __m128 piso_sse2(__m128 x) {
+    __m128 truncado = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(truncado, _mm_and_ps(_mm_cmpgt_ps(truncado, x), _mm_set1_ps(1.0f)));
+}
+
+static inline __m128i elegir_sse2(__m128i mascara, __m128i si, __m128i no) {
+    return _mm_or_si128(_mm_and_si128(mascara, si), _mm_andnot_si128(mascara, no));
+}
+
+static inline __m128i mullo_sse2(__m128i a, __m128i b) {
+    __m128i pares = _mm_mul_epu32(a, b);
+    __m128i impares = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(pares, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(impares, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * Versión SIMD de coordenada_bilineal() para 4 coordenadas.
+ */
+static inline void coordenada_sse2(__m128 t, int tamano, RepeticionTextura repeticion, __m128i* i0, __m128i* i1, __m128i* frac) {
+    if (repeticion == TEXTURA_LIMITAR)
+        t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    else
+        t = _mm_sub_ps(t, piso_sse2(t));
+
+    __m128 pos = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps((float)tamano)), _mm_set1_ps(0.5f));
+    __m128 base = piso_sse2(pos);
+    *frac = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(pos, base), _mm_set1_ps(256.0f)));
+    *i0 = _mm_cvttps_epi32(base);
+    *i1 = _mm_add_epi32(*i0, _mm_set1_epi32(1));
+
+    __m128i ultimo = _mm_set1_epi32(tamano - 1);
+    if (repeticion == TEXTURA_LIMITAR) {
+        *i0 = _mm_andnot_si128(_mm_cmplt_epi32(*i0, _mm_setzero_si128()), *i0);
+        *i1 = elegir_sse2(_mm_cmpgt_epi32(*i1, ultimo), ultimo, *i1);
+    } else {
+        __m128i tam = _mm_set1_epi32(tamano);
+        *i0 = _mm_add_epi32(*i0, _mm_and_si128(_mm_cmplt_epi32(*i0, _mm_setzero_si128()), tam));
+        *i1 = _mm_sub_epi32(*i1, _mm_and_si128(_mm_cmpgt_epi32(*i1, ultimo), tam));
+    }
+}
+
+/**
+ * indice_x() e indice_y() para 4 coordenadas.
+ */
+static inline __m128i indice_x_sse2(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(x, 2), 4), _mm_and_si128(x, _mm_set1_epi32(3)));
+}
+
+static inline __m128i indice_y_sse2(__m128i y, __m128i teselas_x) {
+    __m128i tesela = mullo_sse2(_mm_srli_epi32(y, 2), teselas_x);
+    return _mm_or_si128(_mm_slli_epi32(tesela, 4), _mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(3)), 2));
+}
+
+/**
+ * Reparte el peso de cada píxel (un entero de 32 bits por píxel) a sus
+ * cuatro canales en enteros de 16 bits: bajo = píxeles 0 y 1, alto = 2 y 3.
+ */
+static inline void pesos_canales_sse2(__m128i peso, __m128i* bajo, __m128i* alto) {
+    __m128i p16 = _mm_packs_epi32(peso, peso);
+    __m128i duplicado = _mm_unpacklo_epi16(p16, p16);
+    *bajo = _mm_unpacklo_epi32(duplicado, duplicado);
+    *alto = _mm_unpackhi_epi32(duplicado, duplicado);
+}
+
+static inline __m128i cargar_texels_sse2(const unsigned int* texels, __m128i indices) {
+    int i[4];
+    _mm_storeu_si128((__m128i*)i, indices);
+    return _mm_set_epi32((int)texels[i[3]], (int)texels[i[2]], (int)texels[i[1]], (int)texels[i[0]]);
+}
+
+/**
+ * Suma c * w de los cuatro texels, canal a canal, y divide entre 256.
+ */
+static inline __m128i filtrar_sse2(__m128i t00, __m128i t10, __m128i t01, __m128i t11,
+                                   __m128i w00, __m128i w10, __m128i w01, __m128i w11) {
+    __m128i cero = _mm_setzero_si128();
+    __m128i w00b, w00a, w10b, w10a, w01b, w01a, w11b, w11a;
+    pesos_canales_sse2(w00, &w00b, &w00a);
+    pesos_canales_sse2(w10, &w10b, &w10a);
+    pesos_canales_sse2(w01, &w01b, &w01a);
+    pesos_canales_sse2(w11, &w11b, &w11a);
+
+    // Como los pesos suman 256, la suma cabe en 16 bits sin signo.
+    __m128i bajo = _mm_mullo_epi16(_mm_unpacklo_epi8(t00, cero), w00b);
+    bajo = _mm_add_epi16(bajo, _mm_mullo_epi16(_mm_unpacklo_epi8(t10, cero), w10b));
+    bajo = _mm_add_epi16(bajo, _mm_mullo_epi16(_mm_unpacklo_epi8(t01, cero), w01b));
+    bajo = _mm_add_epi16(bajo, _mm_mullo_epi16(_mm_unpacklo_epi8(t11, cero), w11b));
+
+    __m128i alto = _mm_mullo_epi16(_mm_unpackhi_epi8(t00, cero), w00a);
+    alto = _mm_add_epi16(alto, _mm_mullo_epi16(_mm_unpackhi_epi8(t10, cero), w10a));
+    alto = _mm_add_epi16(alto, _mm_mullo_epi16(_mm_unpackhi_epi8(t01, cero), w01a));
+    alto = _mm_add_epi16(alto, _mm_mullo_epi16(_mm_unpackhi_epi8(t11, cero), w11a));
+
+    return _mm_packus_epi16(_mm_srli_epi16(bajo, 8), _mm_srli_epi16(alto, 8));
+}
+
+/**
+ * Pesos de los cuatro vecinos a partir de las fracciones en x e y.
+ */
+static inline void pesos_sse2(__m128i fx, __m128i fy, __m128i* w00, __m128i* w10, __m128i* w01, __m128i* w11) {
+    // fx, fy < 256, así que el producto cabe en los 16 bits bajos.
+    *w11 = _mm_srli_epi32(_mm_mullo_epi16(fx, fy), 8);
+    *w10 = _mm_sub_epi32(fx, *w11);
+    *w01 = _mm_sub_epi32(fy, *w11);
+    *w00 = _mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(_mm_set1_epi32(256), fx), fy), *w11);
+}
+
+static int bilineal_sse2(const NivelTextura* nivel, RepeticionTextura repeticion,
+                         const float* u, const float* v, int n, unsigned int* rgba) {
+    __m128i teselas_x = _mm_set1_epi32(nivel->teselas_x);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x0, x1, fx, y0, y1, fy;
+        coordenada_sse2(_mm_loadu_ps(&u[i]), nivel->ancho, repeticion, &x0, &x1, &fx);
+        coordenada_sse2(_mm_loadu_ps(&v[i]), nivel->alto, repeticion, &y0, &y1, &fy);
+
+        __m128i cx0 = indice_x_sse2(x0), cx1 = indice_x_sse2(x1);
+        __m128i fy0 = indice_y_sse2(y0, teselas_x), fy1 = indice_y_sse2(y1, teselas_x);
+
+        __m128i t00 = cargar_texels_sse2(nivel->texels, _mm_add_epi32(fy0, cx0));
+        __m128i t10 = cargar_texels_sse2(nivel->texels, _mm_add_epi32(fy0, cx1));
+        __m128i t01 = cargar_texels_sse2(nivel->texels, _mm_add_epi32(fy1, cx0));
+        __m128i t11 = cargar_texels_sse2(nivel->texels, _mm_add_epi32(fy1, cx1));
+
+        __m128i w00, w10, w01, w11;
+        pesos_sse2(fx, fy, &w00, &w10, &w01, &w11);
+        _mm_storeu_si128((__m128i*)&rgba[i], filtrar_sse2(t00, t10, t01, t11, w00, w10, w01, w11));
+    }
+    return i;
+}
+
+#ifdef __AVX2__
+
+/***********************************************************************
+ * AVX2 (8 píxeles). Los unpack de AVX2 trabajan por mitades de 128 bits,
+ * así que el reparto de pesos sigue el mismo orden que los texels.
+ ***********************************************************************/
+
+static inline void coordenada_avx2(__m256 t, int tamano, RepeticionTextura repeticion, __m256i* i0, __m256i* i1, __m256i* frac) {
+    if (repeticion == TEXTURA_LIMITAR)
+        t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    else
+        t = _mm256_sub_ps(t, _mm256_floor_ps(t));
+
+    __m256 pos = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps((float)tamano)), _mm256_set1_ps(0.5f));
+    __m256 base = _mm256_floor_ps(pos);
+    *frac = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_sub_ps(pos, base), _mm256_set1_ps(256.0f)));
+    *i0 = _mm256_cvttps_epi32(base);
+    *i1 = _mm256_add_epi32(*i0, _mm256_set1_epi32(1));
+
+    __m256i ultimo = _mm256_set1_epi32(tamano - 1);
+    if (repeticion == TEXTURA_LIMITAR) {
+        *i0 = _mm256_max_epi32(*i0, _mm256_setzero_si256());
+        *i1 = _mm256_min_epi32(*i1, ultimo);
+    } else {
+        __m256i tam = _mm256_set1_epi32(tamano);
+        *i0 = _mm256_add_epi32(*i0, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), *i0), tam));
+        *i1 = _mm256_sub_epi32(*i1, _mm256_and_si256(_mm256_cmpgt_epi32(*i1, ultimo), tam));
+    }
+}
+
+static inline __m256i indice_x_avx2(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi32(_mm256_srli_epi32(x, 2), 4), _mm256_and_si256(x, _mm256_set1_epi32(3)));
+}
+
+static inline __m256i indice_y_avx2(__m256i y, __m256i teselas_x) {
+    __m256i tesela = _mm256_mullo_epi32(_mm256_srli_epi32(y, 2), teselas_x);
+    return _mm256_or_si256(_mm256_slli_epi32(tesela, 4), _mm256_slli_epi32(_mm256_and_si256(y, _mm256_set1_epi32(3)), 2));
+}
+
+static inline void pesos_canales_avx2(__m256i peso, __m256i* bajo, __m256i* alto) {
+    __m256i p16 = _mm256_packs_epi32(peso, peso);
+    __m256i duplicado = _mm256_unpacklo_epi16(p16, p16);
+    *bajo = _mm256_unpacklo_epi32(duplicado, duplicado);
+    *alto = _mm256_unpackhi_epi32(duplicado, duplicado);
+}
+
+static int bilineal_avx2(const NivelTextura* nivel, RepeticionTextura repeticion,
+                         const float* u, const float* v, int n, unsigned int* rgba) {
+    const int* texels = (const int*)nivel->texels;
+    __m256i teselas_x = _mm256_set1_epi32(nivel->teselas_x);
+    __m256i cero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x0, x1, fx, y0, y1, fy;
+        coordenada_avx2(_mm256_loadu_ps(&u[i]), nivel->ancho, repeticion, &x0, &x1, &fx);
+        coordenada_avx2(_mm256_loadu_ps(&v[i]), nivel->alto, repeticion, &y0, &y1, &fy);
+
+        __m256i cx0 = indice_x_avx2(x0), cx1 = indice_x_avx2(x1);
+        __m256i fy0 = indice_y_avx2(y0, teselas_x), fy1 = indice_y_avx2(y1, teselas_x);
+
+        __m256i t[4] = {
+            _mm256_i32gather_epi32(texels, _mm256_add_epi32(fy0, cx0), 4),
+            _mm256_i32gather_epi32(texels, _mm256_add_epi32(fy0, cx1), 4),
+            _mm256_i32gather_epi32(texels, _mm256_add_epi32(fy1, cx0), 4),
+            _mm256_i32gather_epi32(texels, _mm256_add_epi32(fy1, cx1), 4),
+        };
+
+        __m256i w[4];
+        w[3] = _mm256_srli_epi32(_mm256_mullo_epi32(fx, fy), 8);
+        w[1] = _mm256_sub_epi32(fx, w[3]);
+        w[2] = _mm256_sub_epi32(fy, w[3]);
+        w[0] = _mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(_mm256_set1_epi32(256), fx), fy), w[3]);
+
+        __m256i bajo = _mm256_setzero_si256(), alto = _mm256_setzero_si256();
+        for (int k = 0; k < 4; k++) {
+            __m256i wb, wa;
+            pesos_canales_avx2(w[k], &wb, &wa);
+            bajo = _mm256_add_epi16(bajo, _mm256_mullo_epi16(_mm256_unpacklo_epi8(t[k], cero), wb));
+            alto = _mm256_add_epi16(alto, _mm256_mullo_epi16(_mm256_unpackhi_epi8(t[k], cero), wa));
+        }
+
+        __m256i resultado = _mm256_packus_epi16(_mm256_srli_epi16(bajo, 8), _mm256_srli_epi16(alto, 8));
+        _mm256_storeu_si256((__m256i*)&rgba[i], resultado);
+    }
+    return i;
+}
+
+#endif // __AVX2__
+#endif // MUESTREO_SSE2
+
+/**
+ * Muestrea la textura para n píxeles, con el filtro y la repetición de la
+ * textura.
+ * @param tex Textura.
+ * @param nivel Nivel de mipmap (ver textura_nivel_span()).
+ * @param u, v Coordenadas de textura de cada píxel.
+ * @param n Número de píxeles.
+ * @param rgba Color resultante de cada píxel.
+ */
+void muestrear_span(const Textura* tex, int nivel, const float* u, const float* v, int n, unsigned int* rgba) {
+    const NivelTextura* nt = &tex->nivel[nivel];
+    int i = 0;
+
+    if (tex->filtro == TEXTURA_CERCANO) {
+        for (; i < n; i++)
+            rgba[i] = cercano_escalar(nt, tex->repeticion, u[i], v[i]);
+        return;
+    }
+
+#ifdef MUESTREO_SSE2
+#ifdef __AVX2__
+    i = bilineal_avx2(nt, tex->repeticion, u, v, n, rgba);
+#endif
+    i += bilineal_sse2(nt, tex->repeticion, u + i, v + i, n - i, rgba + i);
+#endif
+
+    // Los que no llenan un registro.
+    for (; i < n; i++)
+        rgba[i] = bilineal_escalar(nt, tex->repeticion, u[i], v[i]);
+}
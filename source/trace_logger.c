@@ -0,0 +1,294 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_USAR_TSC
+#endif
+
+/***********************************************************************
+ *                                                                     *
+ *                          TRAZAS ASÍNCRONAS                          *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo implementa un registro de trazas asíncrono, pensado para
+ * poder tener diagnósticos activos sin destrozar los tiempos de frame.
+ *
+ * Cada hilo que emite eventos tiene su propio buffer circular (un solo
+ * productor, un solo consumidor, sin locks). El hilo que renderiza se
+ * limita a copiar un evento binario de tamaño fijo con una marca de
+ * tiempo (TSC en x86, reloj monotónico en el resto). Un hilo de fondo
+ * recorre los buffers, formatea los eventos como texto y, si se pide,
+ * los exporta en el formato JSON de Chrome trace (chrome://tracing o
+ * Perfetto).
+ ***********************************************************************/
+
+// Capacidad de cada buffer por hilo, potencia de 2.
+#define TRACE_CAPACIDAD (1 << 14)
+#define TRACE_MASCARA (TRACE_CAPACIDAD - 1)
+
+typedef struct TraceBuffer {
+    TraceEvento eventos[TRACE_CAPACIDAD];
+    // Cabeza y cola en líneas de caché distintas, para que productor y
+    // consumidor no se peleen por la misma línea.
+    _Alignas(64) _Atomic size_t cabeza;  // Escribe el productor
+    size_t cola_vista;                    // Copia local de la cola, sólo la lee el productor
+    _Alignas(64) _Atomic size_t cola;    // Escribe el consumidor
+    _Atomic unsigned long long perdidos;
+    unsigned int hilo;
+    struct TraceBuffer* siguiente;
+} TraceBuffer;
+
+static _Atomic(TraceBuffer*) lista_buffers = NULL;
+static _Atomic unsigned int siguiente_hilo = 1;
+static _Thread_local TraceBuffer* buffer_hilo = NULL;
+
+_Atomic int trace_activo_flag = 0;
+
+static pthread_t hilo_consumidor;
+static _Atomic int consumidor_en_marcha = 0;
+static FILE* salida_texto = NULL;
+static FILE* salida_json = NULL;
+static int primer_evento_json = 1;
+
+// Calibración de ticks a nanosegundos.
+static unsigned long long tick_origen = 0;
+static double ns_por_tick = 1.0;
+
+static unsigned long long leer_reloj_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * Marca de tiempo del evento. En x86 es el contador TSC (unos pocos ciclos);
+ * el hilo consumidor lo traduce a nanosegundos con la calibración.
+ * @return Ticks desde un origen arbitrario.
+ */
+static inline unsigned long long trace_ticks(void) {
+#ifdef TRACE_USAR_TSC
+    return __rdtsc();
+#else
+    return leer_reloj_ns();
+#endif
+}
+
+static void calibrar_reloj(void) {
+#ifdef TRACE_USAR_TSC
+    unsigned long long ns0 = leer_reloj_ns();
+    unsigned long long t0 = __rdtsc();
+    struct timespec espera = {0, 20 * 1000000L};
+    nanosleep(&espera, NULL);
+    unsigned long long ns1 = leer_reloj_ns();
+    unsigned long long t1 = __rdtsc();
+    ns_por_tick = (t1 > t0) ? (double)(ns1 - ns0) / (double)(t1 - t0) : 1.0;
+#else
+    ns_por_tick = 1.0;
+#endif
+    tick_origen = trace_ticks();
+}
+
+/**
+ * Crea el buffer del hilo actual y lo engancha a la lista global. Sólo
+ * ocurre la primera vez que un hilo emite un evento.
+ */
+static TraceBuffer* registrar_hilo(void) {
+    TraceBuffer* buffer = (TraceBuffer*)aligned_alloc(64, sizeof(TraceBuffer));
+    if (!buffer)
+        return NULL;
+    memset(buffer, 0, sizeof(TraceBuffer));
+
+    buffer->hilo = atomic_fetch_add(&siguiente_hilo, 1);
+
+    // Inserción en cabeza con CAS, la lista nunca pierde nodos mientras se traza.
+    TraceBuffer* cabeza = atomic_load(&lista_buffers);
+    do {
+        buffer->siguiente = cabeza;
+    } while (!atomic_compare_exchange_weak(&lista_buffers, &cabeza, buffer));
+
+    buffer_hilo = buffer;
+    return buffer;
+}
+
+/**
+ * Emite un evento. Es lo único que paga el hilo emisor: copiar 64 bytes
+ * en su buffer y publicar la nueva cabeza. Si el buffer está lleno el
+ * evento se descarta y se cuenta como perdido, nunca se bloquea.
+ * @param fase Tipo de evento (TRACE_FASE_*).
+ * @param nombre Cadena estática que identifica el evento.
+ * @param num_valores Número de valores válidos en valores (máximo TRACE_MAX_VALORES).
+ * @param valores Valores numéricos asociados.
+ */
+void trace_emitir(char fase, const char* nombre, int num_valores, const double* valores) {
+    TraceBuffer* buffer = buffer_hilo;
+    if (!buffer && !(buffer = registrar_hilo()))
+        return;
+
+    size_t cabeza = atomic_load_explicit(&buffer->cabeza, memory_order_relaxed);
+    // Sólo se relee la cola compartida cuando el buffer parece lleno.
+    if (cabeza - buffer->cola_vista >= TRACE_CAPACIDAD) {
+        buffer->cola_vista = atomic_load_explicit(&buffer->cola, memory_order_acquire);
+        if (cabeza - buffer->cola_vista >= TRACE_CAPACIDAD) {
+            atomic_fetch_add_explicit(&buffer->perdidos, 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    TraceEvento* evento = &buffer->eventos[cabeza & TRACE_MASCARA];
+    evento->ticks = trace_ticks();
+    evento->nombre = nombre;
+    evento->fase = fase;
+    evento->num_valores = (unsigned char)(num_valores > TRACE_MAX_VALORES ? TRACE_MAX_VALORES : num_valores);
+    for (int i = 0; i < evento->num_valores; i++)
+        evento->valores[i] = valores[i];
+
+    atomic_store_explicit(&buffer->cabeza, cabeza + 1, memory_order_release);
+}
+
+/**
+ * Formatea un evento en las salidas configuradas (texto y/o JSON).
+ */
+static void formatear_evento(const TraceEvento* evento, unsigned int hilo) {
+    double ns = (double)(evento->ticks - tick_origen) * ns_por_tick;
+
+    if (salida_texto) {
+        fprintf(salida_texto, "[%12.3f us] hilo %u %c %s", ns / 1000.0, hilo, evento->fase, evento->nombre);
+        for (int i = 0; i < evento->num_valores; i++)
+            fprintf(salida_texto, " %.4f", evento->valores[i]);
+        fputc('\n', salida_texto);
+    }
+
+    if (salida_json) {
+        fprintf(salida_json, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                primer_evento_json ? "" : ",", evento->nombre, evento->fase, ns / 1000.0, hilo);
+        primer_evento_json = 0;
+
+        if (evento->fase == TRACE_FASE_INSTANTE)
+            fprintf(salida_json, ",\"s\":\"t\"");
+
+        if (evento->num_valores > 0) {
+            fprintf(salida_json, ",\"args\":{");
+            for (int i = 0; i < evento->num_valores; i++)
+                fprintf(salida_json, "%s\"v%d\":%.6g", i ? "," : "", i, evento->valores[i]);
+            fputc('}', salida_json);
+        }
+        fputc('}', salida_json);
+    }
+}
+
+/**
+ * Vacía todos los buffers registrados.
+ * @return Número de eventos procesados.
+ */
+static size_t drenar_buffers(void) {
+    size_t procesados = 0;
+
+    for (TraceBuffer* buffer = atomic_load(&lista_buffers); buffer; buffer = buffer->siguiente) {
+        size_t cola = atomic_load_explicit(&buffer->cola, memory_order_relaxed);
+        size_t cabeza = atomic_load_explicit(&buffer->cabeza, memory_order_acquire);
+
+        while (cola != cabeza) {
+            formatear_evento(&buffer->eventos[cola & TRACE_MASCARA], buffer->hilo);
+            cola++;
+            procesados++;
+        }
+        atomic_store_explicit(&buffer->cola, cola, memory_order_release);
+    }
+
+    return procesados;
+}
+
+/**
+ * Bucle del hilo de fondo: drena los buffers por lotes, durmiendo entre
+ * pasadas. Drenar en continuo haría que las líneas de caché de los eventos
+ * recién escritos rebotasen entre núcleos y lo pagaría el hilo de render.
+ */
+static void* bucle_consumidor(void* arg) {
+    (void)arg;
+    struct timespec espera = {0, 1000000L}; // 1 ms
+
+    while (atomic_load(&consumidor_en_marcha)) {
+        drenar_buffers();
+        nanosleep(&espera, NULL);
+    }
+
+    // Última pasada, para no perder lo emitido justo antes de parar.
+    drenar_buffers();
+    return NULL;
+}
+
+/**
+ * Arranca el registro de trazas y su hilo de fondo.
+ * @param texto Salida para el volcado en texto (p.ej. stdout), o NULL.
+ * @param ruta_json Ruta del fichero Chrome trace a generar, o NULL.
+ * @return 0 si todo fue bien, -1 en caso de error.
+ */
+int trace_iniciar(FILE* texto, const char* ruta_json) {
+    if (atomic_load(&consumidor_en_marcha))
+        return 0;
+
+    salida_texto = texto;
+    salida_json = NULL;
+    if (ruta_json) {
+        salida_json = fopen(ruta_json, "w");
+        if (!salida_json) {
+            printf("\nNo se ha podido abrir %s para las trazas.\n", ruta_json);
+            return -1;
+        }
+        fprintf(salida_json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        primer_evento_json = 1;
+    }
+
+    calibrar_reloj();
+
+    atomic_store(&consumidor_en_marcha, 1);
+    if (pthread_create(&hilo_consumidor, NULL, bucle_consumidor, NULL) != 0) {
+        atomic_store(&consumidor_en_marcha, 0);
+        if (salida_json)
+            fclose(salida_json);
+        salida_json = NULL;
+        return -1;
+    }
+
+    atomic_store(&trace_activo_flag, 1);
+    return 0;
+}
+
+/**
+ * Detiene el registro: deja de aceptar eventos, espera a que el hilo de
+ * fondo vacíe los buffers y cierra el JSON.
+ */
+void trace_detener(void) {
+    if (!atomic_load(&consumidor_en_marcha))
+        return;
+
+    atomic_store(&trace_activo_flag, 0);
+    atomic_store(&consumidor_en_marcha, 0);
+    pthread_join(hilo_consumidor, NULL);
+
+    if (salida_json) {
+        fprintf(salida_json, "\n]}\n");
+        fclose(salida_json);
+        salida_json = NULL;
+    }
+    if (salida_texto)
+        fflush(salida_texto);
+}
+
+/**
+ * Suma los eventos descartados por buffers llenos en todos los hilos.
+ * @return Número de eventos perdidos.
+ */
+unsigned long long trace_eventos_perdidos(void) {
+    unsigned long long total = 0;
+    for (TraceBuffer* buffer = atomic_load(&lista_buffers); buffer; buffer = buffer->siguiente)
+        total += atomic_load(&buffer->perdidos);
+    return total;
+}
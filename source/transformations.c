@@ -12,6 +12,10 @@
  * y cámaras. Incluye rotaciones, traslaciones
  * y escalados, aplicables tanto a objetos individuales como a la cámara,
  * en sus diferentes modos (análisis, vuelo...) y ejes.
+ *
+ * Las funciones públicas de interacción graban la llamada (si hay una
+ * grabación de sesión en curso) y delegan en su versión aplicar_*, que
+ * es la que se usa internamente, para no grabar las llamadas anidadas.
  ***********************************************************************/
 
 /**
@@ -71,7 +75,7 @@ void set_rotation_matrix(char eje, float theta, double matriz_rotacion[4][4]) {
  * @param scene_status_mask Máscara de estado de la escena.
  * @param sel_ptr Puntero al objeto seleccionado para la rotación.
  */
-void rotate(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr) {
+static void aplicar_rotacion(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr) {
     float angulo = scene_status_mask & MODO_CAMARA ? ROTACION_ANGULO_CAMARA : ROTACION_ANGULO;
     float theta = angulo * (PI / 180.0) * dir; // Rotación de 2 grados
 
@@ -125,6 +129,11 @@ void rotate(char eje, int dir, Camera* camera, unsigned int scene_status_mask, t
     update_camera_vectors_from_view_matrix(camera);
 }
 
+void rotate(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr) {
+    GRABAR_ENTRADA(ENTRADA_ROTATE, eje, dir, scene_status_mask, sel_ptr);
+    aplicar_rotacion(eje, dir, camera, scene_status_mask, sel_ptr);
+}
+
 /**
  * Aplica una traslación local a un objeto o cámara, moviéndolos en el
  * espacio según un eje y dirección dados.
@@ -134,7 +143,7 @@ void rotate(char eje, int dir, Camera* camera, unsigned int scene_status_mask, t
  * @param scene_status_mask Máscara de estado de la escena.
  * @param sel_ptr Puntero al objeto seleccionado para la traslación.
  */
-void traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr){
+static void aplicar_traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr){
     Vector3Index vector_eje;
 
     // Verificar primero si el modo cámara está activo
@@ -191,14 +200,14 @@ void traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_stat
                 if(!(scene_status_mask & EJE_LOCAL)){
                     scene_status_mask |= EJE_LOCAL;
                 }
-                rotate('y', dir, camera, scene_status_mask, sel_ptr);
+                aplicar_rotacion('y', dir, camera, scene_status_mask, sel_ptr);
                 break;
             case 'y':
             case 'Y': // Pitch
                 if(!(scene_status_mask & EJE_LOCAL)){
                     scene_status_mask |= EJE_LOCAL;
                 }
-                rotate('x', dir, camera, scene_status_mask, sel_ptr);
+                aplicar_rotacion('x', dir, camera, scene_status_mask, sel_ptr);
                 break;
             case 'z':
             case 'Z':
@@ -225,6 +234,11 @@ void traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_stat
     }
 }
 
+void traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr){
+    GRABAR_ENTRADA(ENTRADA_TRASLACION_LOCAL, eje, dir, scene_status_mask, sel_ptr);
+    aplicar_traslacion_local(eje, dir, camera, scene_status_mask, sel_ptr);
+}
+
 /**
  * Cámara en modo análisis. Realiza una traslación en "órbita" alrededor
  * de un objeto seleccionado.
@@ -233,7 +247,7 @@ void traslacion_local(char eje, int dir, Camera* camera, unsigned int scene_stat
  * @param camera Puntero a la cámara.
  * @param sel_ptr Puntero al objeto alrededor del cual se orbita.
  */
-void traslacion_orbita(char eje, int dir, Camera* camera, triobj* sel_ptr){
+static void aplicar_traslacion_orbita(char eje, int dir, Camera* camera, triobj* sel_ptr){
     // 1) Restar vector vector posicon camara - centro_objeto (al revés, en OpenGL)
     // 2) Trasladar con esa diferencia
     // 3) Rotar como se desee, en base al eje
@@ -295,6 +309,11 @@ void traslacion_orbita(char eje, int dir, Camera* camera, triobj* sel_ptr){
     update_camera_vectors(camera, obj_position_vector);
 }
 
+void traslacion_orbita(char eje, int dir, Camera* camera, triobj* sel_ptr){
+    GRABAR_ENTRADA(ENTRADA_TRASLACION_ORBITA, eje, dir, 0, sel_ptr);
+    aplicar_traslacion_orbita(eje, dir, camera, sel_ptr);
+}
+
 
 /**
  * Realiza una transformación general (traslación, rotación, escalado) sobre
@@ -324,6 +343,7 @@ void traslacion_orbita(char eje, int dir, Camera* camera, triobj* sel_ptr){
  * @param sel_ptr Puntero al objeto seleccionado para transformar.
  */
 void transformar(char eje, int dir, Camera* camera, unsigned int scene_status_mask, triobj* sel_ptr) {
+    GRABAR_ENTRADA(ENTRADA_TRANSFORMAR, eje, dir, scene_status_mask, sel_ptr);
 
     if (gestionar_nueva_matriz(sel_ptr)!= NULL) {
         // Determinar la dirección basada en el eje actual
@@ -349,12 +369,12 @@ void transformar(char eje, int dir, Camera* camera, unsigned int scene_status_ma
 
         if (scene_status_mask & MODO_TRASLACION) {
             if(scene_status_mask & EJE_LOCAL)
-                traslacion_local(eje, dir, camera, scene_status_mask, sel_ptr);
+                aplicar_traslacion_local(eje, dir, camera, scene_status_mask, sel_ptr);
             else if(scene_status_mask & CAMARA_ANALISIS)
                 if(eje != 'z')
-                    traslacion_orbita(eje, dir, camera, sel_ptr);
+                    aplicar_traslacion_orbita(eje, dir, camera, sel_ptr);
                 else
-                    traslacion_local(eje, dir, camera, scene_status_mask, sel_ptr);
+                    aplicar_traslacion_local(eje, dir, camera, scene_status_mask, sel_ptr);
             else
             {
                 if(scene_status_mask & MODO_CAMARA)
@@ -371,7 +391,7 @@ void transformar(char eje, int dir, Camera* camera, unsigned int scene_status_ma
             }
         }
         else if (scene_status_mask & MODO_ROTACION) {
-            rotate(eje, dir, camera, scene_status_mask, sel_ptr);
+            aplicar_rotacion(eje, dir, camera, scene_status_mask, sel_ptr);
         }
         else if (scene_status_mask & MODO_ESCALADO) {
             for (int i = 0; i < 16; i++) {
@@ -0,0 +1,264 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                          NORMALES DE VÉRTICE                        *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * Este archivo calcula normales suavizadas por vértice para el sombreado
+ * Gouraud, una sola vez al cargar la malla, en lugar de recalcularlas en
+ * cada frame con obtain_normal_vector() sobre todos los triángulos
+ * vecinos.
+ *
+ * Los triángulos llegan sueltos (cada uno con sus tres puntos), así que
+ * primero se sueldan los vértices que coinciden en posición, con una
+ * tolerancia relativa al tamaño del objeto para que costuras como la de
+ * la esfera (sin(0) frente a sin(2*PI)) cuenten como el mismo vértice.
+ *
+ * La normal de cada esquina es la suma de las normales de las caras que
+ * comparten el vértice, ponderadas por área (el producto vectorial sin
+ * normalizar ya lo está), pero sólo de las caras que no forman con la
+ * propia más del ángulo de pliegue. Así las aristas vivas (la tapa de un
+ * cilindro) siguen siendo vivas.
+ *
+ * Los índices de la soldadura se quedan en el objeto (obj->indices): es
+ * el índice de vértices de la malla, que los triángulos sueltos no traen.
+ *
+ * Las normales en espacio mundo se guardan en el objeto y sólo se
+ * recalculan cuando cambia su matriz, con la inversa traspuesta para que
+ * los escalados no uniformes no las tuerzan.
+ ***********************************************************************/
+
+typedef struct {
+    long long x, y, z;
+    int vertice;   // -1 si la celda está libre
+} CeldaSoldadura;
+
+static unsigned long long hash_posicion(long long x, long long y, long long z) {
+    unsigned long long h = (unsigned long long)x * 0x9E3779B97F4A7C15ULL;
+    h ^= (unsigned long long)y * 0xC2B2AE3D27D4EB4FULL;
+    h ^= (unsigned long long)z * 0x165667B19E3779F9ULL;
+    return h ^ (h >> 29);
+}
+
+/**
+ * Suelda las esquinas de los triángulos por posición.
+ * @param obj Objeto.
+ * @param vertice Salida: índice de vértice soldado de cada esquina.
+ * @return Número de vértices distintos, o -1 si no hay memoria.
+ */
+static int soldar_vertices(const triobj* obj, int* vertice) {
+    long esquinas = 3L * obj->num_triangles;
+
+    float min[3] = {INFINITY, INFINITY, INFINITY}, max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (long c = 0; c < esquinas; c++) {
+        const Punto* p = &(&obj->triptr[c / 3].p1)[c % 3];
+        float v[3] = {p->x, p->y, p->z};
+        for (int k = 0; k < 3; k++) {
+            if (v[k] < min[k]) min[k] = v[k];
+            if (v[k] > max[k]) max[k] = v[k];
+        }
+    }
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    float diagonal = sqrtf(dx * dx + dy * dy + dz * dz);
+    float inv_tolerancia = diagonal > 0.0f ? 1.0f / (diagonal * 1e-5f) : 1.0f;
+
+    long capacidad = 1;
+    while (capacidad < 2 * esquinas)
+        capacidad <<= 1;
+    CeldaSoldadura* tabla = (CeldaSoldadura*)malloc(sizeof(CeldaSoldadura) * capacidad);
+    if (!tabla)
+        return -1;
+    for (long i = 0; i < capacidad; i++)
+        tabla[i].vertice = -1;
+
+    int num_vertices = 0;
+    for (long c = 0; c < esquinas; c++) {
+        const Punto* p = &(&obj->triptr[c / 3].p1)[c % 3];
+        long long qx = llroundf(p->x * inv_tolerancia);
+        long long qy = llroundf(p->y * inv_tolerancia);
+        long long qz = llroundf(p->z * inv_tolerancia);
+
+        long i = (long)(hash_posicion(qx, qy, qz) & (unsigned long long)(capacidad - 1));
+        while (tabla[i].vertice >= 0 && !(tabla[i].x == qx && tabla[i].y == qy && tabla[i].z == qz))
+            i = (i + 1) & (capacidad - 1);
+
+        if (tabla[i].vertice < 0) {
+            tabla[i].x = qx;
+            tabla[i].y = qy;
+            tabla[i].z = qz;
+            tabla[i].vertice = num_vertices++;
+        }
+        vertice[c] = tabla[i].vertice;
+    }
+
+    free(tabla);
+    return num_vertices;
+}
+
+/**
+ * Calcula las normales suavizadas de un objeto y las guarda en
+ * obj->normales (3 por triángulo, en el orden de triptr), junto con el
+ * índice de vértices soldados en obj->indices.
+ * @param obj Objeto.
+ * @param angulo_pliegue Ángulo (grados) a partir del cual dos caras no se suavizan entre sí.
+ * @return 0 si todo fue bien, -1 si no hay memoria o el objeto está
+ *         comprimido (ya lleva sus normales codificadas).
+ */
+int calcular_normales_vertice(triobj* obj, float angulo_pliegue) {
+    if (!obj->triptr)
+        return -1;
+
+    long esquinas = 3L * obj->num_triangles;
+    float cos_pliegue = cosf(angulo_pliegue * PI / 180.0f);
+
+    // Todo se reserva de una vez; hay como mucho tantos vértices como esquinas.
+    size_t n = esquinas > 0 ? (size_t)esquinas : 1;
+    Vector3* normales = (Vector3*)malloc(sizeof(Vector3) * n);
+    Vector3* cara = (Vector3*)malloc(sizeof(Vector3) * n);
+    Vector3* cara_unitaria = (Vector3*)malloc(sizeof(Vector3) * n);
+    int* vertice = (int*)malloc(sizeof(int) * n);
+    int* esquinas_vertice = (int*)malloc(sizeof(int) * n);
+    int* relleno = (int*)malloc(sizeof(int) * n);
+    int* inicio = (int*)calloc(n + 1, sizeof(int));
+
+    int num_vertices = -1;
+    if (normales && cara && cara_unitaria && vertice && esquinas_vertice && relleno && inicio)
+        num_vertices = soldar_vertices(obj, vertice);
+
+    if (num_vertices < 0) {
+        free(normales);
+        free(cara);
+        free(cara_unitaria);
+        free(vertice);
+        free(esquinas_vertice);
+        free(relleno);
+        free(inicio);
+        return -1;
+    }
+
+    // Normal de cada cara, como en obtain_normal_vector(): sin normalizar
+    // (pesa por área) y normalizada (para comparar con el pliegue).
+    for (int t = 0; t < obj->num_triangles; t++) {
+        const Triangulo* tri = &obj->triptr[t];
+        Vector3 a = vector3(tri->p2.x - tri->p1.x, tri->p2.y - tri->p1.y, tri->p2.z - tri->p1.z);
+        Vector3 b = vector3(tri->p3.x - tri->p1.x, tri->p3.y - tri->p1.y, tri->p3.z - tri->p1.z);
+        cara[t] = vector3_cross_product(a, b);
+        float longitud = sqrtf(cara[t].x * cara[t].x + cara[t].y * cara[t].y + cara[t].z * cara[t].z);
+        float inv = longitud > 0.0f ? 1.0f / longitud : 0.0f;
+        cara_unitaria[t] = vector3(cara[t].x * inv, cara[t].y * inv, cara[t].z * inv);
+    }
+
+    // Lista de esquinas de cada vértice soldado (CSR).
+    for (long c = 0; c < esquinas; c++)
+        inicio[vertice[c] + 1]++;
+    for (int v = 0; v < num_vertices; v++)
+        inicio[v + 1] += inicio[v];
+    memcpy(relleno, inicio, sizeof(int) * num_vertices);
+    for (long c = 0; c < esquinas; c++)
+        esquinas_vertice[relleno[vertice[c]]++] = (int)c;
+
+    for (long c = 0; c < esquinas; c++) {
+        int t = (int)(c / 3);
+        int v = vertice[c];
+        Vector3 suma = {0.0f, 0.0f, 0.0f};
+
+        for (int k = inicio[v]; k < inicio[v + 1]; k++) {
+            int t2 = esquinas_vertice[k] / 3;
+            Vector3 u = cara_unitaria[t2];
+            if (u.x * cara_unitaria[t].x + u.y * cara_unitaria[t].y + u.z * cara_unitaria[t].z < cos_pliegue)
+                continue;
+            suma.x += cara[t2].x;
+            suma.y += cara[t2].y;
+            suma.z += cara[t2].z;
+        }
+
+        float longitud = sqrtf(suma.x * suma.x + suma.y * suma.y + suma.z * suma.z);
+        normales[c] = longitud > 0.0f ? vector3(suma.x / longitud, suma.y / longitud, suma.z / longitud) : cara_unitaria[t];
+    }
+
+    free(cara);
+    free(cara_unitaria);
+    free(esquinas_vertice);
+    free(relleno);
+    free(inicio);
+
+    free(obj->indices);
+    obj->indices = vertice;
+    obj->num_vertices = num_vertices;
+
+    free(obj->normales);
+    free(obj->normales_mundo);
+    obj->normales = normales;
+    obj->normales_mundo = NULL;
+    obj->normales_mptr = NULL;
+    return 0;
+}
+
+/**
+ * Matriz de normales: la inversa traspuesta de la parte 3x3 de la matriz
+ * de modelo. Como las normales se renormalizan después, basta con la
+ * matriz de cofactores (la inversa traspuesta multiplicada por el
+ * determinante), con el signo del determinante para las simetrías.
+ */
+static void matriz_normales(const double* m, float n[9]) {
+    double c[9];
+    c[0] = m[5] * m[10] - m[6] * m[9];
+    c[1] = m[6] * m[8] - m[4] * m[10];
+    c[2] = m[4] * m[9] - m[5] * m[8];
+    c[3] = m[2] * m[9] - m[1] * m[10];
+    c[4] = m[0] * m[10] - m[2] * m[8];
+    c[5] = m[1] * m[8] - m[0] * m[9];
+    c[6] = m[1] * m[6] - m[2] * m[5];
+    c[7] = m[2] * m[4] - m[0] * m[6];
+    c[8] = m[0] * m[5] - m[1] * m[4];
+
+    double det = m[0] * c[0] + m[1] * c[1] + m[2] * c[2];
+    double signo = det < 0.0 ? -1.0 : 1.0;
+    for (int i = 0; i < 9; i++)
+        n[i] = (float)(c[i] * signo);
+}
+
+/**
+ * Devuelve las normales de vértice del objeto en espacio mundo. Sólo se
+ * recalculan si la matriz del objeto ha cambiado desde la última vez
+ * (otro nodo de mlist, o el mismo con otros valores).
+ * @param obj Objeto con normales ya calculadas, o comprimido.
+ * @return Normales en espacio mundo (3 por triángulo), o NULL si el objeto
+ *         no tiene normales o no hay memoria.
+ */
+const Vector3* normales_mundo(triobj* obj) {
+    if (!obj->normales && !obj->compacta)
+        return NULL;
+
+    const double* m = obj->mptr->m;
+    if (obj->normales_mundo && obj->normales_mptr == obj->mptr && memcmp(obj->normales_m, m, sizeof(obj->normales_m)) == 0)
+        return obj->normales_mundo;
+
+    if (!obj->normales_mundo) {
+        obj->normales_mundo = (Vector3*)malloc(sizeof(Vector3) * 3 * (size_t)obj->num_triangles);
+        if (!obj->normales_mundo)
+            return NULL;
+    }
+
+    // Matriz de cofactores, por filas: n' = N * n
+    float n[9];
+    matriz_normales(m, n);
+
+    long esquinas = 3L * obj->num_triangles;
+    for (long c = 0; c < esquinas; c++) {
+        Vector3 v = obj->normales ? obj->normales[c] : normal_octaedrica(obj->compacta->vertices[c].normal);
+        float x = n[0] * v.x + n[1] * v.y + n[2] * v.z;
+        float y = n[3] * v.x + n[4] * v.y + n[5] * v.z;
+        float z = n[6] * v.x + n[7] * v.y + n[8] * v.z;
+        float inv = 1.0f / sqrtf(x * x + y * y + z * z + 1e-30f);
+        obj->normales_mundo[c] = vector3(x * inv, y * inv, z * inv);
+    }
+
+    obj->normales_mptr = obj->mptr;
+    memcpy(obj->normales_m, m, sizeof(obj->normales_m));
+    return obj->normales_mundo;
+}
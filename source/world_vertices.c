@@ -0,0 +1,85 @@
+#include "headers/shared_defines.h"
+#include "headers/functions.h"
+
+/***********************************************************************
+ *                                                                     *
+ *                      VÉRTICES EN ESPACIO MUNDO                      *
+ *                                                                     *
+ ***********************************************************************/
+
+/***********************************************************************
+ * camera_pipeline() aplica la matriz de modelo a cada vértice en cada
+ * frame, aunque lo único que se haya movido sea la cámara, que es lo
+ * normal en los modos de vuelo y de órbita.
+ *
+ * Con VERTICES_MUNDO, cada objeto guarda una copia de sus triángulos ya
+ * en espacio mundo y procesar_objeto() pasa sólo la vista y la proyección
+ * (camera_pipeline_mundo). La copia se rehace cuando cambia la cabeza del
+ * historial de matrices (mptr) o su contenido, igual que las normales en
+ * mundo. Junto a los triángulos se guarda la normal de cada cara en mundo,
+ * con la que rasterizar_vistas() hace el back culling de todas las vistas
+ * sin pasar los triángulos de espaldas por la vista y la proyección.
+ * Cuesta otro array de triángulos y uno de normales por objeto, que
+ * memoria_triobj() cuenta.
+ *
+ * Sólo se guarda para el objeto completo sin comprimir: los niveles de
+ * detalle y las mallas comprimidas siguen por el camino normal (la copia
+ * descomprimida se comería lo que ahorra la compresión).
+ ***********************************************************************/
+
+/**
+ * Devuelve los triángulos del objeto en espacio mundo, recalculándolos
+ * sólo si la matriz del objeto ha cambiado desde la última vez.
+ * @param obj Objeto con triptr.
+ * @return Triángulos en espacio mundo (en el orden de triptr), o NULL si
+ *         el objeto está comprimido o no hay memoria.
+ */
+const Triangulo* triangulos_mundo(triobj* obj) {
+    if (!obj->triptr)
+        return NULL;
+
+    double* m = obj->mptr->m;
+    if (obj->triangulos_mundo && obj->mundo_mptr == obj->mptr && memcmp(obj->mundo_m, m, sizeof(obj->mundo_m)) == 0)
+        return obj->triangulos_mundo;
+
+    if (!obj->triangulos_mundo || !obj->caras_mundo) {
+        free(obj->triangulos_mundo);
+        free(obj->caras_mundo);
+        obj->triangulos_mundo = (Triangulo*)malloc(sizeof(Triangulo) * (size_t)obj->num_triangles);
+        obj->caras_mundo = (Vector3*)malloc(sizeof(Vector3) * (size_t)obj->num_triangles);
+        if (!obj->triangulos_mundo || !obj->caras_mundo) {
+            descartar_triangulos_mundo(obj);
+            return NULL;
+        }
+    }
+
+    for (int t = 0; t < obj->num_triangles; t++) {
+        const Triangulo* tri = &obj->triptr[t];
+        Triangulo* mundo = &obj->triangulos_mundo[t];
+        mxp(&mundo->p1, m, tri->p1);
+        mxp(&mundo->p2, m, tri->p2);
+        mxp(&mundo->p3, m, tri->p3);
+
+        // Como obtain_normal_vector(), pero sin normalizar: sólo se mira el signo.
+        Vector3 a = vector3(mundo->p2.x - mundo->p1.x, mundo->p2.y - mundo->p1.y, mundo->p2.z - mundo->p1.z);
+        Vector3 b = vector3(mundo->p3.x - mundo->p1.x, mundo->p3.y - mundo->p1.y, mundo->p3.z - mundo->p1.z);
+        obj->caras_mundo[t] = vector3_cross_product(a, b);
+    }
+
+    obj->mundo_mptr = obj->mptr;
+    memcpy(obj->mundo_m, m, sizeof(obj->mundo_m));
+    return obj->triangulos_mundo;
+}
+
+/**
+ * Suelta la copia en mundo, para cuando cambian los triángulos del objeto
+ * (reordenado, compresión) o se quiere recuperar la memoria.
+ * @param obj Objeto.
+ */
+void descartar_triangulos_mundo(triobj* obj) {
+    free(obj->triangulos_mundo);
+    free(obj->caras_mundo);
+    obj->triangulos_mundo = NULL;
+    obj->caras_mundo = NULL;
+    obj->mundo_mptr = NULL;
+}